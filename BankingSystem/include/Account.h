@@ -1,43 +1,63 @@
 #pragma once
+#include <cstdint>
 #include <string>
+#include <string_view>
+#include <type_traits>
+#include "Date.h"
+#include "Money.h"
 
+enum class AccountType : std::uint8_t { Checking, Savings, FX, Unknown };
+
+// JSON / display names: "Checking", "Savings", "FX", "Unknown"
+const char* accountTypeName(AccountType t);
+// Anything else -> Unknown. The stored name is kept: DatabaseManager writes it
+// back when such an account is saved again.
+AccountType accountTypeFromName(std::string_view name);
+
+// Plain record, trivially copyable: packs densely in std::vector<Account>.
+// Strings only at the edges (DatabaseManager JSON, UI labels).
 class Account {
 private:
+    Money balance;         // its currency is the account currency (EUR unless FX)
+    double savingsRate;    // Savings
     int id;
-    std::string type;      // "Checking", "Savings", "FX"
-    double balance;
-
-    // Savings
-    double savingsRate;
-    std::string lastSavedDate;
-
-    // FX
-    std::string currency;  // e.g. "USD", "JPY" (only meaningful when type == "FX")
+    Date lastSaved;        // Savings: last interest accrual
+    AccountType type;
 
 public:
     Account();
-    Account(int id, const std::string& type, double balance);
+    Account(int id, AccountType type, Money balance);
+    // Backward-compatible (старые тесты/код): type by name
+    Account(int id, const std::string& type, Money balance);
+    Account(int id, const std::string& type, double balance); // EUR, rounded to cents
 
     int getId() const;
-    std::string getType() const;
-    double getBalance() const;
+    AccountType getType() const;
+    const char* getTypeName() const { return accountTypeName(type); }
+    Money getBalance() const;
 
-    void setBalance(double b);
-    void setType(const std::string& t);
+    void setBalance(Money b);
+    void setType(AccountType t);
 
     // Savings
     double getSavingsRate() const;
     void setSavingsRate(double r);
+    Date getLastSaved() const;
+    void setLastSaved(Date d);
+    // "YYYY-MM-DD" text form (JSON, old code); unreadable text -> no date
     std::string getLastSavedDate() const;
     void setLastSavedDate(const std::string& d);
 
-    // FX
-    std::string getCurrency() const;
-    void setCurrency(const std::string& c);
+    // FX: e.g. USD, JPY (only meaningful for AccountType::FX).
+    // Changing the currency re-labels the balance, it does not convert it.
+    CurrencyCode getCurrency() const;
+    void setCurrency(CurrencyCode c);
 
-    // ops
-    void deposit(double amount);
-    bool withdraw(double amount);
+    // ops (amount must be in the account currency)
+    void deposit(Money amount);
+    bool withdraw(Money amount);
 
     void printInfo() const;
 };
+
+static_assert(std::is_trivially_copyable_v<Account>, "Account must stay a plain record");
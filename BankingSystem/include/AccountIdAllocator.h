@@ -0,0 +1,56 @@
+#pragma once
+#include <cstdint>
+#include <cstddef>
+#include <random>
+#include <unordered_set>
+#include <vector>
+
+// Unique account ids from [100000, 10^digits - 1] (6 digits by default).
+// Used ids are a bitmap split into 4096-id pages with a per-page used count:
+// a page is allocated only once something in it is used, full pages are skipped
+// by their count, and a free id inside a page is found by a 64-word scan.
+// Allocation is O(1) while the space isn't nearly full.
+class AccountIdAllocator {
+public:
+    static constexpr int MIN_DIGITS = 6;
+    static constexpr int MAX_DIGITS = 9;   // must fit in int
+
+private:
+    static constexpr int PAGE_WORDS = 64;
+    static constexpr int PAGE_IDS = PAGE_WORDS * 64;
+    static constexpr int MIN_ID = 100000;
+
+    using Page = std::vector<std::uint64_t>;   // PAGE_WORDS words, 1 = used
+
+    int digits = MIN_DIGITS;
+    int maxId = 999999;
+    std::vector<Page> pages;                    // empty = nothing used yet
+    std::vector<std::uint32_t> pageUsed;
+    std::size_t usedCount = 0;
+
+    std::unordered_set<int> reserved;   // handed out, not stored in the DB yet
+    std::mt19937 rng{ std::random_device{}() };
+
+    int pageCapacity(std::size_t page) const;
+    int takeFromPage(std::size_t page);
+
+public:
+    explicit AccountIdAllocator(int digits = MIN_DIGITS);
+
+    int getDigits() const { return digits; }
+    std::size_t capacity() const { return (std::size_t)(maxId - MIN_ID + 1); }
+    std::size_t freeIds() const { return capacity() - usedCount; }
+    bool inRange(int id) const { return id >= MIN_ID && id <= maxId; }
+
+    // Forget everything except outstanding reservations
+    void reset(int digits);
+    // More digits, same used ids; ignored if not wider
+    void widen(int newDigits);
+
+    void markUsed(int id);      // stored in the DB (also settles a reservation)
+    bool isUsed(int id) const;
+
+    int allocate();                                  // 0 = space full
+    std::vector<int> reserve(std::size_t n);         // all or nothing (empty = not enough room)
+    void release(int id);                            // give back an unused reservation
+};
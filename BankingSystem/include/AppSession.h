@@ -1,19 +1,33 @@
 #pragma once
 #include <string>
 #include <vector>
-#include <unordered_map>
+#include <functional>
+#include <memory>
 
 #include "Customer.h"
 #include "Account.h"
+#include "BankClient.h"
 #include "DatabaseManager.h"
+#include "RateProvider.h"
 
 enum class Page { MainMenu, Login, Create, Forgot, Dashboard };
 
+// Decoded history rows for the current customer + the key they were built for
+struct TransferHistoryCache {
+    std::string customerId;
+    int filter = -1;
+    long long sinceMinute = -1;        // "Today"/"7 days" window moves with the clock
+    std::uint64_t logVersion = 0;
+    std::vector<TransferRecord> rows;  // newest first
+    bool complete = true;              // false: the server stopped answering part-way
+};
+
 // Bottom tabs (inside Dashboard)
 enum class AppTab { Home, Exchange, Transfers, Deals, Settings };
 
-struct AppSession {
-    DatabaseManager db{ "data/database.json" };
+// Per-login state: the customer and every page's inputs. logout() resets it
+// wholesale; the database and shared services live in AppSession itself.
+struct SessionState {
     Page page = Page::MainMenu;
 
     // Logged in
@@ -26,7 +40,6 @@ struct AppSession {
     // Toast
     std::string toast;
     double toast_t = 0.0;
-    void ShowToast(const std::string& msg);
 
     // --- Login ---
     std::string loginId;
@@ -56,29 +69,92 @@ struct AppSession {
     int trFromIdx = -1;
     int trDestAccId = 0;
     std::string trFirstName, trLastName;
+    std::vector<std::string> trNameMatches;   // namesakes for trFirstName/trLastName
+    std::string trNameKey;                    // names trNameMatches was looked up for
+    int trNamePick = 0;
     double trAmount = 0.0;
     int trHistoryFilter = 1; // 0=Today, 1=7 days, 2=All
+    TransferHistoryCache trHistory;
 
     // --- Exchange ---
     double exAmount = 0.0;
     int exTargetIdx = 0;  // index in list
     int exDirection = 0;  // 0=Buy (EUR->FX), 1=Sell (FX->EUR)
+};
+
+struct AppSession : SessionState {
+    static constexpr double TOAST_SECONDS = 4.0;   // how long a toast stays on screen
+
+    static constexpr const char* DB_PATH = "data/database.json";   // file, or a banking_shard directory
+    static DatabaseOptions databaseOptions();
+
+    // Thin-client mode: BANKING_SERVER=host[:port] (default port 7878). Login,
+    // balances, deposits, withdrawals, transfers and history then go to a
+    // banking_server and the local database is not opened (db is null).
+    // Sign-up, secret reset / change and FX need the local database.
+    static constexpr int DEFAULT_SERVER_PORT = 7878;
+    static std::string serverFromEnv();
+    static std::unique_ptr<DatabaseManager> openDatabase(const std::string& serverAddress);
+    std::string serverAddress = serverFromEnv();
+    std::unique_ptr<DatabaseManager> db = openDatabase(serverAddress);
+    BankClient server;
+    json serverLogin;                 // thin client: last successful login, re-sent on a new connection
+    std::uint64_t serverLogGen = 1;   // thin client: bumped by own transfers / "Refresh"
+
+    // Background FX rates (EUR base); started on first visit to Exchange.
+    // Source: BANKING_FX_SOURCE env ("curl" | "file:<path>" | "replay:<path>")
+    std::shared_ptr<RateService> rateService;
+
+    // Idle UI: the main loop sleeps in glfwWaitEventsTimeout between events.
+    // wakeUi (set by main, callable from any thread) cuts the sleep short;
+    // background jobs whose result is on screen call it when they finish.
+    bool powerSave = true;
+    std::function<void()> wakeUi;
+
+    void ShowToast(const std::string& msg);
 
-    std::unordered_map<std::string, double> exRates; // currency -> rate (EUR base)
-    std::string exLastError;
-    double exLastFetchT = -1.0;
-    double exNextPollT  = 0.0;
+    // Saves the current customer, waits until it is on disk and resets SessionState
+    void logout();
+
+    // --- Backend: the local database, or the server in thin-client mode ---
+    bool remote() const { return !db; }
+    // One request; a transport error comes back as { "ok": false, "error": ... }
+    // and the next call reconnects (requests are never re-sent). The server
+    // ties a login to its connection, so a reconnect logs in again first.
+    json serverCall(json request);
+    static Customer customerFromJson(const json& j);   // BankService "customer" object
+
+    bool loadCustomer(const std::string& id, Customer& out);
+    bool reloadCurrent();
+    std::vector<std::string> findCustomersByName(const std::string& firstName, const std::string& lastName);
+    // Account a transfer by name credits (Customer::incomingAccount)
+    bool recipientAccount(const std::string& customerId, int& accId, CurrencyCode& currency, std::string& error);
+    bool depositOrWithdraw(bool deposit, int accId, const Money& amount, std::string& error);
+    // logEntry: fromCustomerId / mode / target. A failed transfer is logged as
+    // "failed" in both modes (the server does it itself).
+    bool transfer(int fromAccId, int toAccId, const Money& amount, const json& logEntry, std::string& error);
+    // A transfer refused before it was sent (bad amount, unknown recipient, ...):
+    // logEntry is a complete "failed" entry
+    void logFailedTransfer(const json& logEntry);
+    // Whole window, newest first; the server is read page by page. complete
+    // (optional) is false when a page could not be fetched (rows so far returned).
+    std::vector<TransferRecord> transferHistory(const std::string& customerId, int daysBack,
+                                                bool* complete = nullptr);
+    std::uint64_t transfersVersion();   // changes whenever transferHistory() may return something new
 
     // --- Helpers ---
     static bool validateID(const std::string& id);
     static bool validateEmail(const std::string& email);
     static bool validatePhone(const std::string& phone);
 
-    static std::string todayDate();
-    static int daysBetween(const std::string& fromDate, const std::string& toDate);
+    static Date todayDate();   // local calendar day
     static int findAccountIndexById(const std::vector<Account>& accounts, int accId);
 
-    void applySavingsInterestIfNeeded(Customer& cust);
+    // balance * rate * days / 365, banker's rounding. While that is under half a
+    // cent the account keeps its date, so the days add up instead of being lost.
+    // Login credits interest through DatabaseManager::accrueCustomerInterest
+    // (same rule); this one works on a Customer in memory.
+    static void applySavingsInterest(Customer& cust, Date today);
 
     // FX helpers
     int findCheckingIndex() const;
@@ -0,0 +1,31 @@
+#pragma once
+#include <string>
+
+#include "nlohmann/json.hpp"
+
+using json = nlohmann::json;
+
+// Blocking client of the banking server: one JSON object per line each way
+// (see BankService.h for the ops). Not thread-safe; use one per thread.
+class BankClient {
+public:
+    BankClient() = default;
+    ~BankClient();
+
+    BankClient(const BankClient&) = delete;
+    BankClient& operator=(const BankClient&) = delete;
+
+    bool connect(const std::string& host, int port, std::string* error = nullptr);
+    void close();
+    bool connected() const { return fd >= 0; }
+
+    // Sends the request (an "id" is added) and waits for its response.
+    // false on a transport error; the server's own errors come back as
+    // { "ok": false, "error": ... } with true.
+    bool call(json request, json& response);
+
+private:
+    int fd = -1;
+    long long nextId = 1;
+    std::string inbuf;
+};
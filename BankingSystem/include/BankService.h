@@ -0,0 +1,67 @@
+#pragma once
+#include <string>
+#include <vector>
+
+#include "DatabaseManager.h"
+#include "nlohmann/json.hpp"
+
+using json = nlohmann::json;
+
+// Request dispatcher of the banking server, independent of the transport.
+// One request / response is one JSON object:
+//
+//   -> { "id": 7, "op": "transfer", "fromAccId": 100123, "toAccId": 100456, "amount": "12.50" }
+//   <- { "id": 7, "ok": true }                      or  { "id": 7, "ok": false, "error": "..." }
+//
+// ops: ping, login {customerId, secret[, phone]}, customer {customerId},
+//      deposit / withdraw {accId, amount}, transfer {fromAccId, toAccId, amount[, mode, target]},
+//      history {customerId[, days, limit, cursor]} (newest first, at most 1000 per page;
+//      pass nextCursor back while hasMore), findByName {firstName, lastName},
+//      recipient {customerId} (the account a transfer by name credits: accId, currency),
+//      logFailure {fromAccId, amount, mode, target, error} (a transfer the client refused
+//      before sending it, logged as "failed" like the ones the server refuses)
+// Amounts: decimal string in the account's currency ("12.50"), or "amountMinor".
+//
+// Requests run in a Session (one per connection). Until a login succeeds on it
+// only ping / login are accepted ("Not logged in."). After that withdraw /
+// transfer need a source account of the logged-in customer, and customer /
+// history only show that customer ("Access denied."); customerId may be left
+// out there. Deposits may go to any existing account.
+//
+// Safe to call from many threads at once: deposit / withdraw / transfer move
+// money in DatabaseManager's Ledger under the locks of the accounts involved
+// only (funds checked there), so tellers on different accounts don't wait for
+// each other; the database lock is held just to write the result back. With
+// group commit enabled a mutation is answered once it is on disk.
+class BankService {
+public:
+    // Who is logged in on a connection. The server runs one request of a
+    // connection at a time, so a session is never shared between threads
+    // while it changes (login).
+    struct Session {
+        std::string customerId;   // "" = nobody
+        std::vector<int> accIds;  // the customer's accounts as of login
+    };
+
+    explicit BankService(DatabaseManager& db) : db(db) {}
+
+    json handle(const json& request, Session& session);
+    std::string handleLine(const std::string& line, Session& session);   // JSON text in, JSON text out (no '\n')
+
+private:
+    DatabaseManager& db;
+
+    json customer(const json& req, const Session& s);
+    json login(const json& req, Session& s);
+    json depositOrWithdraw(const json& req, const Session& s, bool deposit);
+    json transfer(const json& req, const Session& s);
+    json history(const json& req, const Session& s);
+    json findByName(const json& req);
+    json recipient(const json& req);
+    json logFailure(const json& req, const Session& s);
+
+    void logFailed(const Session& s, int fromAccId, const Money& amount, json entry, const std::string& err);
+
+    bool owns(const Session& s, int accId);
+    bool durable();
+};
@@ -0,0 +1,70 @@
+#pragma once
+#include <string>
+#include <istream>
+#include <ostream>
+#include <cstddef>
+
+#include "DatabaseManager.h"
+#include "Money.h"
+
+enum class BatchFormat {
+    Csv,        // op,account,amount,to_account,currency,ref (header line optional)
+    JsonLines   // {"op":"transfer","account":1,"to":2,"amount":"10.50","currency":"EUR","ref":"x"}
+};
+
+// One input operation
+struct BatchOp {
+    std::size_t line = 0;
+    std::string op;          // "deposit" / "withdraw" / "transfer"
+    int accId = 0;           // deposit/withdraw target, transfer source
+    int toAccId = 0;         // transfer only
+    std::string amount;      // decimal text, read exactly in the account currency
+    std::string currency;    // optional; must match the account(s) if given
+    std::string ref;         // caller's reference, echoed into the result
+};
+
+struct BatchResult {
+    std::size_t line = 0;
+    std::string op, ref;
+    bool ok = false;
+    std::string error;
+    Money balanceAfter;      // source account after the op (ok only)
+};
+
+struct BatchStats {
+    std::size_t ops = 0, ok = 0, failed = 0, batches = 0;
+    double applyMs = 0.0, persistMs = 0.0, totalMs = 0.0;
+
+    double opsPerSec() const { return totalMs > 0.0 ? (double)ops * 1000.0 / totalMs : 0.0; }
+};
+
+// Applies deposits / withdrawals / transfers through Customer, Account and
+// DatabaseManager, without the UI. Every `batchSize` ops (0 = whole input) run
+// inside one DatabaseManager batch and are persisted once. A failing op is
+// reported and skipped, it does not abort the rest of the batch.
+class BatchProcessor {
+private:
+    DatabaseManager& db;
+
+    BatchResult deposit(const BatchOp& op, bool withdraw);
+    BatchResult transfer(const BatchOp& op);
+    void logTransfer(const BatchOp& op, const std::string& fromCustomerId,
+                     const std::string& toCustomerId, const Money& amount,
+                     const std::string& error);
+
+public:
+    explicit BatchProcessor(DatabaseManager& db);
+
+    // false + empty error = nothing to do (blank line, comment, CSV header)
+    static bool parseLine(const std::string& line, BatchFormat format,
+                          BatchOp& out, std::string& outError);
+
+    BatchResult apply(const BatchOp& op);
+
+    // results: CSV "line,op,ref,status,balance,error", one row per input op
+    static void writeResultHeader(std::ostream& out);
+    static void writeResult(std::ostream& out, const BatchResult& r);
+
+    bool run(std::istream& in, BatchFormat format, std::ostream& results,
+             std::size_t batchSize, BatchStats& stats);
+};
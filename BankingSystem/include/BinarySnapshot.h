@@ -0,0 +1,37 @@
+#pragma once
+#include <string>
+#include <cstdint>
+
+#include "nlohmann/json.hpp"
+
+using json = nlohmann::json;
+
+// Identity of the JSON file a binary snapshot was produced from
+struct SnapshotSource {
+    std::uint64_t size = 0;
+    long long mtimeNs = 0;
+    unsigned long long inode = 0;
+
+    bool operator==(const SnapshotSource& o) const {
+        return size == o.size && mtimeNs == o.mtimeNs && inode == o.inode;
+    }
+};
+
+// Columnar binary image of a normalized database:
+//   header | string pool | customer columns | account columns | transfer columns
+// Strings (ids, names, statuses, ...) are interned into one pool and referenced
+// by index; numbers are stored in fixed-width arrays, so loading is a bounds
+// check + memcpy per field instead of a text parse. The file is read via mmap.
+// Keys the columns don't know about travel as compact JSON in an "extra" string,
+// so JSON -> snapshot -> JSON is lossless.
+class BinarySnapshot {
+public:
+    // false if the document can't be represented (e.g. non-object records);
+    // nothing is written then.
+    static bool write(const json& root, const SnapshotSource& source, const std::string& path);
+
+    // Reads only the header; false if missing / not a snapshot
+    static bool readSource(const std::string& path, SnapshotSource& outSource);
+
+    static bool read(const std::string& path, json& outRoot);
+};
@@ -14,44 +14,53 @@ private:
     std::string phone;
     std::vector<Account> accounts;
 
+    std::string fullName;   // cached "first last", rebuilt by the name setters
+    void rebuildFullName();
+
 public:
     Customer();
 
+    // Strings are taken by value and moved in: pass temporaries / std::move
+    // to avoid a copy.
     // Backward-compatible (старые тесты/код)
-    Customer(const std::string& firstName, const std::string& lastName,
-             int age, const std::string& email,
-             const std::string& id, const std::string& secretWord);
+    Customer(std::string firstName, std::string lastName,
+             int age, std::string email,
+             std::string id, std::string secretWord);
 
     // Main
-    Customer(const std::string& firstName, const std::string& lastName,
-             int age, const std::string& email,
-             const std::string& id, const std::string& secretWord,
-             const std::string& phone);
-
-    // Getters
-    std::string getFirstName() const;
-    std::string getLastName() const;
-    std::string getFullName() const;
-
-    int getAge() const;
-    std::string getEmail() const;
-    std::string getId() const;
-    std::string getSecretWord() const;
-    std::string getPhone() const;
+    Customer(std::string firstName, std::string lastName,
+             int age, std::string email,
+             std::string id, std::string secretWord,
+             std::string phone);
+
+    // Getters: references into the customer, no copies (valid until the
+    // customer is changed or destroyed)
+    const std::string& getFirstName() const { return firstName; }
+    const std::string& getLastName() const { return lastName; }
+    const std::string& getFullName() const { return fullName; }
+
+    int getAge() const { return age; }
+    const std::string& getEmail() const { return email; }
+    const std::string& getId() const { return id; }
+    const std::string& getSecretWord() const { return secretWord; }
+    const std::string& getPhone() const { return phone; }
 
     // Setters
-    void setFirstName(const std::string& fn);
-    void setLastName(const std::string& ln);
+    void setFirstName(std::string fn);
+    void setLastName(std::string ln);
     void setAge(int a);
-    void setEmail(const std::string& e);
-    void setId(const std::string& i);
-    void setSecretWord(const std::string& s);
-    void setPhone(const std::string& p);
+    void setEmail(std::string e);
+    void setId(std::string i);
+    void setSecretWord(std::string s);
+    void setPhone(std::string p);
 
     // Accounts
-    void addAccount(const Account& acc);
+    void addAccount(const Account& acc);   // Account is a plain record: copy is a memcpy
     std::vector<Account>& getAccounts();
     const std::vector<Account>& getAccounts() const;
+    // The account a transfer "by name" credits: the first Checking, else the
+    // first account; nullptr when there is none
+    const Account* incomingAccount() const;
 
     void printInfo() const;
 };
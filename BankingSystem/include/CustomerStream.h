@@ -0,0 +1,17 @@
+#pragma once
+#include <string>
+
+#include "Customer.h"
+
+// Reads one customer straight from a database file (JSON, CBOR or MessagePack)
+// with a SAX parser instead of building the whole document: other customers
+// and the transfers log are skipped as they stream past, and parsing stops as
+// soon as the customer is complete. Memory stays at about one customer
+// whatever the file size.
+//
+// Both layouts are understood: { "customers": { "<id>": {...} }, ... } and the
+// legacy one where the root itself is the map of customers.
+// false + error: "Customer not found." (the whole file was read) or
+// "Cannot read database file." (missing / malformed before the customer).
+bool streamLoadCustomer(const std::string& path, const std::string& id, Customer& out,
+                        std::string* error = nullptr);
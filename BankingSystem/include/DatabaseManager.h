@@ -1,17 +1,199 @@
 #pragma once
 #include <string>
 #include <vector>
+#include <atomic>
+#include <cstdint>
+#include <deque>
+#include <future>
+#include <memory>
+#include <mutex>
+#include <unordered_map>
 
 #include "Customer.h"
 #include "Account.h"
+#include "WriteAheadLog.h"
+#include "BinarySnapshot.h"
+#include "AccountIdAllocator.h"
+#include "DbFormat.h"
+#include "GroupCommitter.h"
+#include "ShardedStore.h"
+#include "InterestAccrual.h"
+#include "Ledger.h"
 #include "nlohmann/json.hpp"
 
 using json = nlohmann::json;
 
+enum class StorageMode {
+    Snapshot,       // every mutation rewrites the whole file (+ .bak)
+    WriteAheadLog,  // mutations are appended to <file>.wal, snapshot every N records / bytes
+    Sharded         // the file name is a directory: customer shards + transfer log segments
+                    // + manifest (ShardedStore.h); a mutation rewrites only its shards
+};
+
+struct DatabaseOptions {
+    // Keep the parsed database in memory, serve reads from it and write through
+    // on mutation. The file is re-read only when it changed on disk.
+    // false = legacy behaviour (re-read the file on every call).
+    bool resident = true;
+
+    StorageMode mode = StorageMode::Snapshot;
+    // WAL mode: fold the journal into a fresh snapshot once either limit is hit
+    std::size_t walCheckpointRecords = 1000;
+    std::uintmax_t walCheckpointBytes = 4u * 1024 * 1024;
+
+    // Sharded mode: number of customer shards and transfer segment size for a new
+    // directory (an existing one keeps what its manifest says)
+    std::size_t shardCount = ShardedStore::DEFAULT_SHARDS;
+    std::uintmax_t transferSegmentBytes = ShardedStore::DEFAULT_SEGMENT_BYTES;
+
+    // Keep a binary columnar copy (<file>.snap) next to every JSON snapshot and
+    // start from it while it still matches the JSON file. JSON stays authoritative.
+    // Not used in Sharded mode.
+    bool binarySnapshot = false;
+
+    // Account id width. 0 = whatever the file says (6 for a new DB); a larger
+    // value widens the id space and is stored in the file ("meta").
+    int accountIdDigits = 0;
+
+    // Encoding the snapshot is written in (Auto = by extension: .cbor / .msgpack,
+    // otherwise JSON). Loading always detects the encoding from the content.
+    // The WAL stays JSON lines.
+    FileFormat format = FileFormat::Auto;
+
+    // Group commit: mutations return as soon as the image is updated and a
+    // background thread writes them, one write per window (whichever of
+    // ms / ops comes first). durable() / flush() tell when they are on disk (fsynced).
+    // 0 ms = write-through (every mutation is on disk before it returns).
+    int commitWindowMs = 0;
+    std::size_t commitWindowOps = 256;
+};
+
+// Where an account lives: owner + index in the owner's "accounts" array
+struct AccountLocation {
+    std::string customerId;
+    int slot = -1;
+};
+
+// One entry of the global transfers log, decoded
+struct TransferRecord {
+    long long ts = 0;                 // epoch ms
+    std::string status;               // "ok" / "failed"
+    std::string mode;                 // "by_account_id" / "by_name"
+    std::string fromCustomerId, toCustomerId;
+    int fromAccId = 0, toAccId = 0;
+    Money amount;                     // EUR
+    std::string target, error;
+};
+
+struct TransferPage {
+    std::vector<TransferRecord> items;   // newest first
+    std::size_t nextCursor = 0;          // pass back to get the next (older) page
+    bool hasMore = false;
+};
+
 class DatabaseManager {
 private:
     std::string filename;
+    DatabaseOptions options;
+
+    // Identity of the file the resident image was read from / written to
+    struct FileStamp {
+        bool exists = false;
+        std::uintmax_t size = 0;
+        long long mtimeNs = 0;
+        long long ctimeNs = 0;
+        unsigned long long inode = 0;
+
+        bool operator==(const FileStamp& o) const {
+            return exists == o.exists && size == o.size && mtimeNs == o.mtimeNs &&
+                   ctimeNs == o.ctimeNs && inode == o.inode;
+        }
+        bool operator!=(const FileStamp& o) const { return !(*this == o); }
+    };
+
+    // Resident image (always normalized: { "customers": {...}, "transfers": [...] })
+    json image;
+    bool imageLoaded = false;
+    FileStamp imageStamp;
+
+    // WAL mode: journal next to the snapshot, seq of the last record in image
+    WriteAheadLog wal;
+    FileStamp walStamp;
+    long long walSeq = 0;
+
+    // Sharded mode: the directory; tracks which shards the next write touches
+    std::unique_ptr<ShardedStore> shards;
+
+    // beginBatch(): mutations stay in the image until commitBatch()
+    bool batching = false;
+    bool batchDirty = false;
+
+    // Group commit: image + indexes are shared with the writer thread.
+    // Recursive: public methods call each other.
+    mutable std::recursive_mutex mtx;
+    std::vector<json> pendingWal;    // journal records not yet appended
+    bool pendingSnapshot = false;    // image must be written as a whole
+    bool persisting = false;         // writer thread is appending outside the lock
 
+    // Indexes over image (rebuilt on every reload, kept in sync on mutation)
+    std::unordered_map<int, AccountLocation> accountIndex;
+    // Free/used account ids (accounts + ids seen in the transfers log, never reused)
+    AccountIdAllocator accountIds;
+    // "first\x1flast" (trimmed, lowercased) -> customer ids, ascending
+    std::unordered_map<std::string, std::vector<std::string>> nameIndex;
+
+    // customerId -> positions in image["transfers"], ascending by ts
+    struct TransferRef {
+        long long ts = 0;
+        std::size_t offset = 0;
+    };
+    std::unordered_map<std::string, std::vector<TransferRef>> transferIndex;
+    std::uint64_t transferGen = 0;   // bumps whenever the indexed log changes
+
+    // Balance owner: image balances + postings not yet written back. Reset from
+    // the image on every reload, follows every other balance change by difference.
+    Ledger ledger;
+    std::atomic<bool> ledgerLoaded{ false };   // first image is in (checked without mtx)
+
+    // Postings done on the ledger but not yet in the image, in ledger order.
+    // Lock order: mtx -> ledger stripes -> postMtx.
+    struct Posted {
+        std::vector<Ledger::Leg> legs;
+        std::vector<json> entries;       // transfers log entries that go with it
+        std::shared_ptr<int> state;      // 0 waiting, 1 written back, -1 dropped (read under mtx)
+    };
+    std::mutex postMtx;
+    std::deque<Posted> parked;
+
+    static FileStamp stampOf(const std::string& path);
+    // File whose stamp tells whether the database changed (the manifest when sharded)
+    std::string stampPath() const { return shards ? shards->manifestPath() : filename; }
+
+    void rebuildIndexes();
+    void indexCustomer(const std::string& id, const json& cust);
+    void unindexCustomer(const std::string& id, const json& cust);
+    void indexTransfer(std::size_t offset);
+
+    bool readFromDisk(json& outJson);
+    bool writeToDisk(const json& j);
+    FileFormat writeFormat() const;
+    std::string binarySnapshotPath() const { return filename + ".snap"; }
+    bool readBinarySnapshot(json& outJson);
+    void writeBinarySnapshot(const json& j);
+    void replayWal(json& root);
+    bool refreshImage();                   // loadImage() + write back parked postings
+    bool loadImage();                      // reload only if the files changed outside of us
+    bool writeBackPostings();              // parked postings -> image + journal, in order
+    void dropParked();                     // image unavailable: parked postings are lost
+    bool hasParked();
+    void mirrorLedger(const json* oldCust, const json* newCust);   // DB-side change -> ledger
+    bool post(std::vector<Ledger::Leg> legs, std::vector<json> entries,
+              std::string* error, std::vector<Money>* after = nullptr);
+    bool commitImage(json walRecord);      // write-through after an in-place mutation of image
+    bool checkpointImage();                // image -> snapshot, then truncate the WAL
+    bool persistImage();                   // checkpointImage() now or on the next commit window
+    bool persistPending();                 // writer thread: one commit window
+    bool hasUnpersisted() const { return !pendingWal.empty() || pendingSnapshot || persisting; }
 
     // Compatibility layer:
     // old style DB: { "123": {...}, "456": {...} }
@@ -20,11 +202,32 @@ private:
     static const json& customersRefConst(const json& root);
 
 public:
-    explicit DatabaseManager(const std::string& filename = "data/database.json");
+    explicit DatabaseManager(const std::string& filename = "data/database.json",
+                             const DatabaseOptions& options = DatabaseOptions());
+    ~DatabaseManager();   // flushes queued mutations
+
+    DatabaseManager(const DatabaseManager&) = delete;
+    DatabaseManager& operator=(const DatabaseManager&) = delete;
 
     // Storage
-    bool loadAll(json& outJson);
-    bool saveAll(const json& j);
+    bool loadAll(json& outJson);   // copy of the (normalized) database
+    bool saveAll(const json& j);   // full snapshot (WAL mode: also truncates the journal)
+    bool checkpoint();             // fold the WAL into the snapshot now
+    void invalidateCache();        // force a re-read on next access (after a flush())
+
+    // Group commit (commitWindowMs > 0); without it both are ready at once.
+    std::shared_future<bool> durable();   // everything mutated so far is on disk
+    bool flush();                         // write the open window now and wait for it
+    std::uint64_t commitCount() const;    // windows written so far (0 without group commit)
+
+    // Batch: every mutation until commitBatch() only touches the in-memory image
+    // (no journal record, no file write); commitBatch() persists them all with a
+    // single snapshot, rollbackBatch() drops them by re-reading the files.
+    // Outside changes to the files are not picked up while a batch is open.
+    bool beginBatch();
+    bool commitBatch();
+    void rollbackBatch();
+    bool inBatch() const { return batching; }
 
     // Customers
     bool customerExists(const std::string& id);
@@ -37,16 +240,98 @@ public:
     bool changeSecret(const std::string& id, const std::string& oldSecret, const std::string& newSecret);
     bool resetSecretWithEmail(const std::string& id, const std::string& email, const std::string& newSecret);
 
-    // IMPORTANT: now uses firstName + lastName
+    // IMPORTANT: now uses firstName + lastName (case/space-insensitive).
+    // Namesakes: returns the smallest id, use findCustomersByName() to see all.
     bool findCustomerByName(const std::string& firstName,
                             const std::string& lastName,
                             std::string& outId);
+    std::vector<std::string> findCustomersByName(const std::string& firstName,
+                                                 const std::string& lastName);
 
     // Transfers log (global)
     bool appendTransferLog(const json& entry);
     std::vector<json> getTransfersForCustomer(const std::string& customerId, int daysBack /*0=all*/);
 
-    // Helpers
+    // Newest-first page of the customer's transfers with ts >= sinceTs (0 = all).
+    // Served from a per-customer index: O(limit) per call.
+    TransferPage queryTransfers(const std::string& customerId, long long sinceTs,
+                                std::size_t limit, std::size_t cursor = 0);
+    static long long sinceTsForDaysBack(int daysBack /*0=all*/);
+    // Changes whenever the transfers log changes (append, reload): cache key for views
+    std::uint64_t transfersVersion();
+
+    // Accounts
+    bool findAccountOwner(int accId, AccountLocation& out);
+
+    // Multi-record update: stage balance changes, customer records and log
+    // entries across any customers, then commit() applies all of them or none.
+    // Persisted as one journal record (WAL) / one snapshot write, so a crash
+    // never leaves half of it on disk.
+    class Transaction {
+    public:
+        Transaction& credit(int accId, const Money& amount);
+        Transaction& debit(int accId, const Money& amount);   // fails the commit if funds are short
+        Transaction& putCustomer(const Customer& customer);
+        Transaction& log(const json& transferEntry);           // "ts" added if missing
+
+        // Steps run in staging order against the current image; the first one
+        // that fails ("Insufficient funds.", ...) aborts the whole transaction.
+        bool commit(std::string* error = nullptr);
+        bool empty() const { return steps.empty(); }
+
+    private:
+        friend class DatabaseManager;
+        explicit Transaction(DatabaseManager& db) : db(&db) {}
+
+        struct Step {
+            enum Kind { Credit, Debit, Put, Log } kind = Credit;
+            int accId = 0;
+            Money amount;
+            json data;
+        };
+        DatabaseManager* db;
+        std::vector<Step> steps;
+    };
+    Transaction beginTransaction() { return Transaction(*this); }
+
+    // Debit + credit + "ok" log entry in one transaction. logEntry may carry
+    // extra fields (mode, target); ids, amount and status are filled in.
+    bool transfer(int fromAccId, int toAccId, const Money& amount,
+                  json logEntry = json::object(), std::string* error = nullptr);
+
+    // Balances live in a Ledger (per-account lock stripes). deposit / withdraw /
+    // transfer and Transactions made only of credit / debit / log steps move the
+    // money there without the database lock; the lock is then taken only to write
+    // the posting back into the image and the journal (one record per posting, in
+    // ledger order). With group commit, durable() tells when that is on disk.
+    // Errors as Ledger ("Insufficient funds.", ...); balanceAfter = new balance.
+    bool deposit(int accId, const Money& amount, std::string* error = nullptr, Money* balanceAfter = nullptr);
+    bool withdraw(int accId, const Money& amount, std::string* error = nullptr, Money* balanceAfter = nullptr);
+    bool readBalance(int accId, Money& out);   // from the ledger, no database lock
+
+    // Account ids. An id handed out here is never handed out again in this
+    // process, even before the account is saved; the space widens by one digit
+    // when it runs full.
     int generateUniqueAccountId();
+    std::vector<int> reserveAccountIds(std::size_t count);   // e.g. Checking + Savings at sign-up
+    void releaseAccountId(int accId);                        // reserved but not used after all
+    bool setAccountIdDigits(int digits);                     // widen only, persisted
+    int accountIdDigits() const { return accountIds.getDigits(); }
+
+    // End-of-day job: interest on every Savings account up to `today`,
+    // computed in parallel over a compact copy of the accounts and persisted
+    // as one snapshot write. false = no date given / nothing saved.
+    bool accrueSavingsInterest(Date today, AccrualReport& report, std::size_t threads = 0);
+    // The same for one customer's accounts, as a login does (app and server
+    // alike). credited (optional): interest added, EUR. false = no such
+    // customer / no date / not saved.
+    bool accrueCustomerInterest(const std::string& id, Date today, Money* credited = nullptr);
+
+    // Helpers
     std::vector<int> existingAccountIds();
+    std::vector<std::pair<int, Money>> accountBalances();   // every account, one pass
+
+private:
+    // Last member: the writer thread stops before the state it persists goes away
+    std::unique_ptr<GroupCommitter> committer;
 };
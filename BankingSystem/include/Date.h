@@ -0,0 +1,45 @@
+#pragma once
+#include <cstdint>
+#include <limits>
+#include <string>
+#include <string_view>
+
+// Calendar date stored as a day number (days since 1970-01-01, proleptic
+// Gregorian), 4 bytes, trivially copyable. No time of day and no time zone:
+// the distance between two dates is an integer subtraction, so DST changes
+// can't turn a day into 23 hours. "YYYY-MM-DD" only at the edges (JSON, UI).
+class Date {
+private:
+    static constexpr std::int32_t NONE = std::numeric_limits<std::int32_t>::min();
+    std::int32_t days;
+
+    constexpr explicit Date(std::int32_t d) : days(d) {}
+
+public:
+    constexpr Date() : days(NONE) {}   // "no date" (e.g. a Savings account never accrued)
+
+    static constexpr Date fromDays(std::int32_t dayNumber) { return Date(dayNumber); }
+    // m 1..12, d 1..31; not validated (use parse() for input)
+    static Date fromCivil(int y, unsigned m, unsigned d);
+    // Strict "YYYY-MM-DD" with a real calendar day; false on anything else
+    static bool parse(std::string_view iso, Date& out);
+    // Same, but unreadable / empty text -> no date
+    static Date fromIso(std::string_view iso);
+    static Date today();               // local calendar date
+
+    bool empty() const { return days == NONE; }
+    std::int32_t dayNumber() const { return days; }
+    void toCivil(int& y, unsigned& m, unsigned& d) const;
+    std::string iso() const;           // "YYYY-MM-DD", "" for no date
+
+    Date operator+(int n) const { return Date(days + n); }
+    Date operator-(int n) const { return Date(days - n); }
+    int operator-(Date o) const { return days - o.days; }
+
+    bool operator==(Date o) const { return days == o.days; }
+    bool operator!=(Date o) const { return days != o.days; }
+    bool operator<(Date o) const  { return days < o.days; }
+    bool operator<=(Date o) const { return days <= o.days; }
+    bool operator>(Date o) const  { return days > o.days; }
+    bool operator>=(Date o) const { return days >= o.days; }
+};
@@ -0,0 +1,28 @@
+#pragma once
+#include <string>
+
+#include "nlohmann/json.hpp"
+
+using json = nlohmann::json;
+
+// On-disk encoding of the database document. All three carry the same
+// logical document; only the bytes differ.
+enum class FileFormat {
+    Auto,      // by file extension when writing, by content when reading
+    Json,      // pretty-printed text (default)
+    Cbor,      // RFC 8949, nlohmann::json::to_cbor
+    MsgPack    // nlohmann::json::to_msgpack
+};
+
+// ".cbor" -> Cbor, ".msgpack" / ".mpk" -> MsgPack, anything else -> Json
+FileFormat formatFromPath(const std::string& path);
+// Looks at the first significant byte; Json for anything that isn't a binary map
+FileFormat detectFormat(const std::string& bytes);
+
+const char* formatName(FileFormat f);
+bool parseFormatName(const std::string& name, FileFormat& out);   // "json" / "cbor" / "msgpack"
+
+// format == Auto is treated as Json
+std::string encodeDocument(const json& doc, FileFormat format);
+// Auto-detects the encoding; false on malformed input
+bool decodeDocument(const std::string& bytes, json& out, FileFormat* detected = nullptr);
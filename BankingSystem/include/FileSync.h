@@ -0,0 +1,18 @@
+#pragma once
+#include <string>
+
+// Writes that are on stable storage when they return true, not just handed to
+// the OS: write() + fsync (F_FULLFSYNC on macOS, where fsync stops at the drive
+// cache). Without POSIX they fall back to a flushed std::ofstream.
+
+// Writes bytes to path (append or truncate) and syncs the file. A file that
+// append creates also gets its directory synced, so a new journal / log segment
+// can't vanish with the next power loss. Truncating writes are for tmp files:
+// the caller renames them and then calls syncDir().
+bool writeFileSynced(const std::string& path, const std::string& bytes, bool append);
+
+// Makes creates / renames / removes inside dir durable ("" = current directory)
+bool syncDir(const std::string& dir);
+
+// Directory part of a file path, for syncDir()
+std::string parentDirOf(const std::string& path);
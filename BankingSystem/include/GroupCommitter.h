@@ -0,0 +1,67 @@
+#pragma once
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <functional>
+#include <future>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+// When a queued mutation is written at the latest
+struct CommitWindow {
+    int ms = 50;               // after the first queued mutation
+    std::size_t ops = 256;     // or as soon as this many are queued
+};
+
+// Background writer for group commit: callers notify() after queuing a mutation
+// in memory; the worker calls persist() once per commit window, so N mutations
+// inside one window cost one write. durable() / flush() report when everything
+// notified so far has been persisted.
+class GroupCommitter {
+public:
+    using Persist = std::function<bool()>;   // writes whatever is queued now
+
+    GroupCommitter(Persist persist, CommitWindow window);
+    ~GroupCommitter();                        // persists what is left, then joins
+
+    GroupCommitter(const GroupCommitter&) = delete;
+    GroupCommitter& operator=(const GroupCommitter&) = delete;
+
+    void notify();                            // one more mutation is queued
+
+    // Resolves with persist()'s result once every mutation notified before the
+    // call is on disk (at once, with true, if nothing is pending).
+    std::shared_future<bool> durable();
+    // Starts the pending window now and waits for it
+    bool flush();
+
+    std::uint64_t commits() const;            // persist() calls so far
+
+private:
+    using Clock = std::chrono::steady_clock;
+
+    struct Waiter {
+        std::uint64_t gen = 0;
+        std::promise<bool> done;
+        std::shared_future<bool> future;
+    };
+
+    void run();
+
+    Persist persist;
+    CommitWindow window;
+
+    mutable std::mutex m;
+    std::condition_variable cv;
+    std::uint64_t queued = 0;    // notify() count
+    std::uint64_t taken = 0;     // covered by the window being / last persisted
+    std::uint64_t done = 0;      // covered by a finished persist()
+    std::uint64_t commitCount = 0;
+    Clock::time_point firstQueued;
+    bool flushRequested = false;
+    bool stopping = false;
+    std::vector<Waiter> waiters;
+
+    std::thread worker;          // last: starts after everything above is set up
+};
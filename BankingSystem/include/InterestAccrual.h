@@ -0,0 +1,41 @@
+#pragma once
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "Date.h"
+#include "Money.h"
+
+// End-of-day savings interest over the whole database
+// (DatabaseManager::accrueSavingsInterest; accrueCustomerInterest runs the
+// same rows for one customer at login). The accounts are copied into a
+// compact array of rows, interest is computed on it in parallel, and the
+// results go back into the database as one write. Same formula as
+// AppSession::applySavingsInterest: balance * rate * days / 365, banker's rounding.
+
+// One Savings account
+struct SavingsRow {
+    enum class Dated : std::uint8_t { Yes, Missing, Unreadable };
+
+    std::int64_t balanceMinor = 0;   // EUR cents
+    double rate = 0.0;               // <= 0 -> default rate
+    Date last;
+    Dated dated = Dated::Yes;        // Missing -> just gets today's date; Unreadable -> left alone
+    std::int64_t interestMinor = 0;  // out
+    bool touched = false;            // out: balance and / or date change; a positive balance
+                                     // whose interest rounds to 0 keeps its date (days add up)
+};
+
+struct AccrualReport {
+    Date date;                       // accrued up to
+    std::size_t accounts = 0;        // Savings accounts seen
+    std::size_t credited = 0;        // got interest
+    std::size_t dated = 0;           // had no lastSavedDate, now dated today
+    Money totalInterest;             // EUR
+    double computeMs = 0.0;          // parallel part
+    double totalMs = 0.0;            // scan + compute + apply + write
+};
+
+// Fills interestMinor / touched for every row, split over `threads` workers
+// (0 = hardware_concurrency; small inputs run inline)
+void computeAccrual(std::vector<SavingsRow>& rows, Date today, std::size_t threads = 0);
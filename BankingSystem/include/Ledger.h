@@ -0,0 +1,94 @@
+#pragma once
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "Money.h"
+
+class Customer;
+
+// Concurrent balances keyed by accId. Accounts are spread over lock stripes
+// (hash of accId), so operations on accounts in different stripes never wait
+// for each other. A two-account transfer locks both stripes in index order,
+// so transfers in opposite directions can't deadlock.
+//
+// Every change bumps the account's version; read() returns it, so a caller can
+// do its own optimistic read-modify-write with compareAndSet().
+//
+// DatabaseManager keeps one as the owner of all balances: money moves here
+// first, and the image / journal follow (DatabaseManager::deposit, ...).
+class Ledger {
+public:
+    struct Balance {
+        Money amount;
+        std::uint64_t version = 0;   // 1 after open(), +1 per change
+    };
+
+    // One side of a posting: amount is positive, in the account currency
+    struct Leg {
+        int accId = 0;
+        Money amount;
+        bool debit = false;
+    };
+
+    explicit Ledger(std::size_t stripes = 64);   // rounded up to a power of two
+
+    bool open(int accId, const Money& initial);  // false if it already exists
+    bool close(int accId);
+    bool contains(int accId) const;
+    std::size_t size() const;
+
+    bool read(int accId, Balance& out) const;
+
+    // false + error ("Account not found.", "Insufficient funds.", "Currency mismatch.",
+    // "Invalid amount.") and nothing changed
+    bool credit(int accId, const Money& amount, std::string* error = nullptr);
+    bool debit(int accId, const Money& amount, std::string* error = nullptr);
+    bool transfer(int fromAccId, int toAccId, const Money& amount, std::string* error = nullptr);
+
+    // Several legs at once, all or nothing: the stripes of every account are
+    // locked (in index order), legs are checked in order against the running
+    // balances, then applied. whileLocked runs before the stripes are released,
+    // so whatever it records is in the same order as the changes themselves.
+    // after (optional): balance of each leg's account once all legs are applied.
+    bool post(const std::vector<Leg>& legs, std::string* error = nullptr,
+              const std::function<void()>& whileLocked = {}, std::vector<Money>* after = nullptr);
+
+    // Sets the balance only if nobody changed it since read() returned expectedVersion
+    bool compareAndSet(int accId, std::uint64_t expectedVersion, const Money& newAmount);
+
+    // Follow a change made elsewhere (DatabaseManager image): no checks.
+    // assign() opens the account if needed and may change its currency.
+    void assign(int accId, const Money& amount);
+    bool adjust(int accId, const Money& delta);   // delta in the account currency, may be negative
+
+    // Replaces every balance; accounts not in `balances` are closed. pending()
+    // (optional) runs with all stripes held and returns legs posted but not yet
+    // part of `balances`; they are applied on top without checks.
+    void reset(const std::vector<std::pair<int, Money>>& balances,
+               const std::function<std::vector<Leg>()>& pending = {});
+
+    // Customer / Account as views: the balances of one customer's accounts
+    // refreshed from the ledger. A standalone ledger is filled from a database
+    // with reset(db.accountBalances()).
+    void refresh(Customer& customer) const;
+
+    // Visits all accounts, one stripe locked at a time (not a global snapshot)
+    void forEach(const std::function<void(int accId, const Balance&)>& fn) const;
+
+private:
+    struct alignas(64) Stripe {   // own cache line: no false sharing between stripes
+        mutable std::mutex m;
+        std::unordered_map<int, Balance> accounts;
+    };
+
+    std::size_t stripeOf(int accId) const;
+    static bool check(const Money& balance, const Leg& leg, std::string* error);
+
+    std::size_t mask;
+    std::unique_ptr<Stripe[]> stripes;
+};
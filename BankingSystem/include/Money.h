@@ -0,0 +1,86 @@
+#pragma once
+#include <cstdint>
+#include <string>
+#include <string_view>
+
+// ISO-4217 code ("EUR", "JPY", ...) stored inline, 4 bytes, trivially copyable
+class CurrencyCode {
+private:
+    char code[4];   // 3 letters + '\0'
+
+public:
+    constexpr CurrencyCode() : code{ 'E', 'U', 'R', '\0' } {}
+    constexpr CurrencyCode(char a, char b, char c) : code{ a, b, c, '\0' } {}
+
+    // Unknown / malformed input -> "" (empty code)
+    static CurrencyCode fromString(std::string_view s);
+
+    std::string str() const;
+    std::string_view view() const;
+    const char* c_str() const { return code; }
+    bool empty() const { return code[0] == '\0'; }
+
+    bool operator==(const CurrencyCode& o) const {
+        return code[0] == o.code[0] && code[1] == o.code[1] && code[2] == o.code[2];
+    }
+    bool operator!=(const CurrencyCode& o) const { return !(*this == o); }
+};
+
+inline constexpr CurrencyCode EUR{ 'E', 'U', 'R' };
+
+enum class RoundingMode {
+    HalfEven,   // banker's rounding
+    HalfUp,     // .5 away from zero
+    Down,       // toward zero (truncate)
+    Floor,      // toward -inf
+    Ceiling     // toward +inf
+};
+
+// Exact amount of money: integer count of minor units (cents) + currency.
+// + and - are exact; anything involving a rate (FX, interest) takes an
+// explicit RoundingMode. Mixing currencies throws std::invalid_argument.
+class Money {
+private:
+    std::int64_t minor;
+    CurrencyCode cur;
+
+public:
+    constexpr Money() : minor(0), cur(EUR) {}
+    constexpr Money(std::int64_t minorUnits, CurrencyCode currency)
+        : minor(minorUnits), cur(currency) {}
+
+    // Compatibility with double-valued input (old JSON, ImGui fields):
+    // rounds to the nearest minor unit.
+    static Money fromMajor(double amount, CurrencyCode currency = EUR);
+    static int minorDigits(CurrencyCode currency);   // 2 for most, 0 for JPY
+    // Exact decimal text ("12", "-0.5", "1234.56"), no rounding: more fraction
+    // digits than the currency has -> false
+    static bool parse(std::string_view text, CurrencyCode currency, Money& out);
+
+    std::int64_t minorUnits() const { return minor; }
+    CurrencyCode currency() const { return cur; }
+    double toMajor() const;          // display / legacy JSON only
+    std::string toString() const;    // "1234.50" (no currency)
+
+    bool isZero() const { return minor == 0; }
+    bool isPositive() const { return minor > 0; }
+    bool isNegative() const { return minor < 0; }
+
+    Money operator+(const Money& o) const;
+    Money operator-(const Money& o) const;
+    Money operator-() const;
+    Money& operator+=(const Money& o);
+    Money& operator-=(const Money& o);
+
+    bool operator==(const Money& o) const { return minor == o.minor && cur == o.cur; }
+    bool operator!=(const Money& o) const { return !(*this == o); }
+    bool operator<(const Money& o) const;
+    bool operator<=(const Money& o) const;
+    bool operator>(const Money& o) const;
+    bool operator>=(const Money& o) const;
+
+    // this * factor in the same currency (interest: balance * rate * days/365)
+    Money scaled(double factor, RoundingMode mode) const;
+    // this * rate in another currency (rate = units of `to` per unit of this)
+    Money convert(double rate, CurrencyCode to, RoundingMode mode) const;
+};
@@ -0,0 +1,78 @@
+#pragma once
+// Built-in profiler: scoped timers and I/O counters, shown by the ImGui overlay
+// (src/ui/UI_Profiler.cpp). Off by default; build with -DBANKING_PROFILER=1 to enable.
+// When off, every PROF_* macro expands to ((void)0): no code, no data, no calls.
+//
+//   PROF_SCOPE("DatabaseManager::loadAll");   // times the enclosing block
+//   PROF_BYTES_READ(bytes.size());
+//   PROF_JSON_PARSE();
+
+#ifndef BANKING_PROFILER
+#define BANKING_PROFILER 0
+#endif
+
+#if BANKING_PROFILER
+
+#include <cstddef>
+#include <cstdint>
+
+namespace prof {
+
+// One finished scope. name is a string literal (compared by text, not by pointer).
+struct Sample {
+    const char* name;
+    std::uint64_t startNs;
+    std::uint64_t durNs;
+};
+
+struct Counters {
+    std::uint64_t bytesRead;
+    std::uint64_t bytesWritten;
+    std::uint64_t jsonParses;
+    std::uint64_t dropped;     // samples lost to a full ring (not drained in time)
+};
+
+std::uint64_t nowNs();         // steady clock
+
+// Producers: any thread, lock-free. Each thread writes its own ring; when a ring
+// is full (nobody drains) the sample is dropped and counted in Counters::dropped.
+void record(const char* name, std::uint64_t startNs, std::uint64_t durNs);
+void addBytesRead(std::uint64_t n);
+void addBytesWritten(std::uint64_t n);
+void addJsonParse();
+
+// Consumer: one thread (the UI). Copies samples finished since the last call
+// (in order per producing thread); returns how many were written to out (at most max).
+std::size_t drain(Sample* out, std::size_t max);
+Counters counters();           // running totals since start
+
+class Scope {
+public:
+    explicit Scope(const char* name) : name(name), start(nowNs()) {}
+    ~Scope() { record(name, start, nowNs() - start); }
+
+    Scope(const Scope&) = delete;
+    Scope& operator=(const Scope&) = delete;
+
+private:
+    const char* name;
+    std::uint64_t start;
+};
+
+} // namespace prof
+
+#define PROF_CAT_(a, b) a##b
+#define PROF_CAT(a, b) PROF_CAT_(a, b)
+#define PROF_SCOPE(name)      ::prof::Scope PROF_CAT(profScope_, __LINE__)(name)
+#define PROF_BYTES_READ(n)    ::prof::addBytesRead((std::uint64_t)(n))
+#define PROF_BYTES_WRITTEN(n) ::prof::addBytesWritten((std::uint64_t)(n))
+#define PROF_JSON_PARSE()     ::prof::addJsonParse()
+
+#else
+
+#define PROF_SCOPE(name)      ((void)0)
+#define PROF_BYTES_READ(n)    ((void)0)
+#define PROF_BYTES_WRITTEN(n) ((void)0)
+#define PROF_JSON_PARSE()     ((void)0)
+
+#endif
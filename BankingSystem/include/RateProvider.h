@@ -0,0 +1,100 @@
+#pragma once
+#include <string>
+#include <vector>
+#include <memory>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <functional>
+#include <unordered_map>
+#include <cstdint>
+
+// Immutable set of FX rates (EUR base). Published as a whole, never edited.
+struct RateSnapshot {
+    std::unordered_map<std::string, double> rates; // currency -> units per 1 EUR
+    std::string error;            // last fetch error ("" = last fetch ok)
+    long long fetchedAtMs = 0;    // last successful fetch (epoch ms), 0 = never
+    std::uint64_t version = 0;    // bumps on every publish
+};
+
+// Where rates come from. fetch() runs on the RateService worker thread only.
+class RateSource {
+public:
+    virtual ~RateSource() = default;
+    virtual bool fetch(std::unordered_map<std::string, double>& outRates,
+                       std::string& outError, int timeoutSec) = 0;
+};
+
+// Frankfurter API via system curl (bounded by --max-time)
+class CurlRateSource : public RateSource {
+private:
+    std::vector<std::string> symbols;
+public:
+    explicit CurlRateSource(const std::vector<std::string>& symbols);
+    bool fetch(std::unordered_map<std::string, double>& outRates,
+               std::string& outError, int timeoutSec) override;
+};
+
+// Local fixture: a Frankfurter-style payload { "rates": {...} }, re-read on every fetch
+class FileRateSource : public RateSource {
+private:
+    std::string path;
+public:
+    explicit FileRateSource(const std::string& path);
+    bool fetch(std::unordered_map<std::string, double>& outRates,
+               std::string& outError, int timeoutSec) override;
+};
+
+// Recorded session: one payload per line, played in order and looped
+class ReplayRateSource : public RateSource {
+private:
+    std::vector<std::string> frames;
+    std::size_t next = 0;
+public:
+    explicit ReplayRateSource(const std::string& path);
+    bool fetch(std::unordered_map<std::string, double>& outRates,
+               std::string& outError, int timeoutSec) override;
+};
+
+// "curl" (default), "file:<path>", "replay:<path>"
+std::unique_ptr<RateSource> makeRateSource(const std::string& spec,
+                                           const std::vector<std::string>& symbols);
+
+struct RateServiceOptions {
+    int pollMs = 5000;          // normal refresh period
+    int timeoutSec = 4;         // per fetch
+    int maxBackoffMs = 60000;   // failures back off 2x per attempt up to this
+    // Called on the worker thread after every publish (e.g. to wake an idle UI loop)
+    std::function<void()> onPublish;
+};
+
+// Polls a RateSource on its own thread and publishes RateSnapshot objects.
+// snapshot() never blocks on the network: it is an atomic shared_ptr load.
+class RateService {
+private:
+    std::unique_ptr<RateSource> source;
+    RateServiceOptions options;
+
+    std::shared_ptr<const RateSnapshot> current;   // accessed via std::atomic_load/store
+
+    std::thread worker;
+    std::mutex m;
+    std::condition_variable cv;
+    bool stopping = false;
+
+    void run();
+    void publish(std::shared_ptr<const RateSnapshot> s);
+
+public:
+    RateService(std::unique_ptr<RateSource> source,
+                const RateServiceOptions& options = RateServiceOptions());
+    ~RateService();
+
+    RateService(const RateService&) = delete;
+    RateService& operator=(const RateService&) = delete;
+
+    void start();
+    void stop();   // joins; waits at most for one in-flight fetch (timeoutSec)
+
+    std::shared_ptr<const RateSnapshot> snapshot() const;
+};
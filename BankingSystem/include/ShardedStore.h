@@ -0,0 +1,98 @@
+#pragma once
+#include <string>
+#include <cstdint>
+#include <unordered_set>
+#include <vector>
+
+#include "DbFormat.h"
+#include "nlohmann/json.hpp"
+
+using json = nlohmann::json;
+
+// Directory layout of a database (StorageMode::Sharded):
+//
+//   <dir>/manifest.json               commit point: shard files, transfer segments, meta
+//   <dir>/customers/<ssss>-<gen>.json customers whose id hashes to shard ssss, written at commit gen
+//   <dir>/transfers/<nnnnnn>.jsonl    transfer log, one compact entry per line, append-only
+//
+// A commit writes the touched shards as new files, appends new transfers to the
+// active segment and then replaces manifest.json (tmp + rename). Shards, segments
+// and the manifest tmp are fsynced before the rename, the directory after it, so
+// a power loss can't leave a manifest naming data that isn't there. Readers only see
+// what the manifest names, up to the segment lengths it records, so a crash
+// before the rename leaves the previous state; the leftovers are cleaned up by
+// the next commit. Cost per commit: the touched shards + the new log lines + the
+// manifest, not the whole bank.
+class ShardedStore {
+public:
+    static constexpr std::size_t DEFAULT_SHARDS = 64;
+    static constexpr std::uintmax_t DEFAULT_SEGMENT_BYTES = 4u * 1024 * 1024;
+
+    // shards / segmentBytes only apply to a new store; an existing one keeps its own.
+    // format: encoding of the shard files (the manifest and the log stay JSON).
+    explicit ShardedStore(const std::string& dir,
+                          std::size_t shards = DEFAULT_SHARDS,
+                          std::uintmax_t segmentBytes = DEFAULT_SEGMENT_BYTES,
+                          FileFormat format = FileFormat::Json);
+
+    const std::string& getDir() const { return dir; }
+    std::string manifestPath() const;
+    static bool isStore(const std::string& dir);   // has a manifest
+
+    std::size_t shardCount() const { return shardFiles.size(); }
+    std::size_t shardOf(const std::string& customerId) const;   // FNV-1a: same in every build
+    std::uint64_t commitSeq() const { return seq; }
+
+    // Whole database as a normalized root ({customers, transfers, meta}).
+    // Shards are parsed in parallel. No directory / empty directory -> creates an
+    // empty store. Forgets anything touched but not committed.
+    // Errors: "Manifest unreadable.", "Shard file unreadable.",
+    // "Transfer segment unreadable.", "Shard files without a manifest."
+    bool load(json& outRoot, std::string* error = nullptr);
+
+    // What the next commit() has to write
+    // (root["meta"] and new root["transfers"] entries are picked up by commit() itself)
+    void touchCustomer(const std::string& id);
+    void touchAll();                 // root replaced: every shard + a fresh transfer log
+    bool hasChanges() const;
+
+    // Writes what was touched (several shards in parallel) plus root["transfers"]
+    // entries not on disk yet, then swaps the manifest.
+    bool commit(const json& root, std::string* error = nullptr);
+
+private:
+    struct Segment {
+        std::string file;            // relative to dir
+        std::uintmax_t bytes = 0;    // committed length; anything past it is ignored
+        std::size_t entries = 0;
+    };
+
+    std::string dir;
+    std::uintmax_t segmentBytes;
+    FileFormat format;
+
+    // Committed state (= manifest.json)
+    std::uint64_t seq = 0;
+    std::vector<std::string> shardFiles;   // per shard, relative to dir; "" = no customers
+    std::vector<Segment> segments;
+    std::uint64_t nextSegment = 1;
+    json meta = json::object();
+
+    // Customer ids per shard (may still hold removed ids; commit() drops them)
+    std::vector<std::unordered_set<std::string>> members;
+    std::size_t transfersOnDisk = 0;
+
+    std::vector<char> dirty;
+    bool allDirty = false;
+    bool swept = false;              // leftovers of crashed commits removed
+
+    std::string path(const std::string& rel) const;
+    bool writeManifest(std::uint64_t newSeq, const std::vector<std::string>& newShards,
+                       const std::vector<Segment>& newSegments, std::uint64_t newNextSegment,
+                       const json& newMeta);
+    bool writeShards(const json& custs, const std::vector<std::size_t>& which, std::uint64_t gen,
+                     std::vector<std::string>& newShards, std::vector<std::string>& written);
+    bool writeTransfers(const json& transfers, bool rewrite,
+                        std::vector<Segment>& newSegments, std::uint64_t& newNextSegment);
+    void sweep(const std::vector<std::string>& keepShards, const std::vector<Segment>& keepSegments);
+};
@@ -0,0 +1,33 @@
+#pragma once
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+// Fixed set of worker threads running submitted jobs in FIFO order.
+class ThreadPool {
+public:
+    explicit ThreadPool(std::size_t threads = 0);   // 0 = hardware_concurrency (at least 2)
+    ~ThreadPool();                                   // runs what is queued, then joins
+
+    ThreadPool(const ThreadPool&) = delete;
+    ThreadPool& operator=(const ThreadPool&) = delete;
+
+    void submit(std::function<void()> job);
+    void wait();                                     // until the queue is empty and all workers idle
+
+    std::size_t size() const { return workers.size(); }
+
+private:
+    void run();
+
+    std::mutex m;
+    std::condition_variable cv;
+    std::condition_variable idle;
+    std::deque<std::function<void()>> jobs;
+    std::size_t active = 0;
+    bool stopping = false;
+    std::vector<std::thread> workers;
+};
@@ -0,0 +1,37 @@
+#pragma once
+#include <string>
+#include <cstdint>
+#include <functional>
+#include <vector>
+
+#include "nlohmann/json.hpp"
+
+using json = nlohmann::json;
+
+// Append-only journal of database mutations: one compact JSON record per line.
+// The file is opened per append, so the object stays cheap to copy.
+class WriteAheadLog {
+private:
+    std::string path;
+    std::size_t recordCount = 0;
+    std::uintmax_t byteCount = 0;
+
+public:
+    explicit WriteAheadLog(const std::string& path = "");
+
+    const std::string& getPath() const;
+    std::size_t records() const;   // records since the last reset
+    std::uintmax_t bytes() const;
+
+    // true -> the records are on disk (fsync), not just in the OS cache
+    bool append(const json& record);
+    bool append(const std::vector<json>& batch);   // one write + one fsync for the whole group
+
+    // Calls apply() for every complete record, in order.
+    // A torn/garbled tail (crash mid-append) is moved to <wal>.corrupt and cut
+    // off, so records appended later are still reachable.
+    bool replay(const std::function<void(const json&)>& apply);
+
+    // Drop all records (after they were folded into a snapshot)
+    bool reset();
+};
@@ -1,46 +1,66 @@
 #include "Account.h"
 #include <iostream>
-#include <iomanip>
 
 using namespace std;
 
+const char* accountTypeName(AccountType t) {
+    switch (t) {
+        case AccountType::Checking: return "Checking";
+        case AccountType::Savings:  return "Savings";
+        case AccountType::FX:       return "FX";
+        case AccountType::Unknown:  return "Unknown";
+    }
+    return "Unknown";
+}
+
+AccountType accountTypeFromName(std::string_view name) {
+    if (name == "Checking") return AccountType::Checking;
+    if (name == "Savings")  return AccountType::Savings;
+    if (name == "FX")       return AccountType::FX;
+    return AccountType::Unknown;
+}
+
 Account::Account()
-    : id(0), type("Unknown"), balance(0.0),
-      savingsRate(0.0), lastSavedDate(""),
-      currency("") {}
+    : balance(), savingsRate(0.0), id(0), lastSaved(), type(AccountType::Unknown) {}
+
+Account::Account(int id, AccountType type, Money balance)
+    : balance(balance), savingsRate(0.0), id(id), lastSaved(), type(type) {}
+
+Account::Account(int id, const std::string& type, Money balance)
+    : Account(id, accountTypeFromName(type), balance) {}
 
 Account::Account(int id, const std::string& type, double balance)
-    : id(id), type(type), balance(balance),
-      savingsRate(0.0), lastSavedDate(""),
-      currency("") {}
+    : Account(id, type, Money::fromMajor(balance, EUR)) {}
 
 int Account::getId() const { return id; }
-std::string Account::getType() const { return type; }
-double Account::getBalance() const { return balance; }
+AccountType Account::getType() const { return type; }
+Money Account::getBalance() const { return balance; }
 
-void Account::setBalance(double b) { balance = b; }
-void Account::setType(const std::string& t) { type = t; }
+void Account::setBalance(Money b) { balance = b; }
+void Account::setType(AccountType t) { type = t; }
 
 double Account::getSavingsRate() const { return savingsRate; }
 void Account::setSavingsRate(double r) { savingsRate = r; }
-std::string Account::getLastSavedDate() const { return lastSavedDate; }
-void Account::setLastSavedDate(const std::string& d) { lastSavedDate = d; }
+Date Account::getLastSaved() const { return lastSaved; }
+void Account::setLastSaved(Date d) { lastSaved = d; }
+std::string Account::getLastSavedDate() const { return lastSaved.iso(); }
+void Account::setLastSavedDate(const std::string& d) { lastSaved = Date::fromIso(d); }
 
-std::string Account::getCurrency() const { return currency; }
-void Account::setCurrency(const std::string& c) { currency = c; }
+CurrencyCode Account::getCurrency() const { return balance.currency(); }
+void Account::setCurrency(CurrencyCode c) { balance = Money(balance.minorUnits(), c); }
 
-void Account::deposit(double amount) {
-    if (amount <= 0) {
+void Account::deposit(Money amount) {
+    if (!amount.isPositive()) {
         cout << "Deposit amount must be positive.\n";
         return;
     }
     balance += amount;
-    cout << "Deposited " << fixed << setprecision(2) << amount
-         << " to account " << id << ". New balance: " << balance << endl;
+    cout << "Deposited " << amount.toString()
+         << " to account " << id << ". New balance: " << balance.toString() << endl;
 }
 
-bool Account::withdraw(double amount) {
-    if (amount <= 0) {
+bool Account::withdraw(Money amount) {
+    if (!amount.isPositive()) {
         cout << "Withdrawal amount must be positive.\n";
         return false;
     }
@@ -49,24 +69,24 @@ bool Account::withdraw(double amount) {
         return false;
     }
     balance -= amount;
-    cout << "Withdrawn " << fixed << setprecision(2) << amount
-         << " from account " << id << ". New balance: " << balance << endl;
+    cout << "Withdrawn " << amount.toString()
+         << " from account " << id << ". New balance: " << balance.toString() << endl;
     return true;
 }
 
 void Account::printInfo() const {
     cout << "Account ID: " << id
-         << " | Type: " << type;
+         << " | Type: " << accountTypeName(type);
 
-    if (type == "FX" && !currency.empty()) {
-        cout << " (" << currency << ")";
+    if (type == AccountType::FX && !balance.currency().empty()) {
+        cout << " (" << balance.currency().str() << ")";
     }
 
-    cout << " | Balance: " << fixed << setprecision(2) << balance;
+    cout << " | Balance: " << balance.toString();
 
-    if (type == "Savings") {
+    if (type == AccountType::Savings) {
         cout << " | Rate: " << (savingsRate * 100) << "%";
-        if (!lastSavedDate.empty()) cout << " | LastSaved: " << lastSavedDate;
+        if (!lastSaved.empty()) cout << " | LastSaved: " << lastSaved.iso();
     }
     cout << endl;
 }
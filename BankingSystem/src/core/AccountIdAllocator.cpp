@@ -0,0 +1,130 @@
+#include "AccountIdAllocator.h"
+
+#include <algorithm>
+
+static int maxIdFor(int digits) {
+    int m = 1;
+    for (int i = 0; i < digits; ++i) m *= 10;
+    return m - 1;
+}
+
+static int ctz64(std::uint64_t x) {
+    int n = 0;
+    while (!(x & 1u)) { x >>= 1; ++n; }
+    return n;
+}
+
+AccountIdAllocator::AccountIdAllocator(int digits) {
+    reset(digits);
+}
+
+void AccountIdAllocator::reset(int d) {
+    digits = std::clamp(d, MIN_DIGITS, MAX_DIGITS);
+    maxId = maxIdFor(digits);
+    const std::size_t nPages = (capacity() + PAGE_IDS - 1) / PAGE_IDS;
+    pages.assign(nPages, Page());
+    pageUsed.assign(nPages, 0);
+    usedCount = 0;
+
+    // выданные, но ещё не сохранённые id остаются занятыми
+    std::unordered_set<int> keep;
+    keep.swap(reserved);
+    for (int id : keep) {
+        if (!inRange(id)) continue;
+        markUsed(id);
+        reserved.insert(id);
+    }
+}
+
+void AccountIdAllocator::widen(int newDigits) {
+    newDigits = std::clamp(newDigits, MIN_DIGITS, MAX_DIGITS);
+    if (newDigits <= digits) return;
+    digits = newDigits;
+    maxId = maxIdFor(digits);
+    const std::size_t nPages = (capacity() + PAGE_IDS - 1) / PAGE_IDS;
+    pages.resize(nPages);
+    pageUsed.resize(nPages, 0);
+}
+
+int AccountIdAllocator::pageCapacity(std::size_t page) const {
+    const std::size_t first = page * PAGE_IDS;
+    return (int)std::min<std::size_t>(PAGE_IDS, capacity() - first);
+}
+
+void AccountIdAllocator::markUsed(int id) {
+    reserved.erase(id);
+    if (!inRange(id)) return;
+    const std::size_t off = (std::size_t)(id - MIN_ID);
+    Page& p = pages[off / PAGE_IDS];
+    if (p.empty()) p.assign(PAGE_WORDS, 0);
+    std::uint64_t& w = p[(off % PAGE_IDS) / 64];
+    const std::uint64_t bit = 1ULL << (off % 64);
+    if (w & bit) return;
+    w |= bit;
+    ++pageUsed[off / PAGE_IDS];
+    ++usedCount;
+}
+
+bool AccountIdAllocator::isUsed(int id) const {
+    if (!inRange(id)) return false;
+    const std::size_t off = (std::size_t)(id - MIN_ID);
+    const Page& p = pages[off / PAGE_IDS];
+    if (p.empty()) return false;
+    return (p[(off % PAGE_IDS) / 64] >> (off % 64)) & 1u;
+}
+
+int AccountIdAllocator::takeFromPage(std::size_t page) {
+    const int cap = pageCapacity(page);
+    Page& p = pages[page];
+    if (p.empty()) p.assign(PAGE_WORDS, 0);
+
+    for (int w = 0; w < PAGE_WORDS; ++w) {
+        if (p[w] == ~0ULL) continue;
+        const int bit = ctz64(~p[w]);
+        const int inPage = w * 64 + bit;
+        if (inPage >= cap) return 0;   // хвост последней страницы за пределами диапазона
+        p[w] |= 1ULL << bit;
+        ++pageUsed[page];
+        ++usedCount;
+        return MIN_ID + (int)(page * PAGE_IDS) + inPage;
+    }
+    return 0;
+}
+
+int AccountIdAllocator::allocate() {
+    if (freeIds() == 0) return 0;
+
+    // случайная стартовая страница: id не идут подряд, как и раньше с rand()
+    const std::size_t nPages = pages.size();
+    const std::size_t start = std::uniform_int_distribution<std::size_t>(0, nPages - 1)(rng);
+    for (std::size_t k = 0; k < nPages; ++k) {
+        const std::size_t page = (start + k) % nPages;
+        if ((int)pageUsed[page] >= pageCapacity(page)) continue;
+        int id = takeFromPage(page);
+        if (id) {
+            reserved.insert(id);
+            return id;
+        }
+    }
+    return 0;
+}
+
+std::vector<int> AccountIdAllocator::reserve(std::size_t n) {
+    std::vector<int> out;
+    if (n > freeIds()) return out;
+    out.reserve(n);
+    for (std::size_t i = 0; i < n; ++i) out.push_back(allocate());
+    return out;
+}
+
+void AccountIdAllocator::release(int id) {
+    if (!reserved.erase(id) || !inRange(id)) return;
+    const std::size_t off = (std::size_t)(id - MIN_ID);
+    Page& p = pages[off / PAGE_IDS];
+    std::uint64_t& w = p[(off % PAGE_IDS) / 64];
+    const std::uint64_t bit = 1ULL << (off % 64);
+    if (!(w & bit)) return;
+    w &= ~bit;
+    --pageUsed[off / PAGE_IDS];
+    --usedCount;
+}
@@ -2,17 +2,226 @@
 #include "AppSession.h"
 
 #include <cctype>
-#include <chrono>
-#include <ctime>
-#include <sstream>
-#include <iomanip>
+#include <cstdint>
+#include <cstdlib>
 #include <algorithm>
 
+DatabaseOptions AppSession::databaseOptions() {
+    // Each button press appends a small journal record instead of rewriting the DB
+    DatabaseOptions o;
+    o.mode = StorageMode::WriteAheadLog;
+    // ...unless the DB was migrated to a sharded directory: a press rewrites one shard
+    if (ShardedStore::isStore(DB_PATH)) o.mode = StorageMode::Sharded;
+    // Startup reads database.json.snap instead of parsing JSON
+    o.binarySnapshot = true;
+    // A transfer is 3 mutations (both customers + log entry): one append per window
+    o.commitWindowMs = 50;
+    return o;
+}
+
+std::string AppSession::serverFromEnv() {
+    const char* s = std::getenv("BANKING_SERVER");
+    return s ? s : "";
+}
+
+std::unique_ptr<DatabaseManager> AppSession::openDatabase(const std::string& serverAddress) {
+    if (!serverAddress.empty()) return nullptr;   // тонкий клиент: базу держит сервер
+    return std::make_unique<DatabaseManager>(DB_PATH, databaseOptions());
+}
+
 void AppSession::ShowToast(const std::string& msg) {
     toast = msg;
     toast_t = (double)ImGui::GetTime();
 }
 
+void AppSession::logout() {
+    // на сервере каждая операция уже записана; закрываем соединение - вместе с ним и вход
+    if (db) {
+        db->addOrUpdateCustomer(current);
+        db->flush();
+    } else {
+        server.close();
+        serverLogin = json();
+    }
+
+    // db and rates are not per-user: only the session part starts over
+    static_cast<SessionState&>(*this) = SessionState();
+}
+
+// ---------------------- backend ----------------------
+json AppSession::serverCall(json request) {
+    if (!server.connected()) {
+        std::string host = serverAddress;
+        int port = DEFAULT_SERVER_PORT;
+        const auto colon = host.rfind(':');
+        if (colon != std::string::npos) {
+            port = std::atoi(host.c_str() + colon + 1);
+            host.resize(colon);
+        }
+        std::string err;
+        if (!server.connect(host, port, &err))
+            return { { "ok", false }, { "error", "Server unavailable: " + err } };
+
+        // вход на сервере живёт в соединении -> на новом входим заново
+        json res;
+        if (!serverLogin.is_null() && request.value("op", "") != "login") {
+            if (!server.call(serverLogin, res)) {
+                server.close();
+                return { { "ok", false }, { "error", "Connection to the server lost." } };
+            }
+            if (!res.value("ok", false)) return res;
+        }
+    }
+    const bool login = request.value("op", "") == "login";
+    json sent = login ? request : json();
+    json res;
+    if (!server.call(std::move(request), res)) {
+        // не знаем, дошёл ли запрос -> не повторяем, переподключимся на следующем
+        server.close();
+        return { { "ok", false }, { "error", "Connection to the server lost." } };
+    }
+    if (login && res.value("ok", false)) serverLogin = std::move(sent);
+    return res;
+}
+
+Customer AppSession::customerFromJson(const json& j) {
+    Customer c(j.value("firstName", ""), j.value("lastName", ""), j.value("age", 0),
+               j.value("email", ""), j.value("customerId", ""), "", j.value("phone", ""));
+    if (j.contains("accounts") && j["accounts"].is_array()) {
+        for (const auto& a : j["accounts"]) {
+            const CurrencyCode cur = CurrencyCode::fromString(a.value("currency", "EUR"));
+            c.addAccount(Account(a.value("accId", 0), accountTypeFromName(a.value("type", "")),
+                                 Money(a.value("balanceMinor", (std::int64_t)0), cur)));
+        }
+    }
+    return c;
+}
+
+bool AppSession::loadCustomer(const std::string& id, Customer& out) {
+    if (db) return db->loadCustomer(id, out);
+    json r = serverCall({ { "op", "customer" }, { "customerId", id } });
+    if (!r.value("ok", false)) return false;
+    out = customerFromJson(r["customer"]);
+    return true;
+}
+
+bool AppSession::reloadCurrent() {
+    return loadCustomer(current.getId(), current);
+}
+
+std::vector<std::string> AppSession::findCustomersByName(const std::string& firstName,
+                                                         const std::string& lastName) {
+    if (db) return db->findCustomersByName(firstName, lastName);
+    json r = serverCall({ { "op", "findByName" }, { "firstName", firstName }, { "lastName", lastName } });
+    if (!r.value("ok", false)) return {};
+    return r.value("customerIds", std::vector<std::string>());
+}
+
+bool AppSession::recipientAccount(const std::string& customerId, int& accId, CurrencyCode& currency,
+                                  std::string& error) {
+    if (db) {
+        Customer c;
+        if (!db->loadCustomer(customerId, c)) { error = "Failed to load recipient."; return false; }
+        const Account* a = c.incomingAccount();
+        if (!a) { error = "Recipient has no accounts."; return false; }
+        accId = a->getId();
+        currency = a->getBalance().currency();
+        return true;
+    }
+    json r = serverCall({ { "op", "recipient" }, { "customerId", customerId } });
+    if (!r.value("ok", false)) { error = r.value("error", "Request failed."); return false; }
+    accId = r.value("accId", 0);
+    currency = CurrencyCode::fromString(r.value("currency", ""));
+    return true;
+}
+
+bool AppSession::depositOrWithdraw(bool deposit, int accId, const Money& amount, std::string& error) {
+    if (db) return deposit ? db->deposit(accId, amount, &error) : db->withdraw(accId, amount, &error);
+
+    json r = serverCall({ { "op", deposit ? "deposit" : "withdraw" }, { "accId", accId },
+                          { "amountMinor", amount.minorUnits() } });
+    if (r.value("ok", false)) return true;
+    error = r.value("error", "Request failed.");
+    return false;
+}
+
+bool AppSession::transfer(int fromAccId, int toAccId, const Money& amount, const json& logEntry,
+                          std::string& error) {
+    if (db) {
+        if (db->transfer(fromAccId, toAccId, amount, logEntry, &error)) return true;
+        json e = logEntry;   // как сервер: отказ - в историю отправителя
+        e["status"] = "failed";
+        e["error"] = error;
+        e["fromAccId"] = fromAccId;
+        e["toCustomerId"] = "";
+        e["toAccId"] = 0;
+        e["amountMinor"] = amount.minorUnits();
+        e["amount"] = amount.toMajor();
+        db->appendTransferLog(e);
+        return false;
+    }
+
+    json r = serverCall({ { "op", "transfer" }, { "fromAccId", fromAccId }, { "toAccId", toAccId },
+                          { "amountMinor", amount.minorUnits() },
+                          { "mode", logEntry.value("mode", "by_account_id") },
+                          { "target", logEntry.value("target", std::to_string(toAccId)) } });
+    ++serverLogGen;   // и неудачный перевод попадает в историю
+    if (r.value("ok", false)) return true;
+    error = r.value("error", "Request failed.");
+    return false;
+}
+
+void AppSession::logFailedTransfer(const json& logEntry) {
+    if (db) {
+        db->appendTransferLog(logEntry);
+        return;
+    }
+    serverCall({ { "op", "logFailure" }, { "fromAccId", logEntry.value("fromAccId", 0) },
+                 { "amountMinor", logEntry.value("amountMinor", (std::int64_t)0) },
+                 { "mode", logEntry.value("mode", "by_account_id") },
+                 { "target", logEntry.value("target", "") },
+                 { "error", logEntry.value("error", "") } });
+    ++serverLogGen;
+}
+
+std::vector<TransferRecord> AppSession::transferHistory(const std::string& customerId, int daysBack,
+                                                        bool* complete) {
+    if (complete) *complete = true;
+    if (db) return db->queryTransfers(customerId, DatabaseManager::sinceTsForDaysBack(daysBack), SIZE_MAX).items;
+
+    // страницами, как их отдаёт queryTransfers, пока сервер говорит hasMore
+    constexpr std::size_t SERVER_HISTORY_PAGE = 1000;
+    std::vector<TransferRecord> rows;
+    std::size_t cursor = 0;
+    for (;;) {
+        json r = serverCall({ { "op", "history" }, { "customerId", customerId }, { "days", daysBack },
+                              { "limit", SERVER_HISTORY_PAGE }, { "cursor", cursor } });
+        if (!r.value("ok", false) || !r.contains("items")) {
+            if (complete) *complete = false;
+            return rows;
+        }
+        for (const auto& e : r["items"]) {
+            TransferRecord t;
+            t.ts = e.value("ts", 0LL);
+            t.status = e.value("status", "");
+            t.mode = e.value("mode", "");
+            t.fromAccId = e.value("fromAccId", 0);
+            t.toAccId = e.value("toAccId", 0);
+            Money::parse(e.value("amount", "0"), EUR, t.amount);
+            t.target = e.value("target", "");
+            t.error = e.value("error", "");
+            rows.push_back(std::move(t));
+        }
+        const std::size_t next = r.value("nextCursor", cursor);
+        if (!r.value("hasMore", false) || next <= cursor) return rows;
+        cursor = next;
+    }
+}
+
+std::uint64_t AppSession::transfersVersion() {
+    return db ? db->transfersVersion() : serverLogGen;
+}
+
 static bool isDigitsOnly(const std::string& s) {
     if (s.empty()) return false;
     for (unsigned char c : s) if (!std::isdigit(c)) return false;
@@ -43,30 +252,8 @@ bool AppSession::validatePhone(const std::string& phone) {
     return digits >= 7;
 }
 
-std::string AppSession::todayDate() {
-    using namespace std::chrono;
-    auto now = system_clock::now();
-    time_t t = system_clock::to_time_t(now);
-    std::tm buf{};
-#if defined(_WIN32) || defined(_WIN64)
-    localtime_s(&buf, &t);
-#else
-    localtime_r(&t, &buf);
-#endif
-    std::ostringstream ss; ss << std::put_time(&buf, "%Y-%m-%d");
-    return ss.str();
-}
-
-int AppSession::daysBetween(const std::string& fromDate, const std::string& toDate) {
-    std::tm tm1 = {}, tm2 = {};
-    std::istringstream ss1(fromDate), ss2(toDate);
-    ss1 >> std::get_time(&tm1, "%Y-%m-%d");
-    ss2 >> std::get_time(&tm2, "%Y-%m-%d");
-    if (ss1.fail() || ss2.fail()) return 0;
-    std::time_t t1 = std::mktime(&tm1);
-    std::time_t t2 = std::mktime(&tm2);
-    double d = std::difftime(t2, t1) / (60*60*24);
-    return (int)d;
+Date AppSession::todayDate() {
+    return Date::today();
 }
 
 int AppSession::findAccountIndexById(const std::vector<Account>& accounts, int accId) {
@@ -75,20 +262,25 @@ int AppSession::findAccountIndexById(const std::vector<Account>& accounts, int a
     return -1;
 }
 
-void AppSession::applySavingsInterestIfNeeded(Customer& cust) {
+void AppSession::applySavingsInterest(Customer& cust, Date today) {
     constexpr double DEFAULT_SAVINGS_RATE = 0.15;
-    std::string now = todayDate();
     for (auto& acc : cust.getAccounts()) {
-        if (acc.getType() == "Savings") {
-            std::string last = acc.getLastSavedDate();
-            if (last.empty()) { acc.setLastSavedDate(now); continue; }
-            int days = daysBetween(last, now);
+        if (acc.getType() == AccountType::Savings) {
+            Date last = acc.getLastSaved();
+            if (last.empty()) { acc.setLastSaved(today); continue; }
+            int days = today - last;   // номера дней: без mktime и без DST
             if (days <= 0) continue;
             double rate = acc.getSavingsRate();
             if (rate <= 0) rate = DEFAULT_SAVINGS_RATE;
-            double interest = acc.getBalance() * rate * (double(days)/365.0);
-            if (interest > 0.0) acc.setBalance(acc.getBalance() + interest);
-            acc.setLastSavedDate(now);
+            Money interest = acc.getBalance().scaled(rate * (double(days)/365.0),
+                                                     RoundingMode::HalfEven);
+            if (interest.isPositive()) {
+                acc.setBalance(acc.getBalance() + interest);
+                acc.setLastSaved(today);
+            } else if (!acc.getBalance().isPositive()) {
+                acc.setLastSaved(today);   // с нуля копить нечего
+            }
+            // меньше полцента -> дата стоит, дни копятся до первого начисленного цента
         }
     }
 }
@@ -96,14 +288,15 @@ void AppSession::applySavingsInterestIfNeeded(Customer& cust) {
 int AppSession::findCheckingIndex() const {
     const auto& accs = current.getAccounts();
     for (int i = 0; i < (int)accs.size(); ++i)
-        if (accs[i].getType() == "Checking") return i;
+        if (accs[i].getType() == AccountType::Checking) return i;
     return -1;
 }
 
 int AppSession::findFXIndexByCurrency(const std::string& cur) const {
     const auto& accs = current.getAccounts();
+    const CurrencyCode code = CurrencyCode::fromString(cur);
     for (int i = 0; i < (int)accs.size(); ++i)
-        if (accs[i].getType() == "FX" && accs[i].getCurrency() == cur) return i;
+        if (accs[i].getType() == AccountType::FX && accs[i].getCurrency() == code) return i;
     return -1;
 }
 
@@ -111,11 +304,11 @@ int AppSession::ensureFXAccount(const std::string& cur) {
     int idx = findFXIndexByCurrency(cur);
     if (idx >= 0) return idx;
 
-    int newId = db.generateUniqueAccountId();
-    Account fx(newId, "FX", 0.0);
-    fx.setCurrency(cur);
+    if (!db) return -1;   // тонкий клиент: счетов не открывает
+    int newId = db->generateUniqueAccountId();
+    Account fx(newId, AccountType::FX, Money(0, CurrencyCode::fromString(cur)));
     current.addAccount(fx);
-    db.addOrUpdateCustomer(current);
+    db->addOrUpdateCustomer(current);
 
     return findFXIndexByCurrency(cur);
 }
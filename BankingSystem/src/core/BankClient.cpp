@@ -0,0 +1,100 @@
+#include "BankClient.h"
+
+#include <arpa/inet.h>
+#include <netdb.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+#include <cerrno>
+#include <cstring>
+
+BankClient::~BankClient() {
+    close();
+}
+
+bool BankClient::connect(const std::string& host, int port, std::string* error) {
+    close();
+
+    addrinfo hints{};
+    hints.ai_family = AF_UNSPEC;
+    hints.ai_socktype = SOCK_STREAM;
+    addrinfo* res = nullptr;
+    const std::string portStr = std::to_string(port);
+    if (int rc = ::getaddrinfo(host.c_str(), portStr.c_str(), &hints, &res); rc != 0) {
+        if (error) *error = gai_strerror(rc);
+        return false;
+    }
+
+    for (addrinfo* a = res; a; a = a->ai_next) {
+        int s = ::socket(a->ai_family, a->ai_socktype, a->ai_protocol);
+        if (s < 0) continue;
+        if (::connect(s, a->ai_addr, a->ai_addrlen) == 0) {
+            fd = s;
+            break;
+        }
+        ::close(s);
+    }
+    ::freeaddrinfo(res);
+
+    if (fd < 0) {
+        if (error) *error = std::strerror(errno);
+        return false;
+    }
+    int one = 1;
+    ::setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &one, sizeof(one));   // маленькие запросы-ответы
+#ifdef SO_NOSIGPIPE
+    ::setsockopt(fd, SOL_SOCKET, SO_NOSIGPIPE, &one, sizeof(one));
+#endif
+    inbuf.clear();
+    return true;
+}
+
+void BankClient::close() {
+    if (fd >= 0) ::close(fd);
+    fd = -1;
+}
+
+bool BankClient::call(json request, json& response) {
+    if (fd < 0) return false;
+
+    const long long id = nextId++;
+    request["id"] = id;
+    std::string line = request.dump();
+    line += '\n';
+
+    std::size_t sent = 0;
+    while (sent < line.size()) {
+#ifdef MSG_NOSIGNAL
+        ssize_t n = ::send(fd, line.data() + sent, line.size() - sent, MSG_NOSIGNAL);
+#else
+        ssize_t n = ::send(fd, line.data() + sent, line.size() - sent, 0);
+#endif
+        if (n < 0 && errno == EINTR) continue;
+        if (n <= 0) { close(); return false; }
+        sent += (std::size_t)n;
+    }
+
+    // ответы приходят по порядку: читаем строки, пока не встретим свой id
+    for (;;) {
+        std::size_t nl;
+        while ((nl = inbuf.find('\n')) != std::string::npos) {
+            std::string got = inbuf.substr(0, nl);
+            inbuf.erase(0, nl + 1);
+            try {
+                response = json::parse(got);
+            } catch (...) {
+                close();
+                return false;
+            }
+            if (response.value("id", 0LL) == id) return true;
+        }
+
+        char buf[16 * 1024];
+        ssize_t n = ::recv(fd, buf, sizeof(buf), 0);
+        if (n < 0 && errno == EINTR) continue;
+        if (n <= 0) { close(); return false; }
+        inbuf.append(buf, (std::size_t)n);
+    }
+}
@@ -0,0 +1,232 @@
+#include "BankService.h"
+
+#include <algorithm>
+
+static constexpr std::size_t MAX_HISTORY_PAGE = 1000;   // одна строка ответа не растёт без предела
+
+static json error(const std::string& msg) {
+    return { { "ok", false }, { "error", msg } };
+}
+
+static json customerJson(const Customer& c) {
+    json j = json::object();
+    j["customerId"] = c.getId();
+    j["firstName"]  = c.getFirstName();
+    j["lastName"]   = c.getLastName();
+    j["age"]        = c.getAge();
+    j["email"]      = c.getEmail();
+    j["phone"]      = c.getPhone();
+    j["accounts"]   = json::array();
+    for (const auto& a : c.getAccounts()) {
+        j["accounts"].push_back({
+            { "accId", a.getId() },
+            { "type", accountTypeName(a.getType()) },
+            { "currency", a.getBalance().currency().str() },
+            { "balance", a.getBalance().toString() },
+            { "balanceMinor", a.getBalance().minorUnits() }
+        });
+    }
+    return j;
+}
+
+// "amount": "12.50" (exact) / 12.5, or "amountMinor": 1250
+static bool readAmount(const json& req, CurrencyCode cur, Money& out) {
+    if (req.contains("amountMinor") && req["amountMinor"].is_number_integer()) {
+        out = Money(req["amountMinor"].get<std::int64_t>(), cur);
+        return true;
+    }
+    if (!req.contains("amount")) return false;
+    const json& a = req["amount"];
+    if (a.is_string()) return Money::parse(a.get<std::string>(), cur, out);
+    if (a.is_number()) {
+        out = Money::fromMajor(a.get<double>(), cur);
+        return true;
+    }
+    return false;
+}
+
+// customerId из запроса; без него - клиент сессии
+static bool ownCustomer(const json& req, const BankService::Session& s) {
+    return req.value("customerId", s.customerId) == s.customerId;
+}
+
+std::string BankService::handleLine(const std::string& line, Session& session) {
+    json req;
+    try {
+        req = json::parse(line);
+    } catch (...) {
+        return error("Malformed request.").dump();
+    }
+    return handle(req, session).dump();
+}
+
+json BankService::handle(const json& req, Session& session) {
+    json res;
+    if (!req.is_object()) return error("Malformed request.");
+
+    try {
+        const std::string op = req.value("op", "");
+        if      (op == "ping")       res = { { "ok", true } };
+        else if (op == "login")      res = login(req, session);
+        else if (session.customerId.empty()) res = error("Not logged in.");
+        else if (op == "customer")   res = customer(req, session);
+        else if (op == "deposit")    res = depositOrWithdraw(req, session, true);
+        else if (op == "withdraw")   res = depositOrWithdraw(req, session, false);
+        else if (op == "transfer")   res = transfer(req, session);
+        else if (op == "history")    res = history(req, session);
+        else if (op == "findByName") res = findByName(req);
+        else if (op == "recipient")  res = recipient(req);
+        else if (op == "logFailure") res = logFailure(req, session);
+        else                         res = error("Unknown op \"" + op + "\".");
+    } catch (const std::exception& e) {
+        // неверные типы полей и т.п. -> ошибка запроса, а не падение сервера
+        res = error(std::string("Bad request: ") + e.what());
+    }
+
+    if (req.contains("id")) res["id"] = req["id"];
+    return res;
+}
+
+bool BankService::owns(const Session& s, int accId) {
+    for (int id : s.accIds) {
+        if (id == accId) return true;
+    }
+    // счёт, открытый после входа: спрашиваем базу
+    AccountLocation loc;
+    return db.findAccountOwner(accId, loc) && loc.customerId == s.customerId;
+}
+
+bool BankService::durable() {
+    return db.durable().get();
+}
+
+json BankService::login(const json& req, Session& s) {
+    const std::string id = req.value("customerId", "");
+    if (!db.verifySecret(id, req.value("secret", ""))) return error("Invalid ID or secret.");
+    if (req.contains("phone") && !db.verifyPhone(id, req.value("phone", ""))) return error("Phone mismatch.");
+
+    // проценты на Savings при входе - как в приложении без сервера
+    if (!db.accrueCustomerInterest(id, Date::today())) return error("Failed to save.");
+    if (!durable()) return error("Failed to save.");
+
+    Customer c;
+    if (!db.loadCustomer(id, c)) return error("Failed to load profile.");
+
+    // неудачный вход прежнюю сессию не сбрасывает
+    s.customerId = id;
+    s.accIds.clear();
+    for (const auto& a : c.getAccounts()) s.accIds.push_back(a.getId());
+    return { { "ok", true }, { "customer", customerJson(c) } };
+}
+
+json BankService::customer(const json& req, const Session& s) {
+    if (!ownCustomer(req, s)) return error("Access denied.");
+    Customer c;
+    if (!db.loadCustomer(s.customerId, c)) return error("Customer not found.");
+    return { { "ok", true }, { "customer", customerJson(c) } };
+}
+
+json BankService::depositOrWithdraw(const json& req, const Session& s, bool deposit) {
+    const int accId = req.value("accId", 0);
+    if (!deposit && !owns(s, accId)) return error("Access denied.");
+
+    // валюта счёта - из ledger, без блокировки базы
+    Money balance;
+    if (!db.readBalance(accId, balance)) return error("Account not found.");
+
+    Money amount;
+    if (!readAmount(req, balance.currency(), amount) || !amount.isPositive())
+        return error("Invalid amount.");
+
+    std::string err;
+    const bool ok = deposit ? db.deposit(accId, amount, &err, &balance)
+                            : db.withdraw(accId, amount, &err, &balance);
+    if (!ok) return error(err);
+    if (!durable()) return error("Failed to save.");
+    return { { "ok", true }, { "balance", balance.toString() } };
+}
+
+json BankService::transfer(const json& req, const Session& s) {
+    const int fromAccId = req.value("fromAccId", 0);
+    const int toAccId   = req.value("toAccId", 0);
+    if (!owns(s, fromAccId)) return error("Access denied.");
+    if (fromAccId == toAccId) return error("Source and destination are the same account.");
+
+    Money amount;
+    if (!readAmount(req, EUR, amount) || !amount.isPositive()) return error("Invalid amount.");
+
+    json entry = json::object();
+    entry["mode"]   = req.value("mode", "by_account_id");
+    entry["target"] = req.value("target", std::to_string(toAccId));
+
+    std::string err;
+    if (!db.transfer(fromAccId, toAccId, amount, entry, &err)) {
+        logFailed(s, fromAccId, amount, std::move(entry), err);
+        return error(err);
+    }
+    if (!durable()) return error("Failed to save.");
+    return { { "ok", true } };
+}
+
+// как в UI: неудачный перевод тоже попадает в историю отправителя
+void BankService::logFailed(const Session& s, int fromAccId, const Money& amount, json entry,
+                            const std::string& err) {
+    entry["status"] = "failed";
+    entry["error"] = err;
+    entry["fromCustomerId"] = s.customerId;
+    entry["fromAccId"] = fromAccId;
+    entry["toCustomerId"] = "";
+    entry["toAccId"] = 0;
+    entry["amountMinor"] = amount.minorUnits();
+    entry["amount"] = amount.toMajor();
+    db.appendTransferLog(entry);
+}
+
+json BankService::logFailure(const json& req, const Session& s) {
+    const int fromAccId = req.value("fromAccId", 0);
+    if (!owns(s, fromAccId)) return error("Access denied.");
+
+    // сумма как её ввели: может быть и нулевой, и отрицательной
+    Money amount(0, EUR);
+    if (req.contains("amountMinor") || req.contains("amount")) readAmount(req, EUR, amount);
+
+    json entry = json::object();
+    entry["mode"]   = req.value("mode", "by_account_id");
+    entry["target"] = req.value("target", "");
+    logFailed(s, fromAccId, amount, std::move(entry), req.value("error", "Transfer failed."));
+    return { { "ok", true } };
+}
+
+json BankService::history(const json& req, const Session& s) {
+    if (!ownCustomer(req, s)) return error("Access denied.");
+    const std::string& id = s.customerId;
+    const int days = req.value("days", 0);
+    const std::size_t limit = std::min(req.value("limit", (std::size_t)50), MAX_HISTORY_PAGE);
+    const std::size_t cursor = req.value("cursor", (std::size_t)0);
+
+    TransferPage page = db.queryTransfers(id, DatabaseManager::sinceTsForDaysBack(days), limit, cursor);
+    json items = json::array();
+    for (const auto& r : page.items) {
+        items.push_back({
+            { "ts", r.ts }, { "status", r.status }, { "mode", r.mode },
+            { "fromAccId", r.fromAccId }, { "toAccId", r.toAccId },
+            { "amount", r.amount.toString() }, { "target", r.target }, { "error", r.error }
+        });
+    }
+    return { { "ok", true }, { "items", std::move(items) }, { "hasMore", page.hasMore },
+             { "nextCursor", page.nextCursor } };
+}
+
+json BankService::findByName(const json& req) {
+    std::vector<std::string> ids = db.findCustomersByName(req.value("firstName", ""),
+                                                           req.value("lastName", ""));
+    return { { "ok", true }, { "customerIds", ids } };
+}
+
+json BankService::recipient(const json& req) {
+    Customer c;
+    if (!db.loadCustomer(req.value("customerId", ""), c)) return error("Failed to load recipient.");
+    const Account* a = c.incomingAccount();
+    if (!a) return error("Recipient has no accounts.");
+    return { { "ok", true }, { "accId", a->getId() }, { "currency", a->getBalance().currency().str() } };
+}
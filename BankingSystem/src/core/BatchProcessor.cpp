@@ -0,0 +1,313 @@
+#include "BatchProcessor.h"
+
+#include <algorithm>
+#include <cctype>
+#include <chrono>
+#include <stdexcept>
+#include <vector>
+
+#include "Customer.h"
+#include "Account.h"
+
+// ---------------------- helpers ----------------------
+static std::string trim_copy(std::string s) {
+    auto notSpace = [](unsigned char c){ return !std::isspace(c); };
+    s.erase(s.begin(), std::find_if(s.begin(), s.end(), notSpace));
+    s.erase(std::find_if(s.rbegin(), s.rend(), notSpace).base(), s.end());
+    return s;
+}
+
+// RFC4180-ish: commas split fields, "..." may contain commas, "" is a quote
+static std::vector<std::string> splitCsv(const std::string& line) {
+    std::vector<std::string> out(1);
+    bool quoted = false;
+    for (std::size_t i = 0; i < line.size(); ++i) {
+        char ch = line[i];
+        if (quoted) {
+            if (ch == '"' && i + 1 < line.size() && line[i + 1] == '"') { out.back() += '"'; ++i; }
+            else if (ch == '"') quoted = false;
+            else out.back() += ch;
+        } else if (ch == '"') {
+            quoted = true;
+        } else if (ch == ',') {
+            out.emplace_back();
+        } else {
+            out.back() += ch;
+        }
+    }
+    for (auto& f : out) f = trim_copy(f);
+    return out;
+}
+
+static std::string csvQuote(const std::string& s) {
+    if (s.find_first_of(",\"\n") == std::string::npos) return s;
+    std::string q = "\"";
+    for (char ch : s) { if (ch == '"') q += '"'; q += ch; }
+    return q + "\"";
+}
+
+static bool parseAccId(const std::string& s, int& out) {
+    if (s.empty() || s.size() > 9) return false;
+    for (char ch : s) if (ch < '0' || ch > '9') return false;
+    out = std::stoi(s);
+    return out > 0;
+}
+
+static long long nowEpochMs() {
+    using namespace std::chrono;
+    return duration_cast<milliseconds>(system_clock::now().time_since_epoch()).count();
+}
+
+static double msSince(std::chrono::steady_clock::time_point t0) {
+    return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - t0).count();
+}
+
+static Account* accountIn(Customer& c, const AccountLocation& loc, int accId) {
+    auto& accs = c.getAccounts();
+    if (loc.slot >= 0 && loc.slot < (int)accs.size() && accs[loc.slot].getId() == accId)
+        return &accs[loc.slot];
+    for (auto& a : accs) if (a.getId() == accId) return &a;
+    return nullptr;
+}
+
+// ---------------------- BatchProcessor ----------------------
+BatchProcessor::BatchProcessor(DatabaseManager& db) : db(db) {}
+
+bool BatchProcessor::parseLine(const std::string& rawLine, BatchFormat format,
+                               BatchOp& out, std::string& outError) {
+    outError.clear();
+    const std::string line = trim_copy(rawLine);
+    if (line.empty() || line[0] == '#') return false;
+
+    BatchOp op;
+    std::string acc, to;
+
+    if (format == BatchFormat::Csv) {
+        auto f = splitCsv(line);
+        f.resize(std::max<std::size_t>(f.size(), 6));
+        if (f[0] == "op") return false;   // header
+        op.op = f[0]; acc = f[1]; op.amount = f[2]; to = f[3]; op.currency = f[4]; op.ref = f[5];
+    } else {
+        json j;
+        try { j = json::parse(line); } catch (...) { outError = "Invalid JSON."; return false; }
+        if (!j.is_object()) { outError = "Invalid JSON."; return false; }
+
+        auto text = [&](const char* key) -> std::string {
+            if (!j.contains(key)) return "";
+            const json& v = j[key];
+            if (v.is_string()) return trim_copy(v.get<std::string>());
+            if (v.is_number()) return v.dump();
+            return "?";
+        };
+        op.op = text("op"); acc = text("account"); to = text("to");
+        op.amount = text("amount"); op.currency = text("currency"); op.ref = text("ref");
+    }
+
+    std::transform(op.op.begin(), op.op.end(), op.op.begin(),
+                   [](unsigned char c){ return (char)std::tolower(c); });
+    if (op.op != "deposit" && op.op != "withdraw" && op.op != "transfer") {
+        outError = "Unknown op.";
+        return false;
+    }
+    if (!parseAccId(acc, op.accId)) { outError = "Invalid account."; return false; }
+    if (op.op == "transfer" && !parseAccId(to, op.toAccId)) {
+        outError = "Invalid destination account.";
+        return false;
+    }
+    out = std::move(op);
+    return true;
+}
+
+BatchResult BatchProcessor::apply(const BatchOp& op) {
+    if (op.op == "transfer") return transfer(op);
+    return deposit(op, op.op == "withdraw");
+}
+
+BatchResult BatchProcessor::deposit(const BatchOp& op, bool withdraw) {
+    BatchResult r;
+    r.line = op.line; r.op = op.op; r.ref = op.ref;
+
+    AccountLocation loc;
+    Customer cust;
+    if (!db.findAccountOwner(op.accId, loc) || !db.loadCustomer(loc.customerId, cust)) {
+        r.error = "Account not found.";
+        return r;
+    }
+    Account* acc = accountIn(cust, loc, op.accId);
+    if (!acc) { r.error = "Account not found."; return r; }
+
+    const CurrencyCode cur = acc->getBalance().currency();
+    if (!op.currency.empty() && CurrencyCode::fromString(op.currency) != cur) {
+        r.error = "Currency mismatch.";
+        return r;
+    }
+    Money amount;
+    if (!Money::parse(op.amount, cur, amount)) { r.error = "Invalid amount."; return r; }
+    if (!amount.isPositive()) { r.error = "Amount must be positive."; return r; }
+
+    try {
+        if (withdraw) {
+            if (acc->getBalance() < amount) { r.error = "Insufficient funds."; return r; }
+            acc->setBalance(acc->getBalance() - amount);
+        } else {
+            acc->setBalance(acc->getBalance() + amount);
+        }
+    } catch (const std::exception& e) {
+        r.error = e.what();
+        return r;
+    }
+
+    if (!db.addOrUpdateCustomer(cust)) { r.error = "Failed to save customer."; return r; }
+    r.ok = true;
+    r.balanceAfter = acc->getBalance();
+    return r;
+}
+
+void BatchProcessor::logTransfer(const BatchOp& op, const std::string& fromCustomerId,
+                                 const std::string& toCustomerId, const Money& amount,
+                                 const std::string& error) {
+    // same shape as the Transfers tab writes
+    json e = json::object();
+    e["ts"] = nowEpochMs();
+    e["status"] = error.empty() ? "ok" : "failed";
+    e["mode"] = "by_account_id";
+    e["fromCustomerId"] = fromCustomerId;
+    e["fromAccId"] = op.accId;
+    e["toCustomerId"] = toCustomerId;
+    e["toAccId"] = error.empty() ? op.toAccId : 0;
+    e["amountMinor"] = amount.minorUnits();
+    e["amount"] = amount.toMajor();
+    e["target"] = std::to_string(op.toAccId);
+    e["error"] = error;
+    if (!op.ref.empty()) e["ref"] = op.ref;
+    db.appendTransferLog(e);
+}
+
+BatchResult BatchProcessor::transfer(const BatchOp& op) {
+    BatchResult r;
+    r.line = op.line; r.op = op.op; r.ref = op.ref;
+
+    AccountLocation fromLoc;
+    Customer fromCust;
+    if (!db.findAccountOwner(op.accId, fromLoc) || !db.loadCustomer(fromLoc.customerId, fromCust)) {
+        r.error = "Account not found.";
+        return r;
+    }
+    Account* from = accountIn(fromCust, fromLoc, op.accId);
+    if (!from) { r.error = "Account not found."; return r; }
+
+    const CurrencyCode cur = from->getBalance().currency();
+    Money amount;
+    if (!Money::parse(op.amount, cur, amount)) amount = Money(0, cur);
+
+    // с этого места источник известен -> неудачи попадают в историю, как в UI
+    auto fail = [&](const std::string& err) {
+        logTransfer(op, fromLoc.customerId, "", amount, err);
+        r.error = err;
+        return r;
+    };
+
+    if (!op.currency.empty() && CurrencyCode::fromString(op.currency) != cur) return fail("Currency mismatch.");
+    if (!amount.isPositive()) return fail("Invalid amount.");
+    if (op.toAccId == op.accId) return fail("Source and destination are the same account.");
+    if (from->getBalance() < amount) return fail("Insufficient funds.");
+
+    AccountLocation toLoc;
+    if (!db.findAccountOwner(op.toAccId, toLoc)) return fail("Destination account not found.");
+
+    // перевод между своими счетами: один Customer, иначе второй save затёр бы первый
+    const bool sameOwner = toLoc.customerId == fromLoc.customerId;
+    Customer toCustStorage;
+    if (!sameOwner && !db.loadCustomer(toLoc.customerId, toCustStorage)) return fail("Failed to load recipient.");
+    Customer& toCust = sameOwner ? fromCust : toCustStorage;
+
+    Account* to = accountIn(toCust, toLoc, op.toAccId);
+    if (!to) return fail("Destination account vanished.");
+    if (to->getBalance().currency() != cur) return fail("Destination account currency differs.");
+
+    try {
+        Money newTo = to->getBalance() + amount;
+        from->setBalance(from->getBalance() - amount);
+        to->setBalance(newTo);
+    } catch (const std::exception& e) {
+        return fail(e.what());
+    }
+
+    if (!db.addOrUpdateCustomer(fromCust) || (!sameOwner && !db.addOrUpdateCustomer(toCust))) {
+        r.error = "Failed to save customer.";
+        return r;
+    }
+    logTransfer(op, fromLoc.customerId, toLoc.customerId, amount, "");
+
+    r.ok = true;
+    r.balanceAfter = from->getBalance();
+    return r;
+}
+
+void BatchProcessor::writeResultHeader(std::ostream& out) {
+    out << "line,op,ref,status,balance,error\n";
+}
+
+void BatchProcessor::writeResult(std::ostream& out, const BatchResult& r) {
+    out << r.line << ',' << csvQuote(r.op) << ',' << csvQuote(r.ref) << ','
+        << (r.ok ? "ok" : "failed") << ','
+        << (r.ok ? r.balanceAfter.toString() : std::string()) << ','
+        << csvQuote(r.error) << '\n';
+}
+
+bool BatchProcessor::run(std::istream& in, BatchFormat format, std::ostream& results,
+                         std::size_t batchSize, BatchStats& stats) {
+    const auto t0 = std::chrono::steady_clock::now();
+    writeResultHeader(results);
+
+    bool ok = true;
+    std::size_t inBatch = 0;
+    std::vector<BatchResult> pending;   // результаты открытого батча: "ok" только после записи
+
+    auto flush = [&]() {
+        if (db.inBatch()) {
+            const auto tp = std::chrono::steady_clock::now();
+            if (!db.commitBatch()) ok = false;
+            stats.persistMs += msSince(tp);
+            ++stats.batches;
+        }
+        for (auto& r : pending) {
+            if (!ok && r.ok) { r.ok = false; r.error = "Batch not persisted."; }
+            if (r.ok) ++stats.ok; else ++stats.failed;
+            writeResult(results, r);
+        }
+        pending.clear();
+        inBatch = 0;
+    };
+
+    std::string line;
+    std::size_t lineNo = 0;
+    while (ok && std::getline(in, line)) {
+        ++lineNo;
+
+        BatchOp op;
+        std::string err;
+        BatchResult r;
+        if (!parseLine(line, format, op, err)) {
+            if (err.empty()) continue;
+            r.line = lineNo;
+            r.error = err;
+        } else {
+            op.line = lineNo;
+            if (!db.inBatch() && !db.beginBatch()) { ok = false; break; }
+
+            const auto ta = std::chrono::steady_clock::now();
+            r = apply(op);
+            stats.applyMs += msSince(ta);
+            ++inBatch;
+        }
+
+        ++stats.ops;
+        pending.push_back(std::move(r));
+        if (batchSize > 0 && inBatch >= batchSize) flush();
+    }
+    flush();
+
+    stats.totalMs = msSince(t0);
+    return ok;
+}
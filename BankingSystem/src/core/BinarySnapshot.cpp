@@ -0,0 +1,536 @@
+#include "BinarySnapshot.h"
+#include "Profiler.h"
+
+#include <cstring>
+#include <fstream>
+#include <filesystem>
+#include <limits>
+#include <stdexcept>
+#include <unordered_map>
+#include <vector>
+
+#if !defined(_WIN32) && !defined(_WIN64)
+#  include <fcntl.h>
+#  include <sys/mman.h>
+#  include <sys/stat.h>
+#  include <unistd.h>
+#endif
+
+namespace fs = std::filesystem;
+
+// ---------------------- layout ----------------------
+namespace {
+
+enum Col : int {
+    STR_OFFSETS, STR_BYTES,
+    // customers
+    C_ID, C_FIRST, C_LAST, C_NAME, C_EMAIL, C_SECRET, C_PHONE,
+    C_AGE, C_ACC_BEGIN, C_ACC_COUNT, C_MASK, C_EXTRA,
+    // accounts
+    A_ID, A_TYPE, A_BAL_MINOR, A_BAL, A_CUR, A_RATE, A_DATE, A_MASK, A_EXTRA,
+    // transfers
+    T_TS, T_FROM_C, T_TO_C, T_FROM_A, T_TO_A, T_AMT_MINOR, T_AMT,
+    T_STATUS, T_MODE, T_TARGET, T_ERROR, T_MASK, T_EXTRA,
+    COL_COUNT
+};
+
+const char MAGIC[8] = { 'B', 'K', 'S', 'N', 'A', 'P', '0', '1' };
+constexpr std::uint32_t VERSION = 1;
+constexpr std::uint32_t ENDIAN_TAG = 0x01020304;
+
+struct Header {
+    char magic[8];
+    std::uint32_t version;
+    std::uint32_t endianTag;
+    std::uint64_t srcSize;
+    std::int64_t srcMtimeNs;
+    std::uint64_t srcInode;
+    std::uint64_t nStrings, nCustomers, nAccounts, nTransfers;
+    std::uint32_t rootExtra;
+    std::uint32_t reserved;
+    std::uint64_t colOffset[COL_COUNT];
+    std::uint64_t colBytes[COL_COUNT];
+};
+
+// presence bits: a key is written back only if it was there
+enum : std::uint32_t {
+    CM_FIRST = 1u << 0, CM_LAST = 1u << 1, CM_NAME = 1u << 2, CM_EMAIL = 1u << 3,
+    CM_SECRET = 1u << 4, CM_PHONE = 1u << 5, CM_AGE = 1u << 6, CM_ACCOUNTS = 1u << 7
+};
+enum : std::uint32_t {
+    AM_ID = 1u << 0, AM_TYPE = 1u << 1, AM_BAL_MINOR = 1u << 2, AM_BAL = 1u << 3,
+    AM_CUR = 1u << 4, AM_RATE = 1u << 5, AM_DATE = 1u << 6
+};
+enum : std::uint32_t {
+    TM_TS = 1u << 0, TM_FROM_C = 1u << 1, TM_TO_C = 1u << 2, TM_FROM_A = 1u << 3,
+    TM_TO_A = 1u << 4, TM_AMT_MINOR = 1u << 5, TM_AMT = 1u << 6, TM_STATUS = 1u << 7,
+    TM_MODE = 1u << 8, TM_TARGET = 1u << 9, TM_ERROR = 1u << 10
+};
+
+// Interned strings; index 0 is always ""
+struct StringPool {
+    std::string bytes;
+    std::vector<std::uint64_t> offsets{ 0, 0 };   // string 0 = ""
+    std::unordered_map<std::string, std::uint32_t> ids{ { "", 0 } };
+
+    std::uint32_t intern(const std::string& s) {
+        auto it = ids.find(s);
+        if (it != ids.end()) return it->second;
+        std::uint32_t id = (std::uint32_t)(offsets.size() - 1);
+        bytes += s;
+        offsets.push_back(bytes.size());
+        ids.emplace(s, id);
+        return id;
+    }
+};
+
+struct Columns {
+    std::vector<std::uint32_t> cId, cFirst, cLast, cName, cEmail, cSecret, cPhone, cMask, cExtra, cAccCount;
+    std::vector<std::int32_t> cAge;
+    std::vector<std::uint64_t> cAccBegin;
+
+    std::vector<std::int32_t> aId;
+    std::vector<std::uint32_t> aType, aCur, aDate, aMask, aExtra;
+    std::vector<std::int64_t> aBalMinor;
+    std::vector<double> aBal, aRate;
+
+    std::vector<std::int64_t> tTs, tAmtMinor;
+    std::vector<std::uint32_t> tFromC, tToC, tStatus, tMode, tTarget, tError, tMask, tExtra;
+    std::vector<std::int32_t> tFromA, tToA;
+    std::vector<double> tAmt;
+};
+
+// Read-only view of a file: mmap where available, plain read otherwise
+class MappedFile {
+private:
+    const unsigned char* ptr = nullptr;
+    std::size_t len = 0;
+#if !defined(_WIN32) && !defined(_WIN64)
+    void* map = nullptr;
+#endif
+    std::vector<unsigned char> buffer;
+
+public:
+    MappedFile() = default;
+    MappedFile(const MappedFile&) = delete;
+    MappedFile& operator=(const MappedFile&) = delete;
+
+    ~MappedFile() {
+#if !defined(_WIN32) && !defined(_WIN64)
+        if (map) ::munmap(map, len);
+#endif
+    }
+
+    bool open(const std::string& path) {
+#if !defined(_WIN32) && !defined(_WIN64)
+        int fd = ::open(path.c_str(), O_RDONLY);
+        if (fd < 0) return false;
+        struct stat sb{};
+        if (::fstat(fd, &sb) != 0 || sb.st_size <= 0) { ::close(fd); return false; }
+        len = (std::size_t)sb.st_size;
+        map = ::mmap(nullptr, len, PROT_READ, MAP_PRIVATE, fd, 0);
+        ::close(fd);
+        if (map == MAP_FAILED) { map = nullptr; len = 0; return false; }
+        ptr = (const unsigned char*)map;
+        return true;
+#else
+        std::ifstream in(path, std::ios::binary);
+        if (!in) return false;
+        buffer.assign(std::istreambuf_iterator<char>(in), std::istreambuf_iterator<char>());
+        ptr = buffer.data();
+        len = buffer.size();
+        return len > 0;
+#endif
+    }
+
+    const unsigned char* data() const { return ptr; }
+    std::size_t size() const { return len; }
+};
+
+} // namespace
+
+// ---------------------- helpers ----------------------
+static bool asI32(const json& v, std::int32_t& out) {
+    if (!v.is_number_integer()) return false;
+    if (v.is_number_unsigned()) {
+        std::uint64_t u = v.get<std::uint64_t>();
+        if (u > (std::uint64_t)std::numeric_limits<std::int32_t>::max()) return false;
+        out = (std::int32_t)u;
+        return true;
+    }
+    std::int64_t x = v.get<std::int64_t>();
+    if (x < std::numeric_limits<std::int32_t>::min() || x > std::numeric_limits<std::int32_t>::max()) return false;
+    out = (std::int32_t)x;
+    return true;
+}
+
+static bool asI64(const json& v, std::int64_t& out) {
+    if (!v.is_number_integer()) return false;
+    if (v.is_number_unsigned()) {
+        std::uint64_t u = v.get<std::uint64_t>();
+        if (u > (std::uint64_t)std::numeric_limits<std::int64_t>::max()) return false;
+        out = (std::int64_t)u;
+        return true;
+    }
+    out = v.get<std::int64_t>();
+    return true;
+}
+
+static bool asStr(const json& v, StringPool& pool, std::uint32_t& out) {
+    if (!v.is_string()) return false;
+    out = pool.intern(v.get_ref<const std::string&>());
+    return true;
+}
+
+static bool asF64(const json& v, double& out) {
+    if (!v.is_number_float()) return false;   // ints stay ints (via extra)
+    out = v.get<double>();
+    return true;
+}
+
+static std::uint32_t internExtra(const json& extra, StringPool& pool) {
+    return extra.empty() ? 0 : pool.intern(extra.dump());
+}
+
+static bool addAccount(const json& a, StringPool& pool, Columns& c) {
+    if (!a.is_object()) return false;
+
+    std::int32_t id = 0; std::uint32_t type = 0, cur = 0, date = 0, mask = 0;
+    std::int64_t balMinor = 0; double bal = 0.0, rate = 0.0;
+    json extra = json::object();
+
+    for (auto it = a.begin(); it != a.end(); ++it) {
+        const std::string& k = it.key();
+        const json& v = it.value();
+        bool taken = false;
+        if      (k == "accId")         { taken = asI32(v, id);          if (taken) mask |= AM_ID; }
+        else if (k == "type")          { taken = asStr(v, pool, type);  if (taken) mask |= AM_TYPE; }
+        else if (k == "balanceMinor")  { taken = asI64(v, balMinor);    if (taken) mask |= AM_BAL_MINOR; }
+        else if (k == "balance")       { taken = asF64(v, bal);         if (taken) mask |= AM_BAL; }
+        else if (k == "currency")      { taken = asStr(v, pool, cur);   if (taken) mask |= AM_CUR; }
+        else if (k == "savingsRate")   { taken = asF64(v, rate);        if (taken) mask |= AM_RATE; }
+        else if (k == "lastSavedDate") { taken = asStr(v, pool, date);  if (taken) mask |= AM_DATE; }
+        if (!taken) extra[k] = v;
+    }
+
+    c.aId.push_back(id); c.aType.push_back(type); c.aBalMinor.push_back(balMinor);
+    c.aBal.push_back(bal); c.aCur.push_back(cur); c.aRate.push_back(rate);
+    c.aDate.push_back(date); c.aMask.push_back(mask);
+    c.aExtra.push_back(internExtra(extra, pool));
+    return true;
+}
+
+static bool addCustomer(const std::string& id, const json& cust, StringPool& pool, Columns& c) {
+    if (!cust.is_object()) return false;
+
+    std::uint32_t first = 0, last = 0, name = 0, email = 0, secret = 0, phone = 0, mask = 0;
+    std::int32_t age = 0;
+    std::uint64_t accBegin = c.aId.size();
+    std::uint32_t accCount = 0;
+    json extra = json::object();
+
+    for (auto it = cust.begin(); it != cust.end(); ++it) {
+        const std::string& k = it.key();
+        const json& v = it.value();
+        bool taken = false;
+        if      (k == "firstName")  { taken = asStr(v, pool, first);  if (taken) mask |= CM_FIRST; }
+        else if (k == "lastName")   { taken = asStr(v, pool, last);   if (taken) mask |= CM_LAST; }
+        else if (k == "name")       { taken = asStr(v, pool, name);   if (taken) mask |= CM_NAME; }
+        else if (k == "email")      { taken = asStr(v, pool, email);  if (taken) mask |= CM_EMAIL; }
+        else if (k == "secretWord") { taken = asStr(v, pool, secret); if (taken) mask |= CM_SECRET; }
+        else if (k == "phone")      { taken = asStr(v, pool, phone);  if (taken) mask |= CM_PHONE; }
+        else if (k == "age")        { taken = asI32(v, age);          if (taken) mask |= CM_AGE; }
+        else if (k == "accounts" && v.is_array()) {
+            bool allObjects = true;
+            for (const auto& a : v) if (!a.is_object()) { allObjects = false; break; }
+            if (allObjects) {
+                for (const auto& a : v) addAccount(a, pool, c);
+                accCount = (std::uint32_t)v.size();
+                mask |= CM_ACCOUNTS;
+                taken = true;
+            }
+        }
+        if (!taken) extra[k] = v;
+    }
+
+    c.cId.push_back(pool.intern(id));
+    c.cFirst.push_back(first); c.cLast.push_back(last); c.cName.push_back(name);
+    c.cEmail.push_back(email); c.cSecret.push_back(secret); c.cPhone.push_back(phone);
+    c.cAge.push_back(age); c.cAccBegin.push_back(accBegin); c.cAccCount.push_back(accCount);
+    c.cMask.push_back(mask); c.cExtra.push_back(internExtra(extra, pool));
+    return true;
+}
+
+static bool addTransfer(const json& e, StringPool& pool, Columns& c) {
+    if (!e.is_object()) return false;
+
+    std::int64_t ts = 0, amtMinor = 0; double amt = 0.0;
+    std::uint32_t fromC = 0, toC = 0, status = 0, mode = 0, target = 0, error = 0, mask = 0;
+    std::int32_t fromA = 0, toA = 0;
+    json extra = json::object();
+
+    for (auto it = e.begin(); it != e.end(); ++it) {
+        const std::string& k = it.key();
+        const json& v = it.value();
+        bool taken = false;
+        if      (k == "ts")             { taken = asI64(v, ts);            if (taken) mask |= TM_TS; }
+        else if (k == "fromCustomerId") { taken = asStr(v, pool, fromC);   if (taken) mask |= TM_FROM_C; }
+        else if (k == "toCustomerId")   { taken = asStr(v, pool, toC);     if (taken) mask |= TM_TO_C; }
+        else if (k == "fromAccId")      { taken = asI32(v, fromA);         if (taken) mask |= TM_FROM_A; }
+        else if (k == "toAccId")        { taken = asI32(v, toA);           if (taken) mask |= TM_TO_A; }
+        else if (k == "amountMinor")    { taken = asI64(v, amtMinor);      if (taken) mask |= TM_AMT_MINOR; }
+        else if (k == "amount")         { taken = asF64(v, amt);           if (taken) mask |= TM_AMT; }
+        else if (k == "status")         { taken = asStr(v, pool, status);  if (taken) mask |= TM_STATUS; }
+        else if (k == "mode")           { taken = asStr(v, pool, mode);    if (taken) mask |= TM_MODE; }
+        else if (k == "target")         { taken = asStr(v, pool, target);  if (taken) mask |= TM_TARGET; }
+        else if (k == "error")          { taken = asStr(v, pool, error);   if (taken) mask |= TM_ERROR; }
+        if (!taken) extra[k] = v;
+    }
+
+    c.tTs.push_back(ts); c.tFromC.push_back(fromC); c.tToC.push_back(toC);
+    c.tFromA.push_back(fromA); c.tToA.push_back(toA); c.tAmtMinor.push_back(amtMinor);
+    c.tAmt.push_back(amt); c.tStatus.push_back(status); c.tMode.push_back(mode);
+    c.tTarget.push_back(target); c.tError.push_back(error); c.tMask.push_back(mask);
+    c.tExtra.push_back(internExtra(extra, pool));
+    return true;
+}
+
+// ---------------------- write ----------------------
+bool BinarySnapshot::write(const json& root, const SnapshotSource& source, const std::string& path) {
+    if (!root.is_object() || !root.contains("customers") || !root["customers"].is_object() ||
+        !root.contains("transfers") || !root["transfers"].is_array())
+        return false;
+
+    StringPool pool;
+    Columns c;
+
+    const json& custs = root["customers"];
+    for (auto it = custs.begin(); it != custs.end(); ++it)
+        if (!addCustomer(it.key(), it.value(), pool, c)) return false;
+    for (const auto& e : root["transfers"])
+        if (!addTransfer(e, pool, c)) return false;
+
+    json rootExtra = json::object();
+    for (auto it = root.begin(); it != root.end(); ++it)
+        if (it.key() != "customers" && it.key() != "transfers") rootExtra[it.key()] = it.value();
+
+    Header h{};
+    std::memcpy(h.magic, MAGIC, sizeof(MAGIC));
+    h.version = VERSION;
+    h.endianTag = ENDIAN_TAG;
+    h.srcSize = source.size;
+    h.srcMtimeNs = source.mtimeNs;
+    h.srcInode = source.inode;
+    h.rootExtra = internExtra(rootExtra, pool);
+    h.nStrings = pool.offsets.size() - 1;
+    h.nCustomers = c.cId.size();
+    h.nAccounts = c.aId.size();
+    h.nTransfers = c.tTs.size();
+
+    const std::string tmp = path + ".tmp";
+    {
+        std::ofstream out(tmp, std::ios::binary | std::ios::trunc);
+        if (!out) return false;
+        out.write((const char*)&h, sizeof(h));   // placeholder, offsets patched below
+
+        std::uint64_t pos = sizeof(h);
+        auto put = [&](Col col, const void* data, std::size_t bytes) {
+            static const char zeros[8] = {};
+            std::uint64_t pad = (8 - pos % 8) % 8;
+            out.write(zeros, (std::streamsize)pad);
+            pos += pad;
+            h.colOffset[col] = pos;
+            h.colBytes[col] = bytes;
+            if (bytes) out.write((const char*)data, (std::streamsize)bytes);
+            pos += bytes;
+        };
+        auto putVec = [&](Col col, const auto& v) {
+            put(col, v.data(), v.size() * sizeof(v[0]));
+        };
+
+        putVec(STR_OFFSETS, pool.offsets);
+        put(STR_BYTES, pool.bytes.data(), pool.bytes.size());
+
+        putVec(C_ID, c.cId); putVec(C_FIRST, c.cFirst); putVec(C_LAST, c.cLast);
+        putVec(C_NAME, c.cName); putVec(C_EMAIL, c.cEmail); putVec(C_SECRET, c.cSecret);
+        putVec(C_PHONE, c.cPhone); putVec(C_AGE, c.cAge); putVec(C_ACC_BEGIN, c.cAccBegin);
+        putVec(C_ACC_COUNT, c.cAccCount); putVec(C_MASK, c.cMask); putVec(C_EXTRA, c.cExtra);
+
+        putVec(A_ID, c.aId); putVec(A_TYPE, c.aType); putVec(A_BAL_MINOR, c.aBalMinor);
+        putVec(A_BAL, c.aBal); putVec(A_CUR, c.aCur); putVec(A_RATE, c.aRate);
+        putVec(A_DATE, c.aDate); putVec(A_MASK, c.aMask); putVec(A_EXTRA, c.aExtra);
+
+        putVec(T_TS, c.tTs); putVec(T_FROM_C, c.tFromC); putVec(T_TO_C, c.tToC);
+        putVec(T_FROM_A, c.tFromA); putVec(T_TO_A, c.tToA); putVec(T_AMT_MINOR, c.tAmtMinor);
+        putVec(T_AMT, c.tAmt); putVec(T_STATUS, c.tStatus); putVec(T_MODE, c.tMode);
+        putVec(T_TARGET, c.tTarget); putVec(T_ERROR, c.tError); putVec(T_MASK, c.tMask);
+        putVec(T_EXTRA, c.tExtra);
+
+        out.seekp(0);
+        out.write((const char*)&h, sizeof(h));
+        if (!out.good()) return false;
+        PROF_BYTES_WRITTEN(pos);
+    }
+
+    std::error_code ec;
+    fs::rename(tmp, path, ec);
+    if (ec) { fs::remove(tmp, ec); return false; }
+    return true;
+}
+
+// ---------------------- read ----------------------
+static bool readHeader(const MappedFile& mf, Header& h) {
+    if (mf.size() < sizeof(Header)) return false;
+    std::memcpy(&h, mf.data(), sizeof(Header));
+    if (std::memcmp(h.magic, MAGIC, sizeof(MAGIC)) != 0) return false;
+    if (h.version != VERSION || h.endianTag != ENDIAN_TAG) return false;
+    for (int i = 0; i < COL_COUNT; ++i) {
+        if (h.colOffset[i] > mf.size() || h.colBytes[i] > mf.size() - h.colOffset[i]) return false;
+    }
+    return true;
+}
+
+bool BinarySnapshot::readSource(const std::string& path, SnapshotSource& outSource) {
+    MappedFile mf;
+    if (!mf.open(path)) return false;
+    PROF_BYTES_READ(mf.size());
+    Header h;
+    if (!readHeader(mf, h)) return false;
+    outSource.size = h.srcSize;
+    outSource.mtimeNs = h.srcMtimeNs;
+    outSource.inode = h.srcInode;
+    return true;
+}
+
+template <class T>
+static T at(const unsigned char* base, std::uint64_t i) {
+    T v;
+    std::memcpy(&v, base + i * sizeof(T), sizeof(T));
+    return v;
+}
+
+bool BinarySnapshot::read(const std::string& path, json& outRoot) {
+    MappedFile mf;
+    if (!mf.open(path)) return false;
+    PROF_BYTES_READ(mf.size());
+    Header h;
+    if (!readHeader(mf, h)) return false;
+
+    const unsigned char* base = mf.data();
+    auto col = [&](Col c, std::uint64_t count, std::size_t elem) -> const unsigned char* {
+        if (count > mf.size() || h.colBytes[c] != count * elem) throw std::runtime_error("snapshot: bad column");
+        return base + h.colOffset[c];
+    };
+
+    try {
+        // string pool
+        const unsigned char* offs = col(STR_OFFSETS, h.nStrings + 1, sizeof(std::uint64_t));
+        const char* bytes = (const char*)base + h.colOffset[STR_BYTES];
+        const std::uint64_t nBytes = h.colBytes[STR_BYTES];
+        std::uint64_t prev = 0;
+        for (std::uint64_t i = 0; i <= h.nStrings; ++i) {
+            std::uint64_t o = at<std::uint64_t>(offs, i);
+            if (o < prev || o > nBytes) throw std::runtime_error("snapshot: bad string pool");
+            prev = o;
+        }
+        auto str = [&](std::uint32_t idx) -> std::string {
+            if (idx >= h.nStrings) throw std::runtime_error("snapshot: bad string ref");
+            std::uint64_t b = at<std::uint64_t>(offs, idx), e = at<std::uint64_t>(offs, idx + 1);
+            return std::string(bytes + b, (std::size_t)(e - b));
+        };
+        auto mergeExtra = [&](json& obj, std::uint32_t idx) {
+            if (idx == 0) return;
+            json extra = json::parse(str(idx));
+            for (auto it = extra.begin(); it != extra.end(); ++it) obj[it.key()] = it.value();
+        };
+
+        const std::uint64_t nC = h.nCustomers, nA = h.nAccounts, nT = h.nTransfers;
+        const auto* cId = col(C_ID, nC, 4);          const auto* cFirst = col(C_FIRST, nC, 4);
+        const auto* cLast = col(C_LAST, nC, 4);      const auto* cName = col(C_NAME, nC, 4);
+        const auto* cEmail = col(C_EMAIL, nC, 4);    const auto* cSecret = col(C_SECRET, nC, 4);
+        const auto* cPhone = col(C_PHONE, nC, 4);    const auto* cAge = col(C_AGE, nC, 4);
+        const auto* cAccBegin = col(C_ACC_BEGIN, nC, 8);
+        const auto* cAccCount = col(C_ACC_COUNT, nC, 4);
+        const auto* cMask = col(C_MASK, nC, 4);      const auto* cExtra = col(C_EXTRA, nC, 4);
+
+        const auto* aId = col(A_ID, nA, 4);          const auto* aType = col(A_TYPE, nA, 4);
+        const auto* aBalMinor = col(A_BAL_MINOR, nA, 8);
+        const auto* aBal = col(A_BAL, nA, 8);        const auto* aCur = col(A_CUR, nA, 4);
+        const auto* aRate = col(A_RATE, nA, 8);      const auto* aDate = col(A_DATE, nA, 4);
+        const auto* aMask = col(A_MASK, nA, 4);      const auto* aExtra = col(A_EXTRA, nA, 4);
+
+        const auto* tTs = col(T_TS, nT, 8);          const auto* tFromC = col(T_FROM_C, nT, 4);
+        const auto* tToC = col(T_TO_C, nT, 4);       const auto* tFromA = col(T_FROM_A, nT, 4);
+        const auto* tToA = col(T_TO_A, nT, 4);       const auto* tAmtMinor = col(T_AMT_MINOR, nT, 8);
+        const auto* tAmt = col(T_AMT, nT, 8);        const auto* tStatus = col(T_STATUS, nT, 4);
+        const auto* tMode = col(T_MODE, nT, 4);      const auto* tTarget = col(T_TARGET, nT, 4);
+        const auto* tError = col(T_ERROR, nT, 4);    const auto* tMask = col(T_MASK, nT, 4);
+        const auto* tExtra = col(T_EXTRA, nT, 4);
+
+        json root = json::object();
+        mergeExtra(root, h.rootExtra);
+
+        json customers = json::object();
+        for (std::uint64_t i = 0; i < nC; ++i) {
+            const std::uint32_t m = at<std::uint32_t>(cMask, i);
+            json c = json::object();
+            if (m & CM_FIRST)  c["firstName"]  = str(at<std::uint32_t>(cFirst, i));
+            if (m & CM_LAST)   c["lastName"]   = str(at<std::uint32_t>(cLast, i));
+            if (m & CM_NAME)   c["name"]       = str(at<std::uint32_t>(cName, i));
+            if (m & CM_EMAIL)  c["email"]      = str(at<std::uint32_t>(cEmail, i));
+            if (m & CM_SECRET) c["secretWord"] = str(at<std::uint32_t>(cSecret, i));
+            if (m & CM_PHONE)  c["phone"]      = str(at<std::uint32_t>(cPhone, i));
+            if (m & CM_AGE)    c["age"]        = at<std::int32_t>(cAge, i);
+
+            if (m & CM_ACCOUNTS) {
+                const std::uint64_t b = at<std::uint64_t>(cAccBegin, i);
+                const std::uint64_t n = at<std::uint32_t>(cAccCount, i);
+                if (b > nA || n > nA - b) throw std::runtime_error("snapshot: bad account range");
+
+                json accs = json::array();
+                for (std::uint64_t k = b; k < b + n; ++k) {
+                    const std::uint32_t am = at<std::uint32_t>(aMask, k);
+                    json a = json::object();
+                    if (am & AM_ID)        a["accId"]         = at<std::int32_t>(aId, k);
+                    if (am & AM_TYPE)      a["type"]          = str(at<std::uint32_t>(aType, k));
+                    if (am & AM_BAL_MINOR) a["balanceMinor"]  = at<std::int64_t>(aBalMinor, k);
+                    if (am & AM_BAL)       a["balance"]       = at<double>(aBal, k);
+                    if (am & AM_CUR)       a["currency"]      = str(at<std::uint32_t>(aCur, k));
+                    if (am & AM_RATE)      a["savingsRate"]   = at<double>(aRate, k);
+                    if (am & AM_DATE)      a["lastSavedDate"] = str(at<std::uint32_t>(aDate, k));
+                    mergeExtra(a, at<std::uint32_t>(aExtra, k));
+                    accs.push_back(std::move(a));
+                }
+                c["accounts"] = std::move(accs);
+            }
+            mergeExtra(c, at<std::uint32_t>(cExtra, i));
+            customers[str(at<std::uint32_t>(cId, i))] = std::move(c);
+        }
+
+        json transfers = json::array();
+        for (std::uint64_t i = 0; i < nT; ++i) {
+            const std::uint32_t m = at<std::uint32_t>(tMask, i);
+            json e = json::object();
+            if (m & TM_TS)        e["ts"]             = at<std::int64_t>(tTs, i);
+            if (m & TM_FROM_C)    e["fromCustomerId"] = str(at<std::uint32_t>(tFromC, i));
+            if (m & TM_TO_C)      e["toCustomerId"]   = str(at<std::uint32_t>(tToC, i));
+            if (m & TM_FROM_A)    e["fromAccId"]      = at<std::int32_t>(tFromA, i);
+            if (m & TM_TO_A)      e["toAccId"]        = at<std::int32_t>(tToA, i);
+            if (m & TM_AMT_MINOR) e["amountMinor"]    = at<std::int64_t>(tAmtMinor, i);
+            if (m & TM_AMT)       e["amount"]         = at<double>(tAmt, i);
+            if (m & TM_STATUS)    e["status"]         = str(at<std::uint32_t>(tStatus, i));
+            if (m & TM_MODE)      e["mode"]           = str(at<std::uint32_t>(tMode, i));
+            if (m & TM_TARGET)    e["target"]         = str(at<std::uint32_t>(tTarget, i));
+            if (m & TM_ERROR)     e["error"]          = str(at<std::uint32_t>(tError, i));
+            mergeExtra(e, at<std::uint32_t>(tExtra, i));
+            transfers.push_back(std::move(e));
+        }
+
+        root["customers"] = std::move(customers);
+        root["transfers"] = std::move(transfers);
+        outRoot = std::move(root);
+        return true;
+    } catch (...) {
+        return false;
+    }
+}
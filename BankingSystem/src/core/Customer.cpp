@@ -1,56 +1,54 @@
 #include "Customer.h"
 #include <iostream>
+#include <utility>
 
 Customer::Customer()
     : firstName(""), lastName(""),
       age(0), email(""), id(""),
       secretWord(""), phone(""), accounts() {}
 
-Customer::Customer(const std::string& fn, const std::string& ln,
-                   int age, const std::string& email,
-                   const std::string& id, const std::string& secretWord)
-    : firstName(fn), lastName(ln),
-      age(age), email(email),
-      id(id), secretWord(secretWord),
-      phone(""), accounts() {}
-
-Customer::Customer(const std::string& fn, const std::string& ln,
-                   int age, const std::string& email,
-                   const std::string& id, const std::string& secretWord,
-                   const std::string& phone)
-    : firstName(fn), lastName(ln),
-      age(age), email(email),
-      id(id), secretWord(secretWord),
-      phone(phone), accounts() {}
-
-std::string Customer::getFirstName() const { return firstName; }
-std::string Customer::getLastName() const  { return lastName; }
-
-std::string Customer::getFullName() const {
-    if (firstName.empty() && lastName.empty()) return "";
-    if (lastName.empty()) return firstName;
-    if (firstName.empty()) return lastName;
-    return firstName + " " + lastName;
+Customer::Customer(std::string fn, std::string ln,
+                   int age, std::string email,
+                   std::string id, std::string secretWord)
+    : Customer(std::move(fn), std::move(ln), age, std::move(email),
+               std::move(id), std::move(secretWord), "") {}
+
+Customer::Customer(std::string fn, std::string ln,
+                   int age, std::string email,
+                   std::string id, std::string secretWord,
+                   std::string phone)
+    : firstName(std::move(fn)), lastName(std::move(ln)),
+      age(age), email(std::move(email)),
+      id(std::move(id)), secretWord(std::move(secretWord)),
+      phone(std::move(phone)), accounts() {
+    rebuildFullName();
 }
 
-int Customer::getAge() const { return age; }
-std::string Customer::getEmail() const { return email; }
-std::string Customer::getId() const { return id; }
-std::string Customer::getSecretWord() const { return secretWord; }
-std::string Customer::getPhone() const { return phone; }
+// getFullName() зовётся каждый кадр -> собираем строку только при смене имени
+void Customer::rebuildFullName() {
+    if (lastName.empty()) fullName = firstName;
+    else if (firstName.empty()) fullName = lastName;
+    else fullName = firstName + " " + lastName;
+}
 
-void Customer::setFirstName(const std::string& fn) { firstName = fn; }
-void Customer::setLastName(const std::string& ln)  { lastName = ln; }
+void Customer::setFirstName(std::string fn) { firstName = std::move(fn); rebuildFullName(); }
+void Customer::setLastName(std::string ln)  { lastName = std::move(ln); rebuildFullName(); }
 void Customer::setAge(int a) { age = a; }
-void Customer::setEmail(const std::string& e) { email = e; }
-void Customer::setId(const std::string& i) { id = i; }
-void Customer::setSecretWord(const std::string& s) { secretWord = s; }
-void Customer::setPhone(const std::string& p) { phone = p; }
+void Customer::setEmail(std::string e) { email = std::move(e); }
+void Customer::setId(std::string i) { id = std::move(i); }
+void Customer::setSecretWord(std::string s) { secretWord = std::move(s); }
+void Customer::setPhone(std::string p) { phone = std::move(p); }
 
 void Customer::addAccount(const Account& acc) { accounts.push_back(acc); }
 std::vector<Account>& Customer::getAccounts() { return accounts; }
 const std::vector<Account>& Customer::getAccounts() const { return accounts; }
 
+const Account* Customer::incomingAccount() const {
+    for (const auto& a : accounts)
+        if (a.getType() == AccountType::Checking) return &a;
+    return accounts.empty() ? nullptr : &accounts[0];
+}
+
 void Customer::printInfo() const {
     std::cout << "Customer: " << getFullName()
               << ", Age: " << age
@@ -0,0 +1,224 @@
+#include "CustomerStream.h"
+
+#include <algorithm>
+#include <cstdint>
+#include <fstream>
+#include <vector>
+
+#include "DbFormat.h"
+#include "Profiler.h"
+#include "nlohmann/json.hpp"
+
+using json = nlohmann::json;
+
+namespace {
+
+// Scalar as it came from the file; numbers keep whether they were integers
+struct Scalar {
+    bool isInt = false, isNumber = false;
+    std::int64_t i = 0;
+    double d = 0.0;
+};
+
+struct AccountFields {
+    int accId = 0;
+    std::string type = "Checking";   // до конца разбора держим имя, как в JSON
+    bool hasMinor = false;
+    std::int64_t balanceMinor = 0;
+    double balance = 0.0;
+    std::string currency;
+    double savingsRate = 0.15;
+    Date lastSaved;
+};
+
+struct CustomerFields {
+    std::string firstName, lastName, name, email, secretWord, phone;
+    int age = 0;
+    std::vector<AccountFields> accounts;
+};
+
+// SAX handler: keeps a stack of what each open container is; everything that
+// isn't on the way to the wanted customer is only counted (skip), never stored.
+class CustomerSax {
+public:
+    explicit CustomerSax(const std::string& id) : id(id) {}
+
+    bool found = false;     // complete customer in `fields`
+    bool stopped = false;   // we returned false on purpose (not a parse error)
+    CustomerFields fields;
+
+    bool null() { return true; }
+    bool boolean(bool) { return true; }
+    bool number_integer(json::number_integer_t v) { Scalar s; s.isNumber = s.isInt = true; s.i = v; s.d = (double)v; return scalar(s); }
+    bool number_unsigned(json::number_unsigned_t v) { Scalar s; s.isNumber = s.isInt = true; s.i = (std::int64_t)v; s.d = (double)v; return scalar(s); }
+    bool number_float(json::number_float_t v, const json::string_t&) { Scalar s; s.isNumber = true; s.d = v; return scalar(s); }
+    bool string(json::string_t& v) { return text(v); }
+    bool binary(json::binary_t&) { return true; }
+
+    bool key(json::string_t& k) {
+        if (skip == 0) lastKey = k;
+        return true;
+    }
+
+    bool start_object(std::size_t) { return open(true); }
+    bool start_array(std::size_t)  { return open(false); }
+    bool end_array()               { return close(); }
+
+    bool end_object() {
+        if (skip > 0) { --skip; return true; }
+        const Frame f = stack.back();
+        if (f == Frame::Account) fields.accounts.push_back(acc);
+        if (f == Frame::Customer) {
+            found = true;
+            // legacy: "customers" может встретиться дальше и перекрыть корень -> читаем до конца
+            if (!legacyMatch) { stopped = true; return false; }
+        }
+        stack.pop_back();
+        return true;
+    }
+
+    bool parse_error(std::size_t, const std::string&, const nlohmann::detail::exception&) {
+        return false;
+    }
+
+private:
+    enum class Frame { Root, Customers, Customer, Accounts, Account };
+
+    const std::string& id;
+    std::vector<Frame> stack;
+    int skip = 0;            // depth inside a skipped subtree
+    std::string lastKey;
+    bool sawCustomers = false;
+    bool legacyMatch = false;
+    AccountFields acc;
+
+    bool open(bool object) {
+        if (skip > 0) { ++skip; return true; }
+        if (stack.empty()) {
+            if (!object) { skip = 1; return true; }
+            stack.push_back(Frame::Root);
+            return true;
+        }
+
+        const Frame parent = stack.back();
+        if (object && parent == Frame::Root && lastKey == "customers") {
+            sawCustomers = true;
+            if (legacyMatch) { found = false; legacyMatch = false; fields = CustomerFields(); }
+            stack.push_back(Frame::Customers);
+        } else if (object && parent == Frame::Customers && lastKey == id) {
+            stack.push_back(Frame::Customer);
+        } else if (object && parent == Frame::Root && !sawCustomers && !found && lastKey == id) {
+            legacyMatch = true;   // старый формат: корень = map клиентов
+            stack.push_back(Frame::Customer);
+        } else if (!object && parent == Frame::Customer && lastKey == "accounts") {
+            stack.push_back(Frame::Accounts);
+        } else if (object && parent == Frame::Accounts) {
+            acc = AccountFields();
+            stack.push_back(Frame::Account);
+        } else {
+            skip = 1;
+        }
+        return true;
+    }
+
+    bool close() {
+        if (skip > 0) { --skip; return true; }
+        stack.pop_back();
+        return true;
+    }
+
+    bool scalar(const Scalar& s) {
+        if (skip > 0 || stack.empty()) return true;
+        if (stack.back() == Frame::Customer && lastKey == "age") {
+            fields.age = (int)(s.isInt ? s.i : (std::int64_t)s.d);
+        } else if (stack.back() == Frame::Account) {
+            if (lastKey == "accId") acc.accId = (int)(s.isInt ? s.i : (std::int64_t)s.d);
+            else if (lastKey == "balance") acc.balance = s.d;
+            else if (lastKey == "balanceMinor" && s.isInt) { acc.hasMinor = true; acc.balanceMinor = s.i; }
+            else if (lastKey == "savingsRate") acc.savingsRate = s.d;
+        }
+        return true;
+    }
+
+    bool text(const std::string& v) {
+        if (skip > 0 || stack.empty()) return true;
+        if (stack.back() == Frame::Customer) {
+            if      (lastKey == "firstName")  fields.firstName = v;
+            else if (lastKey == "lastName")   fields.lastName = v;
+            else if (lastKey == "name")       fields.name = v;
+            else if (lastKey == "email")      fields.email = v;
+            else if (lastKey == "secretWord") fields.secretWord = v;
+            else if (lastKey == "phone")      fields.phone = v;
+        } else if (stack.back() == Frame::Account) {
+            if      (lastKey == "type")          acc.type = v;
+            else if (lastKey == "currency")      acc.currency = v;
+            else if (lastKey == "lastSavedDate") acc.lastSaved = Date::fromIso(v);
+        }
+        return true;
+    }
+};
+
+std::string trimmed(const std::string& s) {
+    const auto b = s.find_first_not_of(" \t\r\n");
+    if (b == std::string::npos) return "";
+    return s.substr(b, s.find_last_not_of(" \t\r\n") - b + 1);
+}
+
+} // namespace
+
+bool streamLoadCustomer(const std::string& path, const std::string& id, Customer& out,
+                        std::string* error) {
+    auto fail = [&](const char* msg) { if (error) *error = msg; return false; };
+
+    std::ifstream in(path, std::ios::binary);
+    if (!in) return fail("Cannot read database file.");
+
+    // кодировку определяем по первым байтам, как decodeDocument
+    std::string head(64, '\0');
+    in.read(&head[0], (std::streamsize)head.size());
+    head.resize((std::size_t)in.gcount());
+    in.clear();
+    in.seekg(0);
+
+    json::input_format_t format = json::input_format_t::json;
+    switch (detectFormat(head)) {
+        case FileFormat::Cbor:    format = json::input_format_t::cbor; break;
+        case FileFormat::MsgPack: format = json::input_format_t::msgpack; break;
+        default: break;
+    }
+
+    CustomerSax sax(id);
+    const bool parsed = json::sax_parse(in, &sax, format);
+    PROF_JSON_PARSE();
+#if BANKING_PROFILER
+    in.clear();   // SAX мог остановиться раньше конца: считаем только прочитанное
+    PROF_BYTES_READ(std::max<std::streamoff>(in.tellg(), 0));
+#endif
+    if (!parsed && !sax.stopped) return fail("Cannot read database file.");
+    if (!sax.found) return fail("Customer not found.");
+
+    const CustomerFields& f = sax.fields;
+    std::string fn = f.firstName, ln = f.lastName;
+    if (fn.empty() && ln.empty()) {
+        // legacy "name": первое слово -> имя, последнее -> фамилия
+        const std::string full = trimmed(f.name);
+        const auto sp = full.find(' ');
+        fn = trimmed(full.substr(0, sp));
+        if (sp != std::string::npos) ln = trimmed(full.substr(full.find_last_of(' ') + 1));
+    }
+
+    out = Customer(fn, ln, f.age, f.email, id, f.secretWord, f.phone);
+    for (const AccountFields& a : f.accounts) {
+        const AccountType type = accountTypeFromName(a.type);
+        const CurrencyCode cur = type == AccountType::FX ? CurrencyCode::fromString(a.currency) : EUR;
+        Money balance = a.hasMinor ? Money(a.balanceMinor, cur) : Money::fromMajor(a.balance, cur);
+
+        Account acc(a.accId, type, balance);
+        if (type == AccountType::Savings) {
+            acc.setSavingsRate(a.savingsRate);
+            acc.setLastSaved(a.lastSaved);
+        }
+        out.addAccount(acc);
+    }
+    return true;
+}
@@ -1,13 +1,20 @@
 #include "DatabaseManager.h"
+#include "CustomerStream.h"
+#include "FileSync.h"
+#include "Profiler.h"
 
 #include <fstream>
-#include <iomanip>
 #include <filesystem>
 #include <algorithm>
+#include <map>
 #include <cctype>
 #include <chrono>
 #include <cstdlib>
 
+#if !defined(_WIN32) && !defined(_WIN64)
+#  include <sys/stat.h>
+#endif
+
 using namespace std;
 namespace fs = std::filesystem;
 
@@ -30,12 +37,28 @@ static long long nowEpochMs() {
     return duration_cast<milliseconds>(system_clock::now().time_since_epoch()).count();
 }
 
-static int daysBackFromNow(long long tsMs) {
-    using namespace std::chrono;
-    long long nowMs = duration_cast<milliseconds>(system_clock::now().time_since_epoch()).count();
-    long long diff = nowMs - tsMs;
-    if (diff < 0) return 0;
-    return (int)(diff / (1000LL * 60 * 60 * 24));
+static constexpr long long MS_PER_DAY = 1000LL * 60 * 60 * 24;
+
+// Exact minor units win; files written before Money only have the double
+static Money readMoney(const json& j, const char* key, const char* minorKey, CurrencyCode cur) {
+    auto m = j.find(minorKey);
+    if (m != j.end() && m->is_number_integer()) return Money(m->get<std::int64_t>(), cur);
+    return Money::fromMajor(j.value(key, 0.0), cur);
+}
+
+static TransferRecord toTransferRecord(const json& e) {
+    TransferRecord r;
+    r.ts             = e.value("ts", 0LL);
+    r.status         = e.value("status", "");
+    r.mode           = e.value("mode", "");
+    r.fromCustomerId = e.value("fromCustomerId", "");
+    r.toCustomerId   = e.value("toCustomerId", "");
+    r.fromAccId      = e.value("fromAccId", 0);
+    r.toAccId        = e.value("toAccId", 0);
+    r.amount         = readMoney(e, "amount", "amountMinor", EUR);
+    r.target         = e.value("target", "");
+    r.error          = e.value("error", "");
+    return r;
 }
 
 // Обязательный формат БД (новый)
@@ -56,17 +79,19 @@ static void normalizeDb(json& root) {
 
         // если root выглядит как map клиентов (ключи = id)
         for (auto it = root.begin(); it != root.end(); ++it) {
-            if (it.key() == "transfers") continue;
+            if (it.key() == "transfers" || it.key() == "meta" || it.key() == "walSeq") continue;
             customers[it.key()] = it.value();
         }
 
         json transfers = json::array();
         if (root.contains("transfers") && root["transfers"].is_array())
             transfers = root["transfers"];
+        json meta = root.value("meta", json::object());
 
         root = json::object();
         root["customers"] = customers;
         root["transfers"] = transfers;
+        if (meta.is_object() && !meta.empty()) root["meta"] = meta;
     }
 
     if (!root["customers"].is_object())
@@ -76,6 +101,98 @@ static void normalizeDb(json& root) {
         root["transfers"] = json::array();
 }
 
+// ---------------------- WAL records ----------------------
+// { "seq": n, "op": "upsert",   "id": "...", "customer": {...} }
+// { "seq": n, "op": "remove",   "id": "..." }
+// { "seq": n, "op": "balance",  "id": "...", "balances": [ {"accId": 1, "balanceMinor": 200, "balance": 2.0}, ... ] }
+// { "seq": n, "op": "transfer", "entry": {...} }
+// { "seq": n, "op": "meta",     "meta": {...} }
+// Балансы пишем абсолютными значениями, а не дельтами -> повторное применение безопасно.
+static void applyWalRecord(json& root, const json& r) {
+    const std::string op = r.value("op", "");
+    json& custs = root["customers"];
+
+    if (op == "upsert") {
+        if (r.contains("customer")) custs[r.value("id", "")] = r["customer"];
+    } else if (op == "remove") {
+        custs.erase(r.value("id", ""));
+    } else if (op == "balance") {
+        const std::string id = r.value("id", "");
+        if (!custs.contains(id) || !r.contains("balances")) return;
+        json& accs = custs[id]["accounts"];
+        if (!accs.is_array()) return;
+        for (const auto& b : r["balances"]) {
+            int accId = b.value("accId", 0);
+            for (auto& a : accs) {
+                if (a.value("accId", 0) != accId) continue;
+                if (b.contains("balanceMinor")) a["balanceMinor"] = b["balanceMinor"];
+                if (b.contains("balance")) a["balance"] = b["balance"];
+                break;
+            }
+        }
+    } else if (op == "transfer") {
+        if (r.contains("entry")) root["transfers"].push_back(r["entry"]);
+    } else if (op == "meta") {
+        if (r.contains("meta") && r["meta"].is_object()) root["meta"] = r["meta"];
+    } else if (op == "tx") {
+        // одна строка журнала -> транзакция применяется целиком или (оборванная) никак
+        if (!r.contains("ops") || !r["ops"].is_array()) return;
+        for (const auto& sub : r["ops"]) applyWalRecord(root, sub);
+    }
+}
+
+// Sharded: шарды, которые задевает запись журнала (переводы и meta commit() видит сам)
+static void touchShards(ShardedStore& store, const json& r) {
+    const std::string op = r.value("op", "");
+    if (op == "upsert" || op == "remove" || op == "balance") {
+        store.touchCustomer(r.value("id", ""));
+    } else if (op == "tx" && r.contains("ops") && r["ops"].is_array()) {
+        for (const auto& sub : r["ops"]) touchShards(store, sub);
+    }
+}
+
+// true -> старая и новая запись клиента отличаются только балансами счетов;
+// outBalances = изменившиеся балансы (пусто, если не изменилось ничего)
+static bool balanceOnlyChange(const json& oldC, const json& newC, json& outBalances) {
+    if (!oldC.is_object() || oldC.size() != newC.size()) return false;
+
+    for (auto it = newC.begin(); it != newC.end(); ++it) {
+        if (it.key() == "accounts") continue;
+        auto o = oldC.find(it.key());
+        if (o == oldC.end() || *o != it.value()) return false;
+    }
+
+    auto oa = oldC.find("accounts");
+    const json& na = newC["accounts"];
+    if (oa == oldC.end() || !oa->is_array() || oa->size() != na.size()) return false;
+
+    outBalances = json::array();
+    for (size_t i = 0; i < na.size(); ++i) {
+        const json& o = (*oa)[i];
+        const json& n = na[i];
+        if (!o.is_object() || o.size() != n.size()) return false;
+
+        bool balanceChanged = false;
+        for (auto it = n.begin(); it != n.end(); ++it) {
+            auto f = o.find(it.key());
+            bool same = f != o.end() && *f == it.value();
+            if (it.key() == "balance" || it.key() == "balanceMinor") {
+                balanceChanged |= !same;
+                continue;
+            }
+            if (!same) return false;
+        }
+        if (balanceChanged) {
+            json b = json::object();
+            b["accId"] = n.value("accId", 0);
+            if (n.contains("balanceMinor")) b["balanceMinor"] = n["balanceMinor"];
+            if (n.contains("balance")) b["balance"] = n["balance"];
+            outBalances.push_back(b);
+        }
+    }
+    return true;
+}
+
 static bool fileExists(const std::string& path) {
     std::error_code ec;
     return fs::exists(fs::path(path), ec);
@@ -96,15 +213,157 @@ static void ensureParentDir(const std::string& filename) {
     }
 }
 
+static inline void deriveNamesFromLegacy(const json& cust, std::string& outFirst, std::string& outLast) {
+    outFirst = cust.value("firstName", "");
+    outLast  = cust.value("lastName", "");
+    if (!outFirst.empty() || !outLast.empty()) return;
+
+    std::string full = trim_copy(cust.value("name", ""));
+    if (full.empty()) return;
+
+    // простой split: first = first word, last = last word
+    std::string first, last;
+    size_t sp = full.find(' ');
+    if (sp == std::string::npos) {
+        first = full;
+        last = "";
+    } else {
+        first = trim_copy(full.substr(0, sp));
+        last  = trim_copy(full.substr(full.find_last_of(' ') + 1));
+    }
+    outFirst = first;
+    outLast  = last;
+}
+
+// Key of the name index: "first\x1flast", trimmed + lowercased; legacy "name"-only
+// records go through deriveNamesFromLegacy. "" = not indexable.
+static std::string nameKeyOf(const std::string& first, const std::string& last) {
+    std::string fn = lower_copy(trim_copy(first));
+    std::string ln = lower_copy(trim_copy(last));
+    if (fn.empty() || ln.empty()) return "";
+    return fn + '\x1f' + ln;
+}
+
+static std::string nameKeyOf(const json& cust) {
+    std::string fn, ln;
+    deriveNamesFromLegacy(cust, fn, ln);
+    return nameKeyOf(fn, ln);
+}
+
+static json customerToJson(const Customer& customer) {
+    json c = json::object();
+    c["firstName"]  = customer.getFirstName();
+    c["lastName"]   = customer.getLastName();
+    c["name"]       = customer.getFullName(); // для читаемости/совместимости
+    c["age"]        = customer.getAge();
+    c["email"]      = customer.getEmail();
+    c["secretWord"] = customer.getSecretWord();
+    c["phone"]      = customer.getPhone();
+
+    c["accounts"] = json::array();
+    for (const auto& acc : customer.getAccounts()) {
+        json a = json::object();
+        a["accId"]   = acc.getId();
+        a["type"]    = accountTypeName(acc.getType());
+        a["balanceMinor"] = acc.getBalance().minorUnits();
+        a["balance"]      = acc.getBalance().toMajor(); // для читаемости/совместимости
+
+        if (acc.getType() == AccountType::Savings) {
+            a["savingsRate"]   = acc.getSavingsRate();
+            a["lastSavedDate"] = acc.getLastSaved().iso();
+        }
+        if (acc.getType() == AccountType::FX) {
+            a["currency"] = acc.getCurrency().str();
+        }
+
+        c["accounts"].push_back(a);
+    }
+    return c;
+}
+
+// Account keeps only what it can parse: a type name it doesn't recognise loads
+// as Unknown, an unreadable lastSavedDate as an empty Date and an FX currency
+// that isn't a 3-letter code as an empty CurrencyCode (both written back as "").
+// Put the stored strings back so a load + save keeps them.
+static void keepUnreadableFields(const json& oldCust, json& c) {
+    if (!oldCust.contains("accounts") || !oldCust["accounts"].is_array()) return;
+    static const char* const STRING_FIELDS[] = { "lastSavedDate", "currency" };
+    for (auto& a : c["accounts"]) {
+        const bool unknownType = a.value("type", "") == accountTypeName(AccountType::Unknown);
+        bool blank = false;
+        for (const char* f : STRING_FIELDS) blank = blank || (a.contains(f) && a[f] == "");
+        if (!unknownType && !blank) continue;
+        const int accId = a.value("accId", 0);
+        for (const auto& o : oldCust["accounts"]) {
+            if (!o.is_object() || o.value("accId", 0) != accId) continue;
+            if (unknownType && o.contains("type") && o["type"].is_string()) a["type"] = o["type"];
+            for (const char* f : STRING_FIELDS) {
+                if (a.contains(f) && a[f] == "" && o.contains(f) && o[f].is_string()) a[f] = o[f];
+            }
+            break;
+        }
+    }
+}
+
+// Journal record that turns custs[id] into c: "balance" when only balances
+// moved, "upsert" otherwise. false -> nothing changed.
+static bool customerRecord(const json& custs, const std::string& id, const json& c, json& outRec) {
+    outRec = json::object();
+    outRec["id"] = id;
+
+    json balances;
+    auto old = custs.find(id);
+    if (old != custs.end() && balanceOnlyChange(*old, c, balances)) {
+        if (balances.empty()) return false;
+        outRec["op"] = "balance";
+        outRec["balances"] = std::move(balances);
+    } else {
+        outRec["op"] = "upsert";
+        outRec["customer"] = c;
+    }
+    return true;
+}
+
+static CurrencyCode accountCurrency(const json& a) {
+    return a.value("type", "") == "FX" ? CurrencyCode::fromString(a.value("currency", "")) : EUR;
+}
+
+static void collectBalances(const json& cust, std::vector<std::pair<int, Money>>& out) {
+    if (!cust.is_object() || !cust.contains("accounts") || !cust["accounts"].is_array()) return;
+    for (const auto& a : cust["accounts"]) {
+        int accId = a.value("accId", 0);
+        if (accId > 0) out.emplace_back(accId, readMoney(a, "balance", "balanceMinor", accountCurrency(a)));
+    }
+}
+
 // ---------------------- DatabaseManager ----------------------
-DatabaseManager::DatabaseManager(const std::string& filename)
-: filename(filename) {
+using Lock = std::lock_guard<std::recursive_mutex>;
+
+DatabaseManager::DatabaseManager(const std::string& filename, const DatabaseOptions& options)
+: filename(filename), options(options), wal(filename + ".wal") {
     // Гарантируем, что папка под БД существует
     ensureParentDir(this->filename);
 
-    // Гарантируем, что сама БД существует и валидна
-    json root;
-    loadAll(root); // loadAll сам создаст если нет
+    if (options.mode == StorageMode::Sharded)
+        shards = std::make_unique<ShardedStore>(this->filename, options.shardCount,
+                                                options.transferSegmentBytes, writeFormat());
+
+    // Гарантируем, что сама БД существует и валидна (и сразу держим образ в памяти)
+    refreshImage(); // readFromDisk сам создаст если нет
+
+    if (options.commitWindowMs > 0) {
+        committer = std::make_unique<GroupCommitter>(
+            [this]{ return persistPending(); },
+            CommitWindow{ options.commitWindowMs, std::max<std::size_t>(1, options.commitWindowOps) });
+    }
+
+    if (options.accountIdDigits > accountIds.getDigits())
+        setAccountIdDigits(options.accountIdDigits);
+}
+
+DatabaseManager::~DatabaseManager() {
+    // поток дописывает очередь и останавливается, пока образ ещё жив
+    committer.reset();
 }
 
 // customersRef / customersRefConst должны возвращать root["customers"]
@@ -125,61 +384,614 @@ const json& DatabaseManager::customersRefConst(const json& root) {
     return root;
 }
 
+// ---------------------- resident image ----------------------
+DatabaseManager::FileStamp DatabaseManager::stampOf(const std::string& path) {
+    FileStamp st;
+#if defined(_WIN32) || defined(_WIN64)
+    std::error_code ec;
+    auto sz = fs::file_size(fs::path(path), ec);
+    if (ec) return st;
+    auto mt = fs::last_write_time(fs::path(path), ec);
+    if (ec) return st;
+    st.exists = true;
+    st.size = sz;
+    st.mtimeNs = (long long)std::chrono::duration_cast<std::chrono::nanoseconds>(
+                     mt.time_since_epoch()).count();
+#else
+    struct stat sb{};
+    if (::stat(path.c_str(), &sb) != 0) return st;
+    st.exists = true;
+    st.size = (std::uintmax_t)sb.st_size;
+    st.inode = (unsigned long long)sb.st_ino;
+#  if defined(__APPLE__)
+    st.mtimeNs = (long long)sb.st_mtimespec.tv_sec * 1000000000LL + sb.st_mtimespec.tv_nsec;
+    st.ctimeNs = (long long)sb.st_ctimespec.tv_sec * 1000000000LL + sb.st_ctimespec.tv_nsec;
+#  else
+    st.mtimeNs = (long long)sb.st_mtim.tv_sec * 1000000000LL + sb.st_mtim.tv_nsec;
+    st.ctimeNs = (long long)sb.st_ctim.tv_sec * 1000000000LL + sb.st_ctim.tv_nsec;
+#  endif
+#endif
+    return st;
+}
+
+bool DatabaseManager::refreshImage() {
+    if (!loadImage()) {
+        dropParked();
+        return false;
+    }
+    if (writeBackPostings()) return true;
+    // запись не прошла -> образ (и ledger через rebuildIndexes) снова с диска
+    return loadImage();
+}
+
+bool DatabaseManager::loadImage() {
+    const bool walMode = options.mode == StorageMode::WriteAheadLog;
+
+    // открытый батч / ещё не записанные мутации живут только в памяти -> перечитывать нельзя
+    if (imageLoaded && (batching || hasUnpersisted())) return true;
+
+    // Файл не менялся с момента последнего чтения/записи -> отдаём образ из памяти.
+    // saveAll() меняет inode (rename tmp -> filename), так что чужая запись
+    // заметна даже при грубом mtime.
+    if (options.resident && imageLoaded && stampOf(stampPath()) == imageStamp &&
+        (!walMode || stampOf(wal.getPath()) == walStamp))
+        return true;
+
+    json fresh;
+    if (!readFromDisk(fresh)) {
+        imageLoaded = false;
+        return false;
+    }
+    if (walMode) replayWal(fresh);
+
+    image = std::move(fresh);
+    imageStamp = stampOf(stampPath());
+    walStamp = stampOf(wal.getPath());
+    imageLoaded = true;
+    rebuildIndexes();
+    return true;
+}
+
+// ---------------------- indexes ----------------------
+void DatabaseManager::rebuildIndexes() {
+    accountIndex.clear();
+    nameIndex.clear();
+    accountIds.reset(image.contains("meta") && image["meta"].is_object()
+                         ? image["meta"].value("accountIdDigits", AccountIdAllocator::MIN_DIGITS)
+                         : AccountIdAllocator::MIN_DIGITS);
+    const auto& custs = customersRefConst(image);
+    std::vector<std::pair<int, Money>> balances;
+    for (auto it = custs.begin(); it != custs.end(); ++it) {
+        indexCustomer(it.key(), it.value());
+        collectBalances(it.value(), balances);
+    }
+    // ledger = образ + проводки, которые ещё не дошли до образа
+    ledger.reset(balances, [this] {
+        std::vector<Ledger::Leg> legs;
+        std::lock_guard<std::mutex> pl(postMtx);
+        for (const auto& p : parked) legs.insert(legs.end(), p.legs.begin(), p.legs.end());
+        return legs;
+    });
+    ledgerLoaded = true;
+
+    transferIndex.clear();
+    const auto& arr = image["transfers"];
+    for (std::size_t i = 0; i < arr.size(); ++i) {
+        long long ts = arr[i].value("ts", 0LL);
+        std::string fromId = arr[i].value("fromCustomerId", "");
+        std::string toId   = arr[i].value("toCustomerId", "");
+        accountIds.markUsed(arr[i].value("fromAccId", 0));
+        accountIds.markUsed(arr[i].value("toAccId", 0));
+        if (!fromId.empty()) transferIndex[fromId].push_back({ ts, i });
+        if (!toId.empty() && toId != fromId) transferIndex[toId].push_back({ ts, i });
+    }
+    for (auto& kv : transferIndex) {
+        std::stable_sort(kv.second.begin(), kv.second.end(),
+                         [](const TransferRef& a, const TransferRef& b){ return a.ts < b.ts; });
+    }
+    ++transferGen;
+}
+
+// Appends are almost always the newest entry -> push_back; otherwise keep order
+void DatabaseManager::indexTransfer(std::size_t offset) {
+    const json& e = image["transfers"][offset];
+    const TransferRef ref{ e.value("ts", 0LL), offset };
+
+    auto add = [&](const std::string& id) {
+        auto& v = transferIndex[id];
+        if (v.empty() || v.back().ts <= ref.ts) { v.push_back(ref); return; }
+        auto pos = std::upper_bound(v.begin(), v.end(), ref,
+                                    [](const TransferRef& a, const TransferRef& b){ return a.ts < b.ts; });
+        v.insert(pos, ref);
+    };
+
+    std::string fromId = e.value("fromCustomerId", "");
+    std::string toId   = e.value("toCustomerId", "");
+    accountIds.markUsed(e.value("fromAccId", 0));
+    accountIds.markUsed(e.value("toAccId", 0));
+    if (!fromId.empty()) add(fromId);
+    if (!toId.empty() && toId != fromId) add(toId);
+    ++transferGen;
+}
+
+void DatabaseManager::indexCustomer(const std::string& id, const json& cust) {
+    if (!cust.is_object()) return;
+
+    std::string key = nameKeyOf(cust);
+    if (!key.empty()) {
+        auto& ids = nameIndex[key];
+        ids.insert(std::upper_bound(ids.begin(), ids.end(), id), id);   // по возрастанию id
+    }
+
+    if (!cust.contains("accounts") || !cust["accounts"].is_array()) return;
+    const auto& accs = cust["accounts"];
+    for (int i = 0; i < (int)accs.size(); ++i) {
+        int accId = accs[i].value("accId", 0);
+        if (accId <= 0) continue;
+        AccountLocation& loc = accountIndex[accId];
+        loc.customerId = id;
+        loc.slot = i;
+        accountIds.markUsed(accId);
+    }
+}
+
+void DatabaseManager::unindexCustomer(const std::string& id, const json& cust) {
+    if (!cust.is_object()) return;
+
+    auto n = nameIndex.find(nameKeyOf(cust));
+    if (n != nameIndex.end()) {
+        auto& ids = n->second;
+        ids.erase(std::remove(ids.begin(), ids.end(), id), ids.end());
+        if (ids.empty()) nameIndex.erase(n);
+    }
+
+    if (!cust.contains("accounts") || !cust["accounts"].is_array()) return;
+    for (const auto& a : cust["accounts"]) {
+        auto it = accountIndex.find(a.value("accId", 0));
+        if (it != accountIndex.end() && it->second.customerId == id) accountIndex.erase(it);
+    }
+}
+
+// ---------------------- ledger ----------------------
+// Другие изменения балансов (клиент целиком, удаление, проценты) -> ledger по
+// разнице, чтобы не затереть проводки, которые идут параллельно
+void DatabaseManager::mirrorLedger(const json* oldCust, const json* newCust) {
+    std::vector<std::pair<int, Money>> before, after;
+    if (oldCust) collectBalances(*oldCust, before);
+    if (newCust) collectBalances(*newCust, after);
+
+    for (const auto& [accId, now] : after) {
+        auto b = std::find_if(before.begin(), before.end(),
+                              [&](const std::pair<int, Money>& x){ return x.first == accId; });
+        if (b == before.end() || b->second.currency() != now.currency()) {
+            ledger.assign(accId, now);
+        } else if (now != b->second && !ledger.adjust(accId, now - b->second)) {
+            ledger.assign(accId, now);
+        }
+        if (b != before.end()) b->first = 0;
+    }
+    for (const auto& [accId, was] : before)
+        if (accId > 0) ledger.close(accId);
+}
+
+bool DatabaseManager::hasParked() {
+    std::lock_guard<std::mutex> pl(postMtx);
+    return !parked.empty();
+}
+
+void DatabaseManager::dropParked() {
+    std::deque<Posted> lost;
+    {
+        std::lock_guard<std::mutex> pl(postMtx);
+        lost.swap(parked);
+    }
+    // ledger их уже учёл; следующая загрузка образа сбросит его с диска
+    for (auto& p : lost) *p.state = -1;
+}
+
+// mtx held. Одна запись журнала на проводку: "balance" по каждому клиенту +
+// "transfer" на каждую запись лога, несколько -> "tx"
+bool DatabaseManager::writeBackPostings() {
+    std::deque<Posted> todo;
+    {
+        std::lock_guard<std::mutex> pl(postMtx);
+        todo.swap(parked);
+    }
+    json& custs = customersRef(image);
+
+    for (std::size_t n = 0; n < todo.size(); ++n) {
+        Posted& p = todo[n];
+        std::map<std::string, std::map<int, Money>> changed;   // клиент -> счёт -> новый баланс
+        for (const auto& leg : p.legs) {
+            auto it = accountIndex.find(leg.accId);
+            if (it == accountIndex.end()) continue;   // счёт удалили, пока проводка ждала
+            json& a = custs[it->second.customerId]["accounts"][it->second.slot];
+            Money bal = readMoney(a, "balance", "balanceMinor", accountCurrency(a));
+            if (bal.currency() != leg.amount.currency()) continue;
+            bal = leg.debit ? bal - leg.amount : bal + leg.amount;
+            a["balanceMinor"] = bal.minorUnits();
+            a["balance"]      = bal.toMajor();
+            changed[it->second.customerId][leg.accId] = bal;
+        }
+
+        json ops = json::array();
+        for (const auto& [id, accs] : changed) {
+            json b = json::array();
+            for (const auto& [accId, bal] : accs)
+                b.push_back({ { "accId", accId }, { "balanceMinor", bal.minorUnits() }, { "balance", bal.toMajor() } });
+            ops.push_back({ { "op", "balance" }, { "id", id }, { "balances", std::move(b) } });
+        }
+        for (auto& e : p.entries) {
+            // владельцы счетов известны только здесь (проводка шла без mtx)
+            for (const char* side : { "from", "to" }) {
+                const std::string idKey = std::string(side) + "CustomerId";
+                auto it = accountIndex.find(e.value(std::string(side) + "AccId", 0));
+                if (e.value(idKey, "").empty() && it != accountIndex.end()) e[idKey] = it->second.customerId;
+            }
+            if (!e.contains("ts")) e["ts"] = nowEpochMs();
+            ops.push_back({ { "op", "transfer" }, { "entry", e } });
+            image["transfers"].push_back(std::move(e));
+            indexTransfer(image["transfers"].size() - 1);
+        }
+        if (ops.empty()) {
+            *p.state = 1;
+            continue;
+        }
+
+        json rec;
+        if (ops.size() == 1) {
+            rec = std::move(ops[0]);
+        } else {
+            rec["op"] = "tx";
+            rec["ops"] = std::move(ops);
+        }
+        if (!commitImage(std::move(rec))) {
+            // образ уже не совпадает с диском: эта и следующие проводки потеряны
+            for (std::size_t k = n; k < todo.size(); ++k) *todo[k].state = -1;
+            return false;
+        }
+        *p.state = 1;
+    }
+    return true;
+}
+
+// Деньги двигаются в ledger без mtx; mtx берётся только на запись в образ/журнал
+bool DatabaseManager::post(std::vector<Ledger::Leg> legs, std::vector<json> entries,
+                           std::string* error, std::vector<Money>* after) {
+    if (!options.resident || !ledgerLoaded) {
+        // без резидентного образа ledger каждый раз сверяется с файлом
+        Lock lk(mtx);
+        if (!refreshImage()) {
+            if (error) *error = "Database unavailable.";
+            return false;
+        }
+    }
+
+    auto state = std::make_shared<int>(0);
+    const bool ok = ledger.post(legs, error, [&] {
+        std::lock_guard<std::mutex> pl(postMtx);
+        parked.push_back(Posted{ legs, std::move(entries), state });
+    }, after);
+    if (!ok) return false;
+
+    // свою проводку пишет либо этот вызов, либо тот, кто взял mtx раньше
+    Lock lk(mtx);
+    refreshImage();
+    if (*state != 1) {
+        if (error) *error = "Failed to save.";
+        return false;
+    }
+    return true;
+}
+
+bool DatabaseManager::deposit(int accId, const Money& amount, std::string* error, Money* balanceAfter) {
+    PROF_SCOPE("DatabaseManager::deposit");
+    std::vector<Money> after;
+    if (!post({ Ledger::Leg{ accId, amount, false } }, {}, error, &after)) return false;
+    if (balanceAfter) *balanceAfter = after[0];
+    return true;
+}
+
+bool DatabaseManager::withdraw(int accId, const Money& amount, std::string* error, Money* balanceAfter) {
+    PROF_SCOPE("DatabaseManager::withdraw");
+    std::vector<Money> after;
+    if (!post({ Ledger::Leg{ accId, amount, true } }, {}, error, &after)) return false;
+    if (balanceAfter) *balanceAfter = after[0];
+    return true;
+}
+
+bool DatabaseManager::readBalance(int accId, Money& out) {
+    if (!ledgerLoaded) {
+        Lock lk(mtx);
+        refreshImage();
+    }
+    Ledger::Balance b;
+    if (!ledger.read(accId, b)) return false;
+    out = b.amount;
+    return true;
+}
+
+// Recovery: snapshot + every journal record newer than the snapshot
+void DatabaseManager::replayWal(json& root) {
+    const long long base = root.value("walSeq", 0LL);
+    walSeq = base;
+    wal.replay([&](const json& r) {
+        long long seq = r.value("seq", 0LL);
+        if (seq <= base) return;   // уже есть в снапшоте (упали между снапшотом и reset)
+        applyWalRecord(root, r);
+        if (seq > walSeq) walSeq = seq;
+    });
+}
+
+bool DatabaseManager::commitImage(json walRecord) {
+    if (shards) touchShards(*shards, walRecord);
+    if (batching) {
+        batchDirty = true;
+        return true;
+    }
+
+    if (committer) {
+        // group commit: запись сделает поток, один раз на окно
+        if (options.mode != StorageMode::WriteAheadLog) {
+            pendingSnapshot = true;
+        } else {
+            walRecord["seq"] = ++walSeq;
+            pendingWal.push_back(std::move(walRecord));
+        }
+        committer->notify();
+        return true;
+    }
+
+    if (options.mode != StorageMode::WriteAheadLog) {
+        if (!writeToDisk(image)) {
+            // образ в памяти разошёлся с диском -> перечитать при следующем обращении
+            imageLoaded = false;
+            return false;
+        }
+        imageStamp = stampOf(stampPath());
+        return true;
+    }
+
+    walRecord["seq"] = walSeq + 1;
+    if (!wal.append(walRecord)) {
+        imageLoaded = false;
+        return false;
+    }
+    ++walSeq;
+    walStamp = stampOf(wal.getPath());
+
+    if (wal.records() >= options.walCheckpointRecords ||
+        wal.bytes() >= options.walCheckpointBytes)
+        return checkpointImage();
+    return true;
+}
+
+bool DatabaseManager::checkpointImage() {
+    const bool walMode = options.mode == StorageMode::WriteAheadLog;
+    if (walMode) image["walSeq"] = walSeq;
+
+    // снапшот пишется тем же путём (tmp + .bak + rename); журнал режем только после него
+    if (!writeToDisk(image)) {
+        imageLoaded = false;
+        return false;
+    }
+    imageStamp = stampOf(stampPath());
+
+    if (walMode) {
+        if (!wal.reset()) {
+            imageLoaded = false;
+            return false;
+        }
+        walStamp = stampOf(wal.getPath());
+    }
+    return true;
+}
+
+bool DatabaseManager::persistImage() {
+    if (!committer) return checkpointImage();
+    pendingSnapshot = true;
+    committer->notify();
+    return true;
+}
+
+// Runs on the writer thread. Journal records are appended outside the lock, so
+// the UI keeps mutating the image meanwhile; whole-image writes (Snapshot mode,
+// checkpoints) hold it, as they read the image.
+bool DatabaseManager::persistPending() {
+    std::unique_lock<std::recursive_mutex> lk(mtx);
+    if (!imageLoaded) {
+        pendingWal.clear();
+        pendingSnapshot = false;
+        return false;
+    }
+
+    if (pendingSnapshot) {
+        // образ уже содержит все ждущие записи журнала
+        pendingSnapshot = false;
+        pendingWal.clear();
+        return checkpointImage();
+    }
+    if (pendingWal.empty()) return true;
+
+    std::vector<json> records;
+    records.swap(pendingWal);
+    persisting = true;
+    lk.unlock();
+    const bool ok = wal.append(records);
+    lk.lock();
+    persisting = false;
+
+    if (!ok) {
+        pendingWal.clear();
+        imageLoaded = false;
+        return false;
+    }
+    walStamp = stampOf(wal.getPath());
+
+    if (wal.records() >= options.walCheckpointRecords ||
+        wal.bytes() >= options.walCheckpointBytes) {
+        pendingWal.clear();
+        return checkpointImage();
+    }
+    return true;
+}
+
+bool DatabaseManager::checkpoint() {
+    PROF_SCOPE("DatabaseManager::checkpoint");
+    Lock lk(mtx);
+    if (!refreshImage()) return false;
+    return persistImage();
+}
+
+void DatabaseManager::invalidateCache() {
+    flush();
+    Lock lk(mtx);
+    imageLoaded = false;
+}
+
+std::shared_future<bool> DatabaseManager::durable() {
+    if (committer) return committer->durable();
+    std::promise<bool> p;
+    p.set_value(true);
+    return p.get_future().share();
+}
+
+bool DatabaseManager::flush() {
+    PROF_SCOPE("DatabaseManager::flush");
+    return committer ? committer->flush() : true;
+}
+
+std::uint64_t DatabaseManager::commitCount() const {
+    return committer ? committer->commits() : 0;
+}
+
+// ---------------------- batch ----------------------
+bool DatabaseManager::beginBatch() {
+    flush();   // батч не должен смешиваться с окном, которое ещё пишется
+    Lock lk(mtx);
+    if (batching) return false;
+    if (!refreshImage()) return false;
+    batching = true;
+    batchDirty = false;
+    return true;
+}
+
+bool DatabaseManager::commitBatch() {
+    Lock lk(mtx);
+    if (!batching) return false;
+    batching = false;
+    if (!batchDirty) return true;
+    batchDirty = false;
+    // один снапшот на весь батч (в WAL-режиме журнал заодно обнуляется)
+    return persistImage();
+}
+
+void DatabaseManager::rollbackBatch() {
+    Lock lk(mtx);
+    if (!batching) return;
+    batching = false;
+    batchDirty = false;
+    imageLoaded = false;
+    refreshImage();
+}
+
 // ---------------------- load/save ----------------------
 bool DatabaseManager::loadAll(json& outJson) {
+    PROF_SCOPE("DatabaseManager::loadAll");
+    Lock lk(mtx);
+    if (!refreshImage()) return false;
+    outJson = image;
+    return true;
+}
+
+bool DatabaseManager::saveAll(const json& jIn) {
+    PROF_SCOPE("DatabaseManager::saveAll");
+    json j = jIn;
+    normalizeDb(j);
+
+    Lock lk(mtx);
+    image = std::move(j);
+    imageLoaded = true;
+    rebuildIndexes();
+    if (shards) shards->touchAll();
+    if (batching) {
+        batchDirty = true;
+        return true;
+    }
+    return persistImage();
+}
+
+bool DatabaseManager::readFromDisk(json& outJson) {
+    PROF_SCOPE("DatabaseManager::readFromDisk");
     ensureParentDir(filename);
 
+    // Sharded: каталог с манифестом (пустой создаётся сам)
+    if (shards) {
+        if (!shards->load(outJson)) return false;
+        normalizeDb(outJson);
+        return true;
+    }
+
     // 1) Файла нет -> создаём новый
     if (!fileExists(filename)) {
         outJson = makeEmptyDb();
-        return saveAll(outJson);
+        return writeToDisk(outJson);
     }
 
     // 2) Файл есть, но пустой -> создаём новый
     if (fileEmpty(filename)) {
         outJson = makeEmptyDb();
-        return saveAll(outJson);
+        return writeToDisk(outJson);
     }
 
-    // 3) Пытаемся прочитать JSON
-    std::ifstream in(filename);
+    // 3) Бинарный снапшот, если он снят ровно с этого файла
+    if (options.binarySnapshot && readBinarySnapshot(outJson)) return true;
+
+    // 4) Пытаемся прочитать документ (JSON / CBOR / MessagePack — по содержимому)
+    std::ifstream in(filename, std::ios::binary);
     if (!in) {
         // странный кейс: файл существует, но не открывается -> создаём
         outJson = makeEmptyDb();
-        return saveAll(outJson);
+        return writeToDisk(outJson);
     }
+    std::string bytes((std::istreambuf_iterator<char>(in)), std::istreambuf_iterator<char>());
+    in.close();
+    PROF_BYTES_READ(bytes.size());
 
-    try {
-        in >> outJson;
+    if (decodeDocument(bytes, outJson)) {
         normalizeDb(outJson);
         return true;
-    } catch (...) {
-        // 4) Битый JSON -> переименовать и создать новый
-        std::error_code ec;
-        fs::path bad = fs::path(filename).concat(".corrupt");
-        fs::rename(filename, bad, ec);
-
-        outJson = makeEmptyDb();
-        return saveAll(outJson);
     }
+
+    // 5) Битый файл -> переименовать и создать новый
+    std::error_code ec;
+    fs::path bad = fs::path(filename).concat(".corrupt");
+    fs::rename(filename, bad, ec);
+
+    outJson = makeEmptyDb();
+    return writeToDisk(outJson);
 }
 
-bool DatabaseManager::saveAll(const json& jIn) {
+FileFormat DatabaseManager::writeFormat() const {
+    return options.format == FileFormat::Auto ? formatFromPath(filename) : options.format;
+}
+
+bool DatabaseManager::writeToDisk(const json& j) {
+    PROF_SCOPE("DatabaseManager::writeToDisk");
     ensureParentDir(filename);
 
-    json j = jIn;
-    normalizeDb(j);
+    // Sharded: только затронутые шарды + новые строки лога + манифест
+    if (shards) return shards->commit(j);
 
     // atomic save: tmp -> filename, плюс bak
     const std::string tmp = filename + ".tmp";
     const std::string bak = filename + ".bak";
 
-    // 1) write tmp
+    // 1) write tmp (fsync: rename должен открыть уже записанные данные)
     {
-        std::ofstream out(tmp, std::ios::trunc);
-        if (!out) return false;
-        out << std::setw(4) << j << std::endl;
-        if (!out.good()) return false;
+        const std::string bytes = encodeDocument(j, writeFormat());
+        if (!writeFileSynced(tmp, bytes, false)) return false;
+        PROF_BYTES_WRITTEN(bytes.size());
     }
 
     // 2) create backup of current
@@ -187,6 +999,8 @@ bool DatabaseManager::saveAll(const json& jIn) {
         std::ifstream src(filename, std::ios::binary);
         std::ofstream dst(bak, std::ios::binary | std::ios::trunc);
         if (src && dst) dst << src.rdbuf();
+        PROF_BYTES_READ(std::max<std::streamoff>(dst.tellp(), 0));   // .bak: весь файл ещё раз
+        PROF_BYTES_WRITTEN(std::max<std::streamoff>(dst.tellp(), 0));
     }
 
     // 3) replace
@@ -195,86 +1009,92 @@ bool DatabaseManager::saveAll(const json& jIn) {
     if (ec) {
         // если rename не удалось (например другой диск) -> fallback copy+remove
         std::ifstream src(tmp, std::ios::binary);
-        std::ofstream dst(filename, std::ios::binary | std::ios::trunc);
-        if (!src || !dst) return false;
-        dst << src.rdbuf();
-        dst.close();
+        if (!src) return false;
+        std::string bytes((std::istreambuf_iterator<char>(src)), std::istreambuf_iterator<char>());
+        if (!writeFileSynced(filename, bytes, false)) return false;
+        src.close();
         std::remove(tmp.c_str());
     }
-    return true;
-}
+    // сам rename переживает сбой питания только с fsync каталога
+    if (!syncDir(parentDirOf(filename))) return false;
 
-// ---------------------- Customers ----------------------
-bool DatabaseManager::customerExists(const std::string& id) {
-    json root;
-    if (!loadAll(root)) return false;
-    const auto& custs = customersRefConst(root);
-    return custs.contains(id);
+    if (options.binarySnapshot) writeBinarySnapshot(j);
+    return true;
 }
 
-bool DatabaseManager::addOrUpdateCustomer(const Customer& customer) {
-    json root;
-    if (!loadAll(root)) return false;
-    json& custs = customersRef(root);
-
-    json c = json::object();
-    c["firstName"]  = customer.getFirstName();
-    c["lastName"]   = customer.getLastName();
-    c["name"]       = customer.getFullName(); // для читаемости/совместимости
-    c["age"]        = customer.getAge();
-    c["email"]      = customer.getEmail();
-    c["secretWord"] = customer.getSecretWord();
-    c["phone"]      = customer.getPhone();
+// ---------------------- binary snapshot ----------------------
+bool DatabaseManager::readBinarySnapshot(json& outJson) {
+    SnapshotSource src;
+    if (!BinarySnapshot::readSource(binarySnapshotPath(), src)) return false;
 
-    c["accounts"] = json::array();
-    for (const auto& acc : customer.getAccounts()) {
-        json a = json::object();
-        a["accId"]   = acc.getId();
-        a["type"]    = acc.getType();
-        a["balance"] = acc.getBalance();
+    // .snap годится только для того JSON, с которого он снят
+    FileStamp st = stampOf(filename);
+    if (!st.exists || !(src == SnapshotSource{ st.size, st.mtimeNs, st.inode })) return false;
 
-        if (acc.getType() == "Savings") {
-            a["savingsRate"]   = acc.getSavingsRate();
-            a["lastSavedDate"] = acc.getLastSavedDate();
-        }
-        if (acc.getType() == "FX") {
-            a["currency"] = acc.getCurrency();
-        }
+    json root;
+    if (!BinarySnapshot::read(binarySnapshotPath(), root)) return false;
+    normalizeDb(root);
+    outJson = std::move(root);
+    return true;
+}
 
-        c["accounts"].push_back(a);
-    }
+void DatabaseManager::writeBinarySnapshot(const json& j) {
+    FileStamp st = stampOf(filename);
+    if (st.exists && BinarySnapshot::write(j, SnapshotSource{ st.size, st.mtimeNs, st.inode },
+                                           binarySnapshotPath()))
+        return;
 
-    custs[customer.getId()] = c;
-    return saveAll(root);
+    // не получилось -> убрать старый, чтобы не читать его по ошибке
+    std::error_code ec;
+    fs::remove(binarySnapshotPath(), ec);
 }
 
-static inline void deriveNamesFromLegacy(const json& cust, std::string& outFirst, std::string& outLast) {
-    outFirst = cust.value("firstName", "");
-    outLast  = cust.value("lastName", "");
-    if (!outFirst.empty() || !outLast.empty()) return;
-
-    std::string full = trim_copy(cust.value("name", ""));
-    if (full.empty()) return;
+// ---------------------- Customers ----------------------
+bool DatabaseManager::customerExists(const std::string& id) {
+    PROF_SCOPE("DatabaseManager::customerExists");
+    Lock lk(mtx);
+    if (!refreshImage()) return false;
+    const auto& custs = customersRefConst(image);
+    return custs.contains(id);
+}
 
-    // простой split: first = first word, last = last word
-    std::string first, last;
-    size_t sp = full.find(' ');
-    if (sp == std::string::npos) {
-        first = full;
-        last = "";
-    } else {
-        first = trim_copy(full.substr(0, sp));
-        last  = trim_copy(full.substr(full.find_last_of(' ') + 1));
-    }
-    outFirst = first;
-    outLast  = last;
+bool DatabaseManager::addOrUpdateCustomer(const Customer& customer) {
+    PROF_SCOPE("DatabaseManager::addOrUpdateCustomer");
+    Lock lk(mtx);
+    if (!refreshImage()) return false;
+    json& custs = customersRef(image);
+
+    json c = customerToJson(customer);
+    auto old = custs.find(customer.getId());
+    if (old != custs.end()) keepUnreadableFields(*old, c);
+    json rec;
+    if (!customerRecord(custs, customer.getId(), c, rec)) return true; // ничего не изменилось -> без записи
+
+    if (old != custs.end()) unindexCustomer(customer.getId(), *old);
+    indexCustomer(customer.getId(), c);
+    mirrorLedger(old != custs.end() ? &*old : nullptr, &c);
+
+    custs[customer.getId()] = std::move(c);
+    return commitImage(std::move(rec));
 }
 
 bool DatabaseManager::loadCustomer(const std::string& id, Customer& outCustomer) {
-    json root;
-    if (!loadAll(root)) return false;
+    PROF_SCOPE("DatabaseManager::loadCustomer");
+    Lock lk(mtx);
+
+    // Без резидентного образа файл всё равно читается на каждый вызов ->
+    // одного клиента достаём потоково, не строя весь документ
+    if (!options.resident && options.mode == StorageMode::Snapshot && !batching && !hasUnpersisted() &&
+        !hasParked()) {
+        std::string err;
+        if (streamLoadCustomer(filename, id, outCustomer, &err)) return true;
+        if (err == "Customer not found.") return false;
+        // нечитаемый файл -> обычный путь (создаст новый / отложит .corrupt)
+    }
 
-    const auto& custs = customersRefConst(root);
+    if (!refreshImage()) return false;
+
+    const auto& custs = customersRefConst(image);
     if (!custs.contains(id)) return false;
 
     const json& cust = custs[id];
@@ -292,47 +1112,57 @@ bool DatabaseManager::loadCustomer(const std::string& id, Customer& outCustomer)
     if (cust.contains("accounts") && cust["accounts"].is_array()) {
         for (const auto& a : cust["accounts"]) {
             int accId = a.value("accId", 0);
-            std::string type = a.value("type", "Checking");
-            double bal = a.value("balance", 0.0);
+            AccountType type = accountTypeFromName(a.value("type", "Checking"));
+            CurrencyCode cur = (type == AccountType::FX)
+                ? CurrencyCode::fromString(a.value("currency", ""))
+                : EUR;
 
-            Account acc(accId, type, bal);
+            Account acc(accId, type, readMoney(a, "balance", "balanceMinor", cur));
 
-            if (type == "Savings") {
+            if (type == AccountType::Savings) {
                 acc.setSavingsRate(a.value("savingsRate", 0.15));
-                acc.setLastSavedDate(a.value("lastSavedDate", ""));
-            }
-            if (type == "FX") {
-                acc.setCurrency(a.value("currency", ""));
+                acc.setLastSaved(Date::fromIso(a.value("lastSavedDate", "")));
             }
 
             outCustomer.addAccount(acc);
         }
     }
+    // балансы - из ledger: он впереди образа на проводки, идущие прямо сейчас
+    ledger.refresh(outCustomer);
     return true;
 }
 
 bool DatabaseManager::removeCustomer(const std::string& id) {
-    json root;
-    if (!loadAll(root)) return false;
-    json& custs = customersRef(root);
+    PROF_SCOPE("DatabaseManager::removeCustomer");
+    Lock lk(mtx);
+    if (!refreshImage()) return false;
+    json& custs = customersRef(image);
 
     if (!custs.contains(id)) return false;
+    unindexCustomer(id, custs[id]);
+    mirrorLedger(&custs[id], nullptr);
     custs.erase(id);
-    return saveAll(root);
+
+    json rec = json::object();
+    rec["op"] = "remove";
+    rec["id"] = id;
+    return commitImage(std::move(rec));
 }
 
 bool DatabaseManager::verifySecret(const std::string& id, const std::string& secret) const {
-    json root;
-    if (!const_cast<DatabaseManager*>(this)->loadAll(root)) return false;
-    const auto& custs = customersRefConst(root);
+    Lock lk(mtx);
+    auto* self = const_cast<DatabaseManager*>(this);
+    if (!self->refreshImage()) return false;
+    const auto& custs = customersRefConst(image);
     if (!custs.contains(id)) return false;
     return custs[id].value("secretWord", "") == secret;
 }
 
 bool DatabaseManager::verifyPhone(const std::string& id, const std::string& phone) {
-    json root;
-    if (!loadAll(root)) return false;
-    const auto& custs = customersRefConst(root);
+    PROF_SCOPE("DatabaseManager::verifyPhone");
+    Lock lk(mtx);
+    if (!refreshImage()) return false;
+    const auto& custs = customersRefConst(image);
     if (!custs.contains(id)) return false;
     return custs[id].value("phone", "") == phone;
 }
@@ -340,152 +1170,512 @@ bool DatabaseManager::verifyPhone(const std::string& id, const std::string& phon
 bool DatabaseManager::changeSecret(const std::string& id,
                                    const std::string& oldSecret,
                                    const std::string& newSecret) {
-    json root;
-    if (!loadAll(root)) return false;
-    json& custs = customersRef(root);
+    PROF_SCOPE("DatabaseManager::changeSecret");
+    Lock lk(mtx);
+    if (!refreshImage()) return false;
+    json& custs = customersRef(image);
 
     if (!custs.contains(id)) return false;
     if (custs[id].value("secretWord", "") != oldSecret) return false;
 
     custs[id]["secretWord"] = newSecret;
-    return saveAll(root);
+
+    json rec = json::object();
+    rec["op"] = "upsert";
+    rec["id"] = id;
+    rec["customer"] = custs[id];
+    return commitImage(std::move(rec));
 }
 
 bool DatabaseManager::resetSecretWithEmail(const std::string& id,
                                            const std::string& email,
                                            const std::string& newSecret) {
-    json root;
-    if (!loadAll(root)) return false;
-    json& custs = customersRef(root);
+    PROF_SCOPE("DatabaseManager::resetSecretWithEmail");
+    Lock lk(mtx);
+    if (!refreshImage()) return false;
+    json& custs = customersRef(image);
 
     if (!custs.contains(id)) return false;
     if (custs[id].value("email", "") != email) return false;
 
     custs[id]["secretWord"] = newSecret;
-    return saveAll(root);
+
+    json rec = json::object();
+    rec["op"] = "upsert";
+    rec["id"] = id;
+    rec["customer"] = custs[id];
+    return commitImage(std::move(rec));
 }
 
 // ---------------------- findCustomerByName ----------------------
 bool DatabaseManager::findCustomerByName(const std::string& firstName,
                                         const std::string& lastName,
                                         std::string& outId) {
-    json root;
-    if (!loadAll(root)) return false;
-    const auto& custs = customersRefConst(root);
+    PROF_SCOPE("DatabaseManager::findCustomerByName");
+    std::vector<std::string> ids = findCustomersByName(firstName, lastName);
+    if (ids.empty()) return false;
+    outId = ids.front();
+    return true;
+}
 
-    std::string fn = lower_copy(trim_copy(firstName));
-    std::string ln = lower_copy(trim_copy(lastName));
-    if (fn.empty() || ln.empty()) return false;
+std::vector<std::string> DatabaseManager::findCustomersByName(const std::string& firstName,
+                                                              const std::string& lastName) {
+    PROF_SCOPE("DatabaseManager::findCustomersByName");
+    Lock lk(mtx);
+    if (!refreshImage()) return {};
 
-    for (auto it = custs.begin(); it != custs.end(); ++it) {
-        const std::string id = it.key();
-        const auto& cust = it.value();
-
-        std::string cfn = lower_copy(trim_copy(cust.value("firstName", "")));
-        std::string cln = lower_copy(trim_copy(cust.value("lastName", "")));
-        if (!cfn.empty() || !cln.empty()) {
-            if (cfn == fn && cln == ln) { outId = id; return true; }
-            continue;
-        }
+    std::string key = nameKeyOf(firstName, lastName);
+    if (key.empty()) return {};
 
-        // legacy fallback: compare name
-        std::string full = lower_copy(trim_copy(cust.value("name", "")));
-        if (full == (fn + " " + ln)) { outId = id; return true; }
-    }
-    return false;
+    auto it = nameIndex.find(key);
+    if (it == nameIndex.end()) return {};
+    return it->second;
 }
 
 // ---------------------- transfers log ----------------------
 bool DatabaseManager::appendTransferLog(const json& entry) {
-    json root;
-    if (!loadAll(root)) return false;
-    normalizeDb(root);
+    PROF_SCOPE("DatabaseManager::appendTransferLog");
+    Lock lk(mtx);
+    if (!refreshImage()) return false;
 
     json e = entry;
     if (!e.contains("ts")) e["ts"] = nowEpochMs();
 
-    root["transfers"].push_back(e);
-    return saveAll(root);
+    json rec = json::object();
+    rec["op"] = "transfer";
+    rec["entry"] = e;
+
+    image["transfers"].push_back(std::move(e));
+    indexTransfer(image["transfers"].size() - 1);
+    return commitImage(std::move(rec));
 }
 
 std::vector<json> DatabaseManager::getTransfersForCustomer(const std::string& customerId,
                                                            int daysBack /*0=all*/) {
+    PROF_SCOPE("DatabaseManager::getTransfersForCustomer");
+    Lock lk(mtx);
     std::vector<json> out;
-    json root;
-    if (!loadAll(root)) return out;
-    normalizeDb(root);
+    if (!refreshImage()) return out;
 
-    const auto& arr = root["transfers"];
-    if (!arr.is_array()) return out;
+    auto it = transferIndex.find(customerId);
+    if (it == transferIndex.end()) return out;
 
-    for (const auto& e : arr) {
-        std::string fromId = e.value("fromCustomerId", "");
-        std::string toId   = e.value("toCustomerId", "");
-        if (fromId != customerId && toId != customerId) continue;
+    const long long sinceTs = sinceTsForDaysBack(daysBack);
+    const auto& arr = image["transfers"];
+    for (auto r = it->second.rbegin(); r != it->second.rend() && r->ts >= sinceTs; ++r)
+        out.push_back(arr[r->offset]);
+    return out;
+}
+
+TransferPage DatabaseManager::queryTransfers(const std::string& customerId, long long sinceTs,
+                                             std::size_t limit, std::size_t cursor) {
+    PROF_SCOPE("DatabaseManager::queryTransfers");
+    Lock lk(mtx);
+    TransferPage page;
+    page.nextCursor = cursor;
+    if (!refreshImage()) return page;
+
+    auto it = transferIndex.find(customerId);
+    if (it == transferIndex.end()) return page;
+
+    const auto& refs = it->second;
+    const auto& arr = image["transfers"];
+    if (cursor >= refs.size()) return page;
+
+    // refs отсортированы по возрастанию ts -> идём с конца
+    std::size_t pos = refs.size() - cursor;   // one past the next entry to return
+    page.items.reserve(std::min(limit, pos));
+    while (pos > 0 && page.items.size() < limit) {
+        const TransferRef& r = refs[pos - 1];
+        if (r.ts < sinceTs) break;
+        page.items.push_back(toTransferRecord(arr[r.offset]));
+        --pos;
+    }
+    page.nextCursor = refs.size() - pos;
+    page.hasMore = pos > 0 && refs[pos - 1].ts >= sinceTs;
+    return page;
+}
+
+std::uint64_t DatabaseManager::transfersVersion() {
+    PROF_SCOPE("DatabaseManager::transfersVersion");
+    Lock lk(mtx);
+    refreshImage();
+    return transferGen;
+}
 
-        if (daysBack > 0) {
-            long long ts = e.value("ts", 0LL);
-            if (daysBackFromNow(ts) > daysBack) continue;
+// Same window as before: an entry is kept while (now - ts) / day <= daysBack
+long long DatabaseManager::sinceTsForDaysBack(int daysBack) {
+    if (daysBack <= 0) return 0;
+    return nowEpochMs() - (long long)(daysBack + 1) * MS_PER_DAY + 1;
+}
+
+// ---------------------- transactions ----------------------
+DatabaseManager::Transaction& DatabaseManager::Transaction::credit(int accId, const Money& amount) {
+    Step st;
+    st.kind = Step::Credit;
+    st.accId = accId;
+    st.amount = amount;
+    steps.push_back(std::move(st));
+    return *this;
+}
+
+DatabaseManager::Transaction& DatabaseManager::Transaction::debit(int accId, const Money& amount) {
+    Step st;
+    st.kind = Step::Debit;
+    st.accId = accId;
+    st.amount = amount;
+    steps.push_back(std::move(st));
+    return *this;
+}
+
+DatabaseManager::Transaction& DatabaseManager::Transaction::putCustomer(const Customer& customer) {
+    Step st;
+    st.kind = Step::Put;
+    st.data = { { "id", customer.getId() }, { "customer", customerToJson(customer) } };
+    steps.push_back(std::move(st));
+    return *this;
+}
+
+DatabaseManager::Transaction& DatabaseManager::Transaction::log(const json& transferEntry) {
+    Step st;
+    st.kind = Step::Log;
+    st.data = transferEntry;
+    steps.push_back(std::move(st));
+    return *this;
+}
+
+bool DatabaseManager::Transaction::commit(std::string* error) {
+    PROF_SCOPE("DatabaseManager::Transaction::commit");
+    auto fail = [&](const std::string& msg) {
+        if (error) *error = msg;
+        steps.clear();
+        return false;
+    };
+    std::vector<Step> todo;
+    todo.swap(steps);   // транзакция одноразовая
+
+    // Только деньги и лог -> проводка в ledger, mtx лишь на запись в образ
+    if (std::none_of(todo.begin(), todo.end(), [](const Step& st){ return st.kind == Step::Put; })) {
+        std::vector<Ledger::Leg> legs;
+        std::vector<json> entries;
+        for (auto& st : todo) {
+            if (st.kind == Step::Log) {
+                if (!st.data.contains("ts")) st.data["ts"] = nowEpochMs();
+                entries.push_back(std::move(st.data));
+                continue;
+            }
+            if (st.amount.isNegative()) return fail("Invalid amount.");
+            if (st.amount.isZero()) continue;
+            legs.push_back(Ledger::Leg{ st.accId, st.amount, st.kind == Step::Debit });
         }
-        out.push_back(e);
+        if (legs.empty() && entries.empty()) return true;
+        return db->post(std::move(legs), std::move(entries), error);
     }
 
-    std::sort(out.begin(), out.end(),
-              [](const json& a, const json& b){
-                  return a.value("ts", 0LL) > b.value("ts", 0LL);
-              });
-    return out;
+    Lock lk(db->mtx);
+    if (!db->refreshImage()) return fail("Database unavailable.");
+    json& custs = customersRef(db->image);
+
+    // Всё применяется к копиям затронутых клиентов; образ меняется только
+    // после того, как прошли все шаги.
+    std::map<std::string, json> touched;
+    std::vector<json> entries;
+
+    auto findAccount = [&](int accId) -> json* {
+        for (auto& kv : touched) {
+            for (auto& a : kv.second["accounts"])
+                if (a.value("accId", 0) == accId) return &a;
+        }
+        auto it = db->accountIndex.find(accId);
+        if (it == db->accountIndex.end() || !custs.contains(it->second.customerId)) return nullptr;
+        json& c = touched.emplace(it->second.customerId, custs[it->second.customerId]).first->second;
+        json& accs = c["accounts"];
+        if (!accs.is_array() || it->second.slot >= (int)accs.size()) return nullptr;
+        json& acc = accs[it->second.slot];
+        return acc.value("accId", 0) == accId ? &acc : nullptr;   // putCustomer мог убрать счёт
+    };
+
+    for (auto& st : todo) {
+        if (st.kind == Step::Put) {
+            const std::string id = st.data["id"].get<std::string>();
+            json& c = touched[id] = std::move(st.data["customer"]);
+            auto old = custs.find(id);
+            if (old != custs.end()) keepUnreadableFields(*old, c);
+            continue;
+        }
+        if (st.kind == Step::Log) {
+            if (!st.data.contains("ts")) st.data["ts"] = nowEpochMs();
+            entries.push_back(std::move(st.data));
+            continue;
+        }
+
+        json* a = findAccount(st.accId);
+        if (!a) return fail("Account #" + std::to_string(st.accId) + " not found.");
+        const CurrencyCode cur = accountCurrency(*a);
+        if (st.amount.currency() != cur) return fail("Currency mismatch on account #" + std::to_string(st.accId) + ".");
+        if (st.amount.isNegative()) return fail("Invalid amount.");
+
+        Money bal = readMoney(*a, "balance", "balanceMinor", cur);
+        if (st.kind == Step::Debit) {
+            if (bal < st.amount) return fail("Insufficient funds.");
+            bal = bal - st.amount;
+        } else {
+            bal = bal + st.amount;
+        }
+        (*a)["balanceMinor"] = bal.minorUnits();
+        (*a)["balance"]      = bal.toMajor();
+    }
+
+    json ops = json::array();
+    for (auto& kv : touched) {
+        json rec;
+        if (!customerRecord(custs, kv.first, kv.second, rec)) continue;
+        ops.push_back(std::move(rec));
+
+        auto old = custs.find(kv.first);
+        if (old != custs.end()) db->unindexCustomer(kv.first, *old);
+        db->indexCustomer(kv.first, kv.second);
+        db->mirrorLedger(old != custs.end() ? &*old : nullptr, &kv.second);
+        custs[kv.first] = std::move(kv.second);
+    }
+    for (auto& e : entries) {
+        ops.push_back({ { "op", "transfer" }, { "entry", e } });
+        db->image["transfers"].push_back(std::move(e));
+        db->indexTransfer(db->image["transfers"].size() - 1);
+    }
+    if (ops.empty()) return true;
+
+    json rec;
+    if (ops.size() == 1) {
+        rec = std::move(ops[0]);
+    } else {
+        rec["op"] = "tx";
+        rec["ops"] = std::move(ops);
+    }
+    if (!db->commitImage(std::move(rec))) return fail("Failed to save.");
+    return true;
 }
 
-// ---------------------- account id helpers ----------------------
-int DatabaseManager::generateUniqueAccountId() {
-    json root;
-    if (!loadAll(root)) {
-        return (std::rand() % 900000) + 100000;
+bool DatabaseManager::transfer(int fromAccId, int toAccId, const Money& amount,
+                               json logEntry, std::string* error) {
+    PROF_SCOPE("DatabaseManager::transfer");
+    if (!amount.isPositive()) {
+        if (error) *error = "Invalid amount.";
+        return false;
     }
-    normalizeDb(root);
 
-    const auto& custs = customersRefConst(root);
+    logEntry["status"] = "ok";
+    logEntry["error"] = "";
+    logEntry["fromAccId"] = fromAccId;   // id клиентов проставит запись в образ
+    logEntry["toAccId"] = toAccId;
+    logEntry["amountMinor"] = amount.minorUnits();
+    logEntry["amount"] = amount.toMajor();
+
+    return beginTransaction().debit(fromAccId, amount).credit(toAccId, amount).log(logEntry).commit(error);
+}
+
+// ---------------------- savings interest ----------------------
+static SavingsRow savingsRowOf(const json& a) {
+    SavingsRow r;
+    r.balanceMinor = readMoney(a, "balance", "balanceMinor", EUR).minorUnits();
+    r.rate = a.value("savingsRate", 0.15);
+    const std::string last = a.value("lastSavedDate", "");
+    if (last.empty()) r.dated = SavingsRow::Dated::Missing;
+    else if (!Date::parse(last, r.last)) r.dated = SavingsRow::Dated::Unreadable;
+    return r;
+}
 
-    std::vector<int> used;
+bool DatabaseManager::accrueSavingsInterest(Date today, AccrualReport& report, std::size_t threads) {
+    PROF_SCOPE("DatabaseManager::accrueSavingsInterest");
+    using Clock = std::chrono::steady_clock;
+    const auto t0 = Clock::now();
+    report = AccrualReport();
+    report.date = today;
+
+    if (today.empty()) return false;
+    const std::string todayIso = today.iso();
+
+    Lock lk(mtx);
+    if (!refreshImage()) return false;
+    json& custs = customersRef(image);
+
+    // 1) один проход по образу: Savings-счета -> компактный массив строк
+    std::vector<SavingsRow> rows;
+    std::vector<json*> where;   // where[i] = счёт rows[i] в образе
+    std::vector<const std::string*> owner;   // Sharded: клиент rows[i]
+    rows.reserve(accountIndex.size());
+    where.reserve(accountIndex.size());
     for (auto it = custs.begin(); it != custs.end(); ++it) {
-        const auto& cust = it.value();
-        if (!cust.contains("accounts") || !cust["accounts"].is_array()) continue;
-        for (const auto& a : cust["accounts"]) {
-            used.push_back(a.value("accId", 0));
+        json& c = it.value();
+        if (!c.is_object() || !c.contains("accounts") || !c["accounts"].is_array()) continue;
+        for (auto& a : c["accounts"]) {
+            if (!a.is_object() || a.value("type", "") != "Savings") continue;
+            rows.push_back(savingsRowOf(a));
+            where.push_back(&a);
+            if (shards) owner.push_back(&it.key());
+        }
+    }
+    report.accounts = rows.size();
+
+    // 2) проценты: только арифметика над строками, параллельно
+    const auto tc = Clock::now();
+    computeAccrual(rows, today, threads);
+    report.computeMs = std::chrono::duration<double, std::milli>(Clock::now() - tc).count();
+
+    // 3) обратно в образ; индексы не меняются (ни id, ни имена)
+    std::int64_t total = 0;
+    bool changed = false;
+    for (std::size_t i = 0; i < rows.size(); ++i) {
+        const SavingsRow& r = rows[i];
+        if (!r.touched) continue;
+        json& a = *where[i];
+        if (r.interestMinor > 0) {
+            const Money bal(r.balanceMinor + r.interestMinor, EUR);
+            a["balanceMinor"] = bal.minorUnits();
+            a["balance"]      = bal.toMajor();
+            ledger.adjust(a.value("accId", 0), Money(r.interestMinor, EUR));
+            total += r.interestMinor;
+            ++report.credited;
         }
+        if (r.dated == SavingsRow::Dated::Missing) ++report.dated;
+        a["lastSavedDate"] = todayIso;
+        if (shards) shards->touchCustomer(*owner[i]);
+        changed = true;
     }
+    report.totalInterest = Money(total, EUR);
 
-    auto exists = [&](int x){
-        return std::find(used.begin(), used.end(), x) != used.end();
-    };
+    bool ok = true;
+    if (changed) {
+        // один снапшот на весь прогон, как commitBatch()
+        if (batching) batchDirty = true;
+        else ok = persistImage();
+    }
+    report.totalMs = std::chrono::duration<double, std::milli>(Clock::now() - t0).count();
+    return ok;
+}
 
-    int candidate = (std::rand() % 900000) + 100000;
-    int tries = 0;
-    while (exists(candidate) && tries < 200000) {
-        candidate = (std::rand() % 900000) + 100000;
-        ++tries;
+bool DatabaseManager::accrueCustomerInterest(const std::string& id, Date today, Money* credited) {
+    PROF_SCOPE("DatabaseManager::accrueCustomerInterest");
+    if (credited) *credited = Money(0, EUR);
+    if (today.empty()) return false;
+
+    Lock lk(mtx);
+    if (!refreshImage()) return false;
+    json& custs = customersRef(image);
+    auto old = custs.find(id);
+    if (old == custs.end()) return false;
+    if (!old->contains("accounts") || !(*old)["accounts"].is_array()) return true;
+
+    // те же строки и та же арифметика, что у accrueSavingsInterest, на копии клиента
+    json c = *old;
+    std::vector<SavingsRow> rows;
+    std::vector<json*> where;
+    for (auto& a : c["accounts"]) {
+        if (!a.is_object() || a.value("type", "") != "Savings") continue;
+        rows.push_back(savingsRowOf(a));
+        where.push_back(&a);
     }
-    return candidate;
+    computeAccrual(rows, today, 1);
+
+    std::int64_t total = 0;
+    bool changed = false;
+    for (std::size_t i = 0; i < rows.size(); ++i) {
+        if (!rows[i].touched) continue;
+        json& a = *where[i];
+        if (rows[i].interestMinor > 0) {
+            const Money bal(rows[i].balanceMinor + rows[i].interestMinor, EUR);
+            a["balanceMinor"] = bal.minorUnits();
+            a["balance"]      = bal.toMajor();
+            total += rows[i].interestMinor;
+        }
+        a["lastSavedDate"] = today.iso();
+        changed = true;
+    }
+    if (!changed) return true;
+
+    json rec;
+    customerRecord(custs, id, c, rec);
+    for (std::size_t i = 0; i < rows.size(); ++i) {
+        if (rows[i].interestMinor > 0) ledger.adjust(where[i]->value("accId", 0), Money(rows[i].interestMinor, EUR));
+    }
+    *old = std::move(c);
+    if (credited) *credited = Money(total, EUR);
+    return commitImage(std::move(rec));
+}
+
+// ---------------------- account id helpers ----------------------
+bool DatabaseManager::findAccountOwner(int accId, AccountLocation& out) {
+    PROF_SCOPE("DatabaseManager::findAccountOwner");
+    Lock lk(mtx);
+    if (!refreshImage()) return false;
+    auto it = accountIndex.find(accId);
+    if (it == accountIndex.end()) return false;
+    out = it->second;
+    return true;
+}
+
+int DatabaseManager::generateUniqueAccountId() {
+    Lock lk(mtx);
+    refreshImage();
+
+    int id = accountIds.allocate();
+    while (id == 0 && accountIds.getDigits() < AccountIdAllocator::MAX_DIGITS) {
+        if (!setAccountIdDigits(accountIds.getDigits() + 1)) break;
+        id = accountIds.allocate();
+    }
+    return id;
+}
+
+std::vector<int> DatabaseManager::reserveAccountIds(std::size_t count) {
+    Lock lk(mtx);
+    refreshImage();
+
+    while (accountIds.freeIds() < count && accountIds.getDigits() < AccountIdAllocator::MAX_DIGITS) {
+        if (!setAccountIdDigits(accountIds.getDigits() + 1)) break;
+    }
+    return accountIds.reserve(count);
+}
+
+void DatabaseManager::releaseAccountId(int accId) {
+    Lock lk(mtx);
+    accountIds.release(accId);
+}
+
+bool DatabaseManager::setAccountIdDigits(int digits) {
+    Lock lk(mtx);
+    if (!refreshImage()) return false;
+    if (digits <= accountIds.getDigits()) return true;
+    if (digits > AccountIdAllocator::MAX_DIGITS) return false;
+
+    if (!image.contains("meta") || !image["meta"].is_object()) image["meta"] = json::object();
+    image["meta"]["accountIdDigits"] = digits;
+    accountIds.widen(digits);
+
+    json rec = json::object();
+    rec["op"] = "meta";
+    rec["meta"] = image["meta"];
+    return commitImage(std::move(rec));
 }
 
 std::vector<int> DatabaseManager::existingAccountIds() {
+    Lock lk(mtx);
     std::vector<int> out;
-    json root;
-    if (!loadAll(root)) return out;
-    normalizeDb(root);
+    if (!refreshImage()) return out;
 
-    const auto& custs = customersRefConst(root);
-    for (auto it = custs.begin(); it != custs.end(); ++it) {
-        const auto& cust = it.value();
-        if (!cust.contains("accounts") || !cust["accounts"].is_array()) continue;
-        for (const auto& a : cust["accounts"]) {
-            int id = a.value("accId", 0);
-            if (id > 0) out.push_back(id);
-        }
-    }
+    out.reserve(accountIndex.size());
+    for (const auto& kv : accountIndex) out.push_back(kv.first);
 
     std::sort(out.begin(), out.end());
-    out.erase(std::unique(out.begin(), out.end()), out.end());
+    return out;
+}
+
+std::vector<std::pair<int, Money>> DatabaseManager::accountBalances() {
+    Lock lk(mtx);
+    std::vector<std::pair<int, Money>> out;
+    if (!refreshImage()) return out;
+
+    out.reserve(accountIndex.size());
+    const auto& custs = customersRefConst(image);
+    for (auto it = custs.begin(); it != custs.end(); ++it) collectBalances(it.value(), out);
     return out;
 }
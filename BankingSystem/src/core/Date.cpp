@@ -0,0 +1,75 @@
+#include "Date.h"
+
+#include <chrono>
+#include <ctime>
+
+// H. Hinnant, "chrono-Compatible Low-Level Date Algorithms": days_from_civil /
+// civil_from_days, эры по 400 лет, без mktime и без TZ
+Date Date::fromCivil(int y, unsigned m, unsigned d) {
+    y -= m <= 2;
+    const int era = (y >= 0 ? y : y - 399) / 400;
+    const unsigned yoe = (unsigned)(y - era * 400);
+    const unsigned doy = (153 * (m + (m > 2 ? -3 : 9)) + 2) / 5 + d - 1;
+    const unsigned doe = yoe * 365 + yoe / 4 - yoe / 100 + doy;
+    return Date(era * 146097 + (std::int32_t)doe - 719468);
+}
+
+void Date::toCivil(int& y, unsigned& m, unsigned& d) const {
+    const std::int32_t z = days + 719468;
+    const int era = (z >= 0 ? z : z - 146096) / 146097;
+    const unsigned doe = (unsigned)(z - era * 146097);
+    const unsigned yoe = (doe - doe / 1460 + doe / 36524 - doe / 146096) / 365;
+    const unsigned doy = doe - (365 * yoe + yoe / 4 - yoe / 100);
+    const unsigned mp = (5 * doy + 2) / 153;
+    d = doy - (153 * mp + 2) / 5 + 1;
+    m = mp < 10 ? mp + 3 : mp - 9;
+    y = (int)yoe + era * 400 + (m <= 2);
+}
+
+bool Date::parse(std::string_view iso, Date& out) {
+    if (iso.size() != 10 || iso[4] != '-' || iso[7] != '-') return false;
+    int v[3] = { 0, 0, 0 };
+    const int from[3] = { 0, 5, 8 }, len[3] = { 4, 2, 2 };
+    for (int f = 0; f < 3; ++f) {
+        for (int i = from[f]; i < from[f] + len[f]; ++i) {
+            if (iso[i] < '0' || iso[i] > '9') return false;
+            v[f] = v[f] * 10 + (iso[i] - '0');
+        }
+    }
+    const int y = v[0], m = v[1], d = v[2];
+    static const int mdays[12] = { 31, 28, 31, 30, 31, 30, 31, 31, 30, 31, 30, 31 };
+    const bool leap = (y % 4 == 0 && y % 100 != 0) || y % 400 == 0;
+    if (m < 1 || m > 12 || d < 1 || d > mdays[m - 1] + (m == 2 && leap)) return false;
+    out = fromCivil(y, (unsigned)m, (unsigned)d);
+    return true;
+}
+
+Date Date::fromIso(std::string_view iso) {
+    Date d;
+    if (!parse(iso, d)) return Date();
+    return d;
+}
+
+Date Date::today() {
+    std::time_t t = std::chrono::system_clock::to_time_t(std::chrono::system_clock::now());
+    std::tm buf{};
+#if defined(_WIN32) || defined(_WIN64)
+    localtime_s(&buf, &t);
+#else
+    localtime_r(&t, &buf);
+#endif
+    return fromCivil(buf.tm_year + 1900, (unsigned)buf.tm_mon + 1, (unsigned)buf.tm_mday);
+}
+
+std::string Date::iso() const {
+    if (empty()) return "";
+    int y;
+    unsigned m, d;
+    toCivil(y, m, d);
+    if (y < 0 || y > 9999) return "";   // вне формата YYYY
+
+    char out[10] = { char('0' + y / 1000), char('0' + y / 100 % 10), char('0' + y / 10 % 10), char('0' + y % 10), '-',
+                     char('0' + m / 10), char('0' + m % 10), '-',
+                     char('0' + d / 10), char('0' + d % 10) };
+    return std::string(out, 10);
+}
@@ -0,0 +1,81 @@
+#include "DbFormat.h"
+#include "Profiler.h"
+
+#include <algorithm>
+#include <cctype>
+
+static std::string lower_copy(std::string s) {
+    std::transform(s.begin(), s.end(), s.begin(),
+                   [](unsigned char c){ return (char)std::tolower(c); });
+    return s;
+}
+
+static bool endsWith(const std::string& s, const std::string& suffix) {
+    return s.size() >= suffix.size() && s.compare(s.size() - suffix.size(), suffix.size(), suffix) == 0;
+}
+
+FileFormat formatFromPath(const std::string& path) {
+    const std::string p = lower_copy(path);
+    if (endsWith(p, ".cbor")) return FileFormat::Cbor;
+    if (endsWith(p, ".msgpack") || endsWith(p, ".mpk")) return FileFormat::MsgPack;
+    return FileFormat::Json;
+}
+
+FileFormat detectFormat(const std::string& bytes) {
+    for (unsigned char b : bytes) {
+        if (b == ' ' || b == '\t' || b == '\r' || b == '\n') continue;   // JSON whitespace
+        // корень БД всегда объект: в CBOR это major type 5 (0xA0..0xBF),
+        // в MessagePack fixmap (0x80..0x8F) или map16/map32 (0xDE/0xDF)
+        if (b >= 0xA0 && b <= 0xBF) return FileFormat::Cbor;
+        if ((b >= 0x80 && b <= 0x8F) || b == 0xDE || b == 0xDF) return FileFormat::MsgPack;
+        return FileFormat::Json;
+    }
+    return FileFormat::Json;
+}
+
+const char* formatName(FileFormat f) {
+    switch (f) {
+        case FileFormat::Cbor:    return "cbor";
+        case FileFormat::MsgPack: return "msgpack";
+        case FileFormat::Json:    return "json";
+        case FileFormat::Auto:    return "auto";
+    }
+    return "json";
+}
+
+bool parseFormatName(const std::string& name, FileFormat& out) {
+    const std::string n = lower_copy(name);
+    if (n == "json")                  { out = FileFormat::Json;    return true; }
+    if (n == "cbor")                  { out = FileFormat::Cbor;    return true; }
+    if (n == "msgpack" || n == "mpk") { out = FileFormat::MsgPack; return true; }
+    if (n == "auto")                  { out = FileFormat::Auto;    return true; }
+    return false;
+}
+
+std::string encodeDocument(const json& doc, FileFormat format) {
+    if (format == FileFormat::Cbor) {
+        std::string out;
+        json::to_cbor(doc, out);
+        return out;
+    }
+    if (format == FileFormat::MsgPack) {
+        std::string out;
+        json::to_msgpack(doc, out);
+        return out;
+    }
+    return doc.dump(4) + "\n";   // как раньше: std::setw(4) + endl
+}
+
+bool decodeDocument(const std::string& bytes, json& out, FileFormat* detected) {
+    const FileFormat f = detectFormat(bytes);
+    if (detected) *detected = f;
+    PROF_JSON_PARSE();
+    try {
+        if (f == FileFormat::Cbor)         out = json::from_cbor(bytes);
+        else if (f == FileFormat::MsgPack) out = json::from_msgpack(bytes);
+        else                               out = json::parse(bytes);
+        return true;
+    } catch (...) {
+        return false;
+    }
+}
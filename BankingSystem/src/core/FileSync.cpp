@@ -0,0 +1,73 @@
+#include "FileSync.h"
+
+#include <filesystem>
+
+#if !defined(_WIN32) && !defined(_WIN64)
+#  include <cerrno>
+#  include <fcntl.h>
+#  include <unistd.h>
+#else
+#  include <fstream>
+#endif
+
+namespace fs = std::filesystem;
+
+std::string parentDirOf(const std::string& path) {
+    return fs::path(path).parent_path().string();
+}
+
+#if !defined(_WIN32) && !defined(_WIN64)
+
+static bool syncFd(int fd) {
+#if defined(F_FULLFSYNC)
+    // fsync на macOS оставляет данные в кэше диска
+    if (::fcntl(fd, F_FULLFSYNC) == 0) return true;   // не везде поддерживается -> обычный fsync
+#endif
+    return ::fsync(fd) == 0;
+}
+
+bool writeFileSynced(const std::string& path, const std::string& bytes, bool append) {
+    const bool created = append && ::access(path.c_str(), F_OK) != 0;
+    const int flags = O_WRONLY | O_CREAT | (append ? O_APPEND : O_TRUNC);
+    int fd = ::open(path.c_str(), flags, 0644);
+    if (fd < 0) return false;
+
+    const char* p = bytes.data();
+    std::size_t left = bytes.size();
+    while (left > 0) {
+        ssize_t n = ::write(fd, p, left);
+        if (n < 0) {
+            if (errno == EINTR) continue;
+            ::close(fd);
+            return false;
+        }
+        p += n;
+        left -= (std::size_t)n;
+    }
+    const bool ok = syncFd(fd);
+    if (::close(fd) != 0 || !ok) return false;
+    return !created || syncDir(parentDirOf(path));
+}
+
+bool syncDir(const std::string& dir) {
+    int fd = ::open(dir.empty() ? "." : dir.c_str(), O_RDONLY);
+    if (fd < 0) return false;
+    bool ok = syncFd(fd);
+    if (!ok && (errno == EINVAL || errno == ENOTSUP)) ok = true;   // ФС не синхронизирует каталоги
+    ::close(fd);
+    return ok;
+}
+
+#else
+
+bool writeFileSynced(const std::string& path, const std::string& bytes, bool append) {
+    std::ofstream out(path, std::ios::binary | (append ? std::ios::app : std::ios::trunc));
+    if (!out) return false;
+    out.write(bytes.data(), (std::streamsize)bytes.size());
+    out.flush();
+    return out.good();
+}
+
+bool syncDir(const std::string&) { return true; }
+
+#endif
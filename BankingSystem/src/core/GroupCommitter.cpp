@@ -0,0 +1,89 @@
+#include "GroupCommitter.h"
+
+#include <algorithm>
+
+GroupCommitter::GroupCommitter(Persist persist, CommitWindow window)
+    : persist(std::move(persist)), window(window), worker([this]{ run(); }) {}
+
+GroupCommitter::~GroupCommitter() {
+    {
+        std::lock_guard<std::mutex> lk(m);
+        stopping = true;
+    }
+    cv.notify_all();
+    worker.join();
+}
+
+void GroupCommitter::notify() {
+    {
+        std::lock_guard<std::mutex> lk(m);
+        const bool opens = queued == taken;   // первая мутация окна: поток начинает отсчёт
+        if (opens) firstQueued = Clock::now();
+        ++queued;
+        if (!opens && queued - taken < window.ops) return;
+    }
+    cv.notify_all();
+}
+
+std::shared_future<bool> GroupCommitter::durable() {
+    std::lock_guard<std::mutex> lk(m);
+    if (done >= queued) {
+        std::promise<bool> p;
+        p.set_value(true);
+        return p.get_future().share();
+    }
+
+    // один waiter на поколение: повторные вызовы без новых мутаций делят future
+    if (!waiters.empty() && waiters.back().gen == queued) return waiters.back().future;
+
+    Waiter w;
+    w.gen = queued;
+    w.future = w.done.get_future().share();
+    waiters.push_back(std::move(w));
+    return waiters.back().future;
+}
+
+bool GroupCommitter::flush() {
+    std::shared_future<bool> f = durable();
+    {
+        std::lock_guard<std::mutex> lk(m);
+        if (queued > taken) flushRequested = true;   // иначе окно уже пишется
+    }
+    cv.notify_all();
+    return f.get();
+}
+
+std::uint64_t GroupCommitter::commits() const {
+    std::lock_guard<std::mutex> lk(m);
+    return commitCount;
+}
+
+void GroupCommitter::run() {
+    std::unique_lock<std::mutex> lk(m);
+    for (;;) {
+        cv.wait(lk, [&]{ return stopping || queued > taken; });
+        if (queued == taken) {
+            if (stopping) break;
+            continue;
+        }
+
+        // окно: ждём срок, лимит операций, flush() или остановку
+        cv.wait_until(lk, firstQueued + std::chrono::milliseconds(window.ms), [&]{
+            return stopping || flushRequested || queued - taken >= window.ops;
+        });
+        flushRequested = false;
+        const std::uint64_t gen = queued;
+        taken = gen;
+
+        lk.unlock();
+        const bool ok = persist();
+        lk.lock();
+
+        done = gen;
+        ++commitCount;
+        auto ready = std::partition(waiters.begin(), waiters.end(),
+                                    [&](const Waiter& w){ return w.gen > gen; });
+        for (auto it = ready; it != waiters.end(); ++it) it->done.set_value(ok);
+        waiters.erase(ready, waiters.end());
+    }
+}
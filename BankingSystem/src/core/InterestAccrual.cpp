@@ -0,0 +1,42 @@
+#include "InterestAccrual.h"
+
+#include <algorithm>
+
+#include "ThreadPool.h"
+
+static constexpr double DEFAULT_SAVINGS_RATE = 0.15;   // как в AppSession::applySavingsInterest
+static constexpr std::size_t ROWS_PER_JOB = 16 * 1024;
+
+static void accrueRange(SavingsRow* rows, std::size_t n, Date today) {
+    for (std::size_t i = 0; i < n; ++i) {
+        SavingsRow& r = rows[i];
+        r.interestMinor = 0;
+        r.touched = false;
+        if (r.dated == SavingsRow::Dated::Missing) { r.touched = true; continue; }
+        if (r.dated == SavingsRow::Dated::Unreadable) continue;
+
+        const int days = today - r.last;
+        if (days <= 0) continue;
+        const double rate = r.rate > 0 ? r.rate : DEFAULT_SAVINGS_RATE;
+        const Money interest = Money(r.balanceMinor, EUR).scaled(rate * (double(days) / 365.0),
+                                                                 RoundingMode::HalfEven);
+        if (interest.isPositive()) r.interestMinor = interest.minorUnits();
+        // меньше полцента на положительном балансе: дату не двигаем, дни копятся
+        r.touched = r.interestMinor > 0 || r.balanceMinor <= 0;
+    }
+}
+
+void computeAccrual(std::vector<SavingsRow>& rows, Date today, std::size_t threads) {
+    if (rows.size() <= ROWS_PER_JOB) {
+        accrueRange(rows.data(), rows.size(), today);
+        return;
+    }
+
+    // куски по ROWS_PER_JOB строк: каждый поток пишет только в свои строки
+    ThreadPool pool(threads);
+    for (std::size_t from = 0; from < rows.size(); from += ROWS_PER_JOB) {
+        const std::size_t n = std::min(ROWS_PER_JOB, rows.size() - from);
+        pool.submit([&rows, from, n, today]{ accrueRange(rows.data() + from, n, today); });
+    }
+    pool.wait();
+}
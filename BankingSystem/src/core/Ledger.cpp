@@ -0,0 +1,189 @@
+#include "Ledger.h"
+
+#include "Customer.h"
+
+#include <algorithm>
+
+static bool setError(std::string* error, const char* msg) {
+    if (error) *error = msg;
+    return false;
+}
+
+Ledger::Ledger(std::size_t n) {
+    std::size_t p = 1;
+    while (p < n) p <<= 1;
+    mask = p - 1;
+    stripes = std::make_unique<Stripe[]>(p);
+}
+
+std::size_t Ledger::stripeOf(int accId) const {
+    // id идут почти подряд -> перемешиваем, чтобы соседние счета попадали в разные полосы
+    return ((std::uint32_t)accId * 2654435761u >> 8) & mask;
+}
+
+bool Ledger::check(const Money& balance, const Leg& leg, std::string* error) {
+    if (leg.amount.currency() != balance.currency()) return setError(error, "Currency mismatch.");
+    if (!leg.amount.isPositive()) return setError(error, "Invalid amount.");
+    if (leg.debit && balance < leg.amount) return setError(error, "Insufficient funds.");
+    return true;
+}
+
+bool Ledger::open(int accId, const Money& initial) {
+    Stripe& s = stripes[stripeOf(accId)];
+    std::lock_guard<std::mutex> lk(s.m);
+    return s.accounts.emplace(accId, Balance{ initial, 1 }).second;
+}
+
+bool Ledger::close(int accId) {
+    Stripe& s = stripes[stripeOf(accId)];
+    std::lock_guard<std::mutex> lk(s.m);
+    return s.accounts.erase(accId) > 0;
+}
+
+bool Ledger::contains(int accId) const {
+    const Stripe& s = stripes[stripeOf(accId)];
+    std::lock_guard<std::mutex> lk(s.m);
+    return s.accounts.count(accId) > 0;
+}
+
+std::size_t Ledger::size() const {
+    std::size_t n = 0;
+    for (std::size_t i = 0; i <= mask; ++i) {
+        std::lock_guard<std::mutex> lk(stripes[i].m);
+        n += stripes[i].accounts.size();
+    }
+    return n;
+}
+
+bool Ledger::read(int accId, Balance& out) const {
+    const Stripe& s = stripes[stripeOf(accId)];
+    std::lock_guard<std::mutex> lk(s.m);
+    auto it = s.accounts.find(accId);
+    if (it == s.accounts.end()) return false;
+    out = it->second;
+    return true;
+}
+
+bool Ledger::credit(int accId, const Money& amount, std::string* error) {
+    return post({ Leg{ accId, amount, false } }, error);
+}
+
+bool Ledger::debit(int accId, const Money& amount, std::string* error) {
+    return post({ Leg{ accId, amount, true } }, error);
+}
+
+bool Ledger::transfer(int fromAccId, int toAccId, const Money& amount, std::string* error) {
+    if (fromAccId == toAccId) return setError(error, "Source and destination are the same account.");
+    return post({ Leg{ fromAccId, amount, true }, Leg{ toAccId, amount, false } }, error);
+}
+
+bool Ledger::post(const std::vector<Leg>& legs, std::string* error,
+                  const std::function<void()>& whileLocked, std::vector<Money>* after) {
+    // всегда по возрастанию индекса -> встречные переводы не ждут друг друга по кругу
+    std::vector<std::size_t> order;
+    order.reserve(legs.size());
+    for (const auto& leg : legs) order.push_back(stripeOf(leg.accId));
+    std::sort(order.begin(), order.end());
+    order.erase(std::unique(order.begin(), order.end()), order.end());
+
+    std::vector<std::unique_lock<std::mutex>> held;
+    held.reserve(order.size());
+    for (std::size_t i : order) held.emplace_back(stripes[i].m);
+
+    // сначала проверяем всё на копиях (нога может повторять счёт), потом пишем
+    std::vector<std::pair<Balance*, Money>> work;
+    std::vector<std::size_t> slot(legs.size());
+    for (std::size_t i = 0; i < legs.size(); ++i) {
+        Stripe& s = stripes[stripeOf(legs[i].accId)];
+        auto it = s.accounts.find(legs[i].accId);
+        if (it == s.accounts.end()) return setError(error, "Account not found.");
+        std::size_t k = 0;
+        while (k < work.size() && work[k].first != &it->second) ++k;
+        if (k == work.size()) work.emplace_back(&it->second, it->second.amount);
+        slot[i] = k;
+
+        Money& bal = work[k].second;
+        if (!check(bal, legs[i], error)) return false;
+        bal = legs[i].debit ? bal - legs[i].amount : bal + legs[i].amount;
+    }
+    for (auto& [b, amount] : work) {
+        b->amount = amount;
+        ++b->version;
+    }
+    if (after) {
+        after->clear();
+        for (std::size_t k : slot) after->push_back(work[k].second);
+    }
+    if (whileLocked) whileLocked();
+    return true;
+}
+
+bool Ledger::compareAndSet(int accId, std::uint64_t expectedVersion, const Money& newAmount) {
+    Stripe& s = stripes[stripeOf(accId)];
+    std::lock_guard<std::mutex> lk(s.m);
+    auto it = s.accounts.find(accId);
+    if (it == s.accounts.end() || it->second.version != expectedVersion) return false;
+    if (newAmount.currency() != it->second.amount.currency()) return false;
+    it->second.amount = newAmount;
+    ++it->second.version;
+    return true;
+}
+
+void Ledger::assign(int accId, const Money& amount) {
+    Stripe& s = stripes[stripeOf(accId)];
+    std::lock_guard<std::mutex> lk(s.m);
+    auto [it, added] = s.accounts.emplace(accId, Balance{ amount, 1 });
+    if (!added) {
+        it->second.amount = amount;
+        ++it->second.version;
+    }
+}
+
+bool Ledger::adjust(int accId, const Money& delta) {
+    Stripe& s = stripes[stripeOf(accId)];
+    std::lock_guard<std::mutex> lk(s.m);
+    auto it = s.accounts.find(accId);
+    if (it == s.accounts.end() || it->second.amount.currency() != delta.currency()) return false;
+    it->second.amount += delta;
+    ++it->second.version;
+    return true;
+}
+
+void Ledger::reset(const std::vector<std::pair<int, Money>>& balances,
+                   const std::function<std::vector<Leg>()>& pending) {
+    std::vector<std::unique_lock<std::mutex>> held;
+    held.reserve(mask + 1);
+    for (std::size_t i = 0; i <= mask; ++i) held.emplace_back(stripes[i].m);
+
+    // версии сохраняем: CAS, начатый до reset, должен провалиться, а не пройти
+    std::vector<std::unordered_map<int, Balance>> next(mask + 1);
+    for (const auto& [accId, amount] : balances) {
+        const std::size_t i = stripeOf(accId);
+        auto old = stripes[i].accounts.find(accId);
+        const std::uint64_t v = old == stripes[i].accounts.end() ? 1 : old->second.version + 1;
+        next[i][accId] = Balance{ amount, v };
+    }
+    if (pending) {
+        for (const Leg& leg : pending()) {
+            auto& acc = next[stripeOf(leg.accId)];
+            auto it = acc.find(leg.accId);
+            if (it == acc.end() || it->second.amount.currency() != leg.amount.currency()) continue;
+            it->second.amount = leg.debit ? it->second.amount - leg.amount : it->second.amount + leg.amount;
+        }
+    }
+    for (std::size_t i = 0; i <= mask; ++i) stripes[i].accounts.swap(next[i]);
+}
+
+void Ledger::refresh(Customer& customer) const {
+    for (auto& acc : customer.getAccounts()) {
+        Balance b;
+        if (read(acc.getId(), b)) acc.setBalance(b.amount);
+    }
+}
+
+void Ledger::forEach(const std::function<void(int, const Balance&)>& fn) const {
+    for (std::size_t i = 0; i <= mask; ++i) {
+        std::lock_guard<std::mutex> lk(stripes[i].m);
+        for (const auto& kv : stripes[i].accounts) fn(kv.first, kv.second);
+    }
+}
@@ -0,0 +1,163 @@
+#include "Money.h"
+
+#include <cctype>
+#include <cmath>
+#include <limits>
+#include <stdexcept>
+
+// ---------------------- CurrencyCode ----------------------
+CurrencyCode CurrencyCode::fromString(std::string_view s) {
+    CurrencyCode c;
+    if (s.size() != 3) { c.code[0] = '\0'; return c; }
+    for (int i = 0; i < 3; ++i) {
+        unsigned char ch = (unsigned char)s[i];
+        if (!std::isalpha(ch)) { c.code[0] = '\0'; return c; }
+        c.code[i] = (char)std::toupper(ch);
+    }
+    c.code[3] = '\0';
+    return c;
+}
+
+std::string CurrencyCode::str() const { return std::string(view()); }
+
+std::string_view CurrencyCode::view() const {
+    return empty() ? std::string_view() : std::string_view(code, 3);
+}
+
+// ---------------------- helpers ----------------------
+static std::int64_t pow10i(int n) {
+    std::int64_t p = 1;
+    while (n-- > 0) p *= 10;
+    return p;
+}
+
+static std::int64_t roundToMinor(long double x, RoundingMode mode) {
+    if (!std::isfinite((double)x) ||
+        x >  (long double)std::numeric_limits<std::int64_t>::max() ||
+        x < -(long double)std::numeric_limits<std::int64_t>::max())
+        throw std::overflow_error("Money: amount out of range");
+
+    long double fl = std::floor(x);
+    long double frac = x - fl;
+
+    switch (mode) {
+        case RoundingMode::Floor:   return (std::int64_t)fl;
+        case RoundingMode::Ceiling: return (std::int64_t)std::ceil(x);
+        case RoundingMode::Down:    return (std::int64_t)std::trunc(x);
+        case RoundingMode::HalfUp:
+            return (std::int64_t)(x < 0 ? -std::floor(-x + 0.5L) : std::floor(x + 0.5L));
+        case RoundingMode::HalfEven:
+            if (frac > 0.5L) return (std::int64_t)fl + 1;
+            if (frac < 0.5L) return (std::int64_t)fl;
+            return ((std::int64_t)fl % 2 == 0) ? (std::int64_t)fl : (std::int64_t)fl + 1;
+    }
+    return (std::int64_t)fl;
+}
+
+static std::int64_t checkedAdd(std::int64_t a, std::int64_t b) {
+    constexpr std::int64_t MAX = std::numeric_limits<std::int64_t>::max();
+    constexpr std::int64_t MIN = std::numeric_limits<std::int64_t>::min();
+    if ((b > 0 && a > MAX - b) || (b < 0 && a < MIN - b))
+        throw std::overflow_error("Money: overflow");
+    return a + b;
+}
+
+static void requireSameCurrency(const Money& a, const Money& b) {
+    if (a.currency() != b.currency())
+        throw std::invalid_argument("Money: currency mismatch (" + a.currency().str() +
+                                    " vs " + b.currency().str() + ")");
+}
+
+// ---------------------- Money ----------------------
+int Money::minorDigits(CurrencyCode currency) {
+    if (currency == CurrencyCode('J', 'P', 'Y')) return 0;
+    return 2;
+}
+
+Money Money::fromMajor(double amount, CurrencyCode currency) {
+    long double scaled = (long double)amount * (long double)pow10i(minorDigits(currency));
+    return Money(roundToMinor(scaled, RoundingMode::HalfUp), currency);
+}
+
+bool Money::parse(std::string_view text, CurrencyCode currency, Money& out) {
+    const int digits = minorDigits(currency);
+    std::size_t i = 0;
+    bool neg = false;
+    if (i < text.size() && (text[i] == '-' || text[i] == '+')) neg = text[i++] == '-';
+
+    std::int64_t value = 0;
+    int intDigits = 0, fracDigits = 0;
+    bool dot = false;
+    for (; i < text.size(); ++i) {
+        char ch = text[i];
+        if (ch == '.' && !dot) { dot = true; continue; }
+        if (ch < '0' || ch > '9') return false;
+        if (dot) { if (++fracDigits > digits) return false; }
+        else ++intDigits;
+        if (value > (std::numeric_limits<std::int64_t>::max() - 9) / 10) return false;
+        value = value * 10 + (ch - '0');
+    }
+    if (intDigits + fracDigits == 0) return false;
+
+    const std::int64_t scale = pow10i(digits - fracDigits);
+    if (value > std::numeric_limits<std::int64_t>::max() / scale) return false;
+    out = Money(neg ? -value * scale : value * scale, currency);
+    return true;
+}
+
+double Money::toMajor() const {
+    return (double)minor / (double)pow10i(minorDigits(cur));
+}
+
+std::string Money::toString() const {
+    const int digits = minorDigits(cur);
+    const std::int64_t scale = pow10i(digits);
+
+    // |INT64_MIN| не влезает в int64 -> считаем в unsigned
+    unsigned long long mag = minor < 0 ? 0ULL - (unsigned long long)minor
+                                       : (unsigned long long)minor;
+    std::string s = minor < 0 ? "-" : "";
+    s += std::to_string(mag / (unsigned long long)scale);
+    if (digits > 0) {
+        std::string frac = std::to_string(mag % (unsigned long long)scale);
+        s += '.';
+        s.append((size_t)digits - frac.size(), '0');
+        s += frac;
+    }
+    return s;
+}
+
+Money Money::operator+(const Money& o) const {
+    requireSameCurrency(*this, o);
+    return Money(checkedAdd(minor, o.minor), cur);
+}
+
+Money Money::operator-(const Money& o) const {
+    requireSameCurrency(*this, o);
+    return *this + (-o);
+}
+
+Money Money::operator-() const {
+    if (minor == std::numeric_limits<std::int64_t>::min()) throw std::overflow_error("Money: overflow");
+    return Money(-minor, cur);
+}
+
+Money& Money::operator+=(const Money& o) { *this = *this + o; return *this; }
+Money& Money::operator-=(const Money& o) { *this = *this - o; return *this; }
+
+bool Money::operator<(const Money& o) const  { requireSameCurrency(*this, o); return minor <  o.minor; }
+bool Money::operator<=(const Money& o) const { requireSameCurrency(*this, o); return minor <= o.minor; }
+bool Money::operator>(const Money& o) const  { requireSameCurrency(*this, o); return minor >  o.minor; }
+bool Money::operator>=(const Money& o) const { requireSameCurrency(*this, o); return minor >= o.minor; }
+
+Money Money::scaled(double factor, RoundingMode mode) const {
+    return Money(roundToMinor((long double)minor * (long double)factor, mode), cur);
+}
+
+Money Money::convert(double rate, CurrencyCode to, RoundingMode mode) const {
+    const int shift = minorDigits(to) - minorDigits(cur);
+    long double x = (long double)minor * (long double)rate;
+    if (shift > 0) x *= (long double)pow10i(shift);
+    if (shift < 0) x /= (long double)pow10i(-shift);
+    return Money(roundToMinor(x, mode), to);
+}
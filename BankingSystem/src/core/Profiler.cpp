@@ -0,0 +1,93 @@
+#include "Profiler.h"
+
+#if BANKING_PROFILER
+
+#include <atomic>
+#include <chrono>
+
+namespace prof {
+namespace {
+
+constexpr std::uint64_t RING_SIZE = 2048;   // samples per thread; the overlay drains every frame
+constexpr std::uint64_t RING_MASK = RING_SIZE - 1;
+
+// One single-producer / single-consumer ring per recording thread: the owner
+// thread publishes with head, drain() frees with tail. No two writers ever share
+// a slot, so a full ring drops the new sample and counts it instead of tearing.
+// Rings are never freed: when a thread exits, the next new thread reuses its ring.
+struct Ring {
+    std::atomic<bool> inUse{true};
+    std::atomic<std::uint64_t> head{0};
+    std::atomic<std::uint64_t> tail{0};
+    Sample slots[RING_SIZE];
+    Ring* next = nullptr;   // immutable once the ring is in the list
+};
+
+std::atomic<Ring*> rings{nullptr};
+
+std::atomic<std::uint64_t> bytesRead{0};
+std::atomic<std::uint64_t> bytesWritten{0};
+std::atomic<std::uint64_t> jsonParses{0};
+std::atomic<std::uint64_t> dropped{0};
+
+Ring* claimRing() {
+    for (Ring* r = rings.load(std::memory_order_acquire); r; r = r->next) {
+        bool expected = false;
+        if (r->inUse.compare_exchange_strong(expected, true, std::memory_order_acquire)) return r;
+    }
+    Ring* r = new Ring();
+    r->next = rings.load(std::memory_order_relaxed);
+    while (!rings.compare_exchange_weak(r->next, r, std::memory_order_release, std::memory_order_relaxed)) {}
+    return r;
+}
+
+struct ThreadRing {
+    Ring* ring = claimRing();
+    ~ThreadRing() { ring->inUse.store(false, std::memory_order_release); }
+};
+
+} // namespace
+
+std::uint64_t nowNs() {
+    using namespace std::chrono;
+    return (std::uint64_t)duration_cast<nanoseconds>(steady_clock::now().time_since_epoch()).count();
+}
+
+void record(const char* name, std::uint64_t startNs, std::uint64_t durNs) {
+    thread_local ThreadRing mine;
+    Ring& r = *mine.ring;
+    const std::uint64_t h = r.head.load(std::memory_order_relaxed);
+    if (h - r.tail.load(std::memory_order_acquire) == RING_SIZE) {
+        dropped.fetch_add(1, std::memory_order_relaxed);   // никто не читает (оверлей не рисуется)
+        return;
+    }
+    r.slots[h & RING_MASK] = Sample{ name, startNs, durNs };
+    r.head.store(h + 1, std::memory_order_release);
+}
+
+void addBytesRead(std::uint64_t n)    { bytesRead.fetch_add(n, std::memory_order_relaxed); }
+void addBytesWritten(std::uint64_t n) { bytesWritten.fetch_add(n, std::memory_order_relaxed); }
+void addJsonParse()                   { jsonParses.fetch_add(1, std::memory_order_relaxed); }
+
+std::size_t drain(Sample* out, std::size_t max) {
+    std::size_t n = 0;
+    for (Ring* r = rings.load(std::memory_order_acquire); r && n < max; r = r->next) {
+        const std::uint64_t t = r->tail.load(std::memory_order_relaxed);
+        const std::uint64_t h = r->head.load(std::memory_order_acquire);
+        std::uint64_t i = t;
+        for (; i < h && n < max; ++i) out[n++] = r->slots[i & RING_MASK];
+        r->tail.store(i, std::memory_order_release);
+    }
+    return n;
+}
+
+Counters counters() {
+    return Counters{ bytesRead.load(std::memory_order_relaxed),
+                     bytesWritten.load(std::memory_order_relaxed),
+                     jsonParses.load(std::memory_order_relaxed),
+                     dropped.load(std::memory_order_relaxed) };
+}
+
+} // namespace prof
+
+#endif
@@ -0,0 +1,173 @@
+#include "RateProvider.h"
+#include "Profiler.h"
+
+#include <atomic>
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <fstream>
+#include <sstream>
+
+#include "nlohmann/json.hpp"
+
+using json = nlohmann::json;
+
+static long long nowEpochMs() {
+    using namespace std::chrono;
+    return duration_cast<milliseconds>(system_clock::now().time_since_epoch()).count();
+}
+
+static bool parseRatesPayload(const std::string& data,
+                              std::unordered_map<std::string, double>& outRates,
+                              std::string& outError) {
+    PROF_JSON_PARSE();
+    PROF_BYTES_READ(data.size());
+    try {
+        auto j = json::parse(data);
+        if (!j.contains("rates") || !j["rates"].is_object()) {
+            outError = "Rates payload invalid.";
+            return false;
+        }
+        outRates.clear();
+        for (auto it = j["rates"].begin(); it != j["rates"].end(); ++it) {
+            outRates[it.key()] = it.value().get<double>();
+        }
+        return true;
+    } catch (...) {
+        outError = "Failed to parse rates JSON.";
+        return false;
+    }
+}
+
+// ---------------------- sources ----------------------
+CurlRateSource::CurlRateSource(const std::vector<std::string>& symbols)
+    : symbols(symbols) {}
+
+bool CurlRateSource::fetch(std::unordered_map<std::string, double>& outRates,
+                           std::string& outError, int timeoutSec) {
+    std::string csv;
+    for (size_t i = 0; i < symbols.size(); ++i) {
+        if (i) csv += ",";
+        csv += symbols[i];
+    }
+    std::string url = "https://api.frankfurter.app/latest?from=EUR&to=" + csv;
+
+    std::string cmd = "curl -s --max-time " + std::to_string(std::max(1, timeoutSec)) +
+                      " \"" + url + "\"";
+    FILE* pipe = popen(cmd.c_str(), "r");
+    if (!pipe) { outError = "Failed to run curl."; return false; }
+
+    std::string data;
+    char buffer[4096];
+    while (fgets(buffer, sizeof(buffer), pipe)) data += buffer;
+    int rc = pclose(pipe);
+    if (rc != 0) { outError = "Rates request failed or timed out."; return false; }
+
+    return parseRatesPayload(data, outRates, outError);
+}
+
+FileRateSource::FileRateSource(const std::string& path)
+    : path(path) {}
+
+bool FileRateSource::fetch(std::unordered_map<std::string, double>& outRates,
+                           std::string& outError, int /*timeoutSec*/) {
+    std::ifstream in(path);
+    if (!in) { outError = "Rates file not found: " + path; return false; }
+    std::stringstream ss; ss << in.rdbuf();
+    return parseRatesPayload(ss.str(), outRates, outError);
+}
+
+ReplayRateSource::ReplayRateSource(const std::string& path) {
+    std::ifstream in(path);
+    std::string line;
+    while (std::getline(in, line)) {
+        if (!line.empty()) frames.push_back(line);
+    }
+}
+
+bool ReplayRateSource::fetch(std::unordered_map<std::string, double>& outRates,
+                             std::string& outError, int /*timeoutSec*/) {
+    if (frames.empty()) { outError = "Replay has no frames."; return false; }
+    const std::string& frame = frames[next];
+    next = (next + 1) % frames.size();
+    return parseRatesPayload(frame, outRates, outError);
+}
+
+std::unique_ptr<RateSource> makeRateSource(const std::string& spec,
+                                           const std::vector<std::string>& symbols) {
+    if (spec.rfind("file:", 0) == 0)
+        return std::make_unique<FileRateSource>(spec.substr(5));
+    if (spec.rfind("replay:", 0) == 0)
+        return std::make_unique<ReplayRateSource>(spec.substr(7));
+    return std::make_unique<CurlRateSource>(symbols);
+}
+
+// ---------------------- RateService ----------------------
+RateService::RateService(std::unique_ptr<RateSource> source, const RateServiceOptions& options)
+    : source(std::move(source)), options(options),
+      current(std::make_shared<const RateSnapshot>()) {}
+
+RateService::~RateService() {
+    stop();
+}
+
+void RateService::start() {
+    std::lock_guard<std::mutex> lk(m);
+    if (worker.joinable()) return;
+    stopping = false;
+    worker = std::thread(&RateService::run, this);
+}
+
+void RateService::stop() {
+    {
+        std::lock_guard<std::mutex> lk(m);
+        stopping = true;
+    }
+    cv.notify_all();
+    if (worker.joinable()) worker.join();
+}
+
+std::shared_ptr<const RateSnapshot> RateService::snapshot() const {
+    return std::atomic_load(&current);
+}
+
+void RateService::publish(std::shared_ptr<const RateSnapshot> s) {
+    std::atomic_store(&current, std::move(s));
+}
+
+void RateService::run() {
+    int failures = 0;
+    for (;;) {
+        std::unordered_map<std::string, double> rates;
+        std::string err;
+        bool ok;
+        {
+            PROF_SCOPE("RateSource::fetch");   // FX-поток, не кадр: видно, сколько ждём сеть
+            ok = source->fetch(rates, err, options.timeoutSec);
+        }
+
+        auto prev = snapshot();
+        auto next = std::make_shared<RateSnapshot>();
+        next->version = prev->version + 1;
+        if (ok) {
+            next->rates = std::move(rates);
+            next->fetchedAtMs = nowEpochMs();
+            failures = 0;
+        } else {
+            // keep the last good rates, only report the error
+            next->rates = prev->rates;
+            next->fetchedAtMs = prev->fetchedAtMs;
+            next->error = err;
+            ++failures;
+        }
+        publish(std::move(next));
+        if (options.onPublish) options.onPublish();
+
+        long long delay = options.pollMs;
+        for (int i = 0; i < failures && delay < options.maxBackoffMs; ++i) delay *= 2;
+        delay = std::min<long long>(delay, std::max(options.pollMs, options.maxBackoffMs));
+
+        std::unique_lock<std::mutex> lk(m);
+        if (cv.wait_for(lk, std::chrono::milliseconds(delay), [&]{ return stopping; })) return;
+    }
+}
@@ -0,0 +1,410 @@
+#include "ShardedStore.h"
+#include "FileSync.h"
+#include "Profiler.h"
+#include "ThreadPool.h"
+
+#include <algorithm>
+#include <cstdio>
+#include <filesystem>
+#include <fstream>
+#include <set>
+#include <thread>
+
+namespace fs = std::filesystem;
+
+static bool readFile(const std::string& path, std::string& out) {
+    std::ifstream in(path, std::ios::binary);
+    if (!in) return false;
+    out.assign(std::istreambuf_iterator<char>(in), std::istreambuf_iterator<char>());
+    PROF_BYTES_READ(out.size());
+    return !in.bad();
+}
+
+// Pool for n independent files: no more threads than files or cores
+static std::size_t poolSize(std::size_t n) {
+    return std::min<std::size_t>(n, std::max(2u, std::thread::hardware_concurrency()));
+}
+
+static std::string shardName(std::size_t shard, std::uint64_t gen, FileFormat format) {
+    char buf[64];
+    std::snprintf(buf, sizeof(buf), "customers/%04zu-%llu.%s", shard, (unsigned long long)gen, formatName(format));
+    return buf;
+}
+
+static std::string segmentName(std::uint64_t n) {
+    char buf[48];
+    std::snprintf(buf, sizeof(buf), "transfers/%06llu.jsonl", (unsigned long long)n);
+    return buf;
+}
+
+ShardedStore::ShardedStore(const std::string& dir, std::size_t shards, std::uintmax_t segmentBytes,
+                           FileFormat format)
+    : dir(dir), segmentBytes(std::max<std::uintmax_t>(1, segmentBytes)),
+      format(format == FileFormat::Auto ? FileFormat::Json : format),
+      shardFiles(std::max<std::size_t>(1, shards)),
+      members(shardFiles.size()),
+      dirty(shardFiles.size(), 0) {}
+
+std::string ShardedStore::manifestPath() const { return path("manifest.json"); }
+std::string ShardedStore::path(const std::string& rel) const { return dir + "/" + rel; }
+
+bool ShardedStore::isStore(const std::string& dir) {
+    std::error_code ec;
+    return fs::exists(dir + "/manifest.json", ec);
+}
+
+std::size_t ShardedStore::shardOf(const std::string& customerId) const {
+    std::uint64_t h = 1469598103934665603ull;
+    for (unsigned char c : customerId) {
+        h ^= c;
+        h *= 1099511628211ull;
+    }
+    return (std::size_t)(h % shardFiles.size());
+}
+
+void ShardedStore::touchCustomer(const std::string& id) {
+    const std::size_t s = shardOf(id);
+    dirty[s] = 1;
+    members[s].insert(id);
+}
+
+void ShardedStore::touchAll() { allDirty = true; }
+
+bool ShardedStore::hasChanges() const {
+    return allDirty || std::find(dirty.begin(), dirty.end(), 1) != dirty.end();
+}
+
+// ---------------------- load ----------------------
+bool ShardedStore::load(json& outRoot, std::string* error) {
+    PROF_SCOPE("ShardedStore::load");
+    auto fail = [&](const char* msg) { if (error) *error = msg; return false; };
+    std::error_code ec;
+
+    allDirty = false;
+    std::fill(dirty.begin(), dirty.end(), 0);
+
+    if (!fs::exists(manifestPath(), ec)) {
+        // новая база; файлы без манифеста молча затёрли бы чужие данные
+        for (const char* sub : { "customers", "transfers" }) {
+            if (fs::exists(path(sub), ec) && !fs::is_empty(path(sub), ec))
+                return fail("Shard files without a manifest.");
+        }
+        fs::create_directories(path("customers"), ec);
+        fs::create_directories(path("transfers"), ec);
+
+        std::fill(shardFiles.begin(), shardFiles.end(), std::string());
+        segments.clear();
+        if (!writeManifest(0, shardFiles, segments, 1, json::object()))
+            return fail("Cannot write manifest.");
+        seq = 0;
+        nextSegment = 1;
+        meta = json::object();
+        for (auto& m : members) m.clear();
+        transfersOnDisk = 0;
+
+        outRoot = json::object();
+        outRoot["customers"] = json::object();
+        outRoot["transfers"] = json::array();
+        return true;
+    }
+
+    // 1) manifest
+    json m;
+    std::string bytes;
+    if (!readFile(manifestPath(), bytes)) return fail("Manifest unreadable.");
+    PROF_JSON_PARSE();
+    try {
+        m = json::parse(bytes);
+    } catch (...) {
+        return fail("Manifest unreadable.");
+    }
+    if (!m.is_object() || !m.contains("shards") || !m["shards"].is_array() || m["shards"].empty() ||
+        !m.contains("transfers") || !m["transfers"].is_array())
+        return fail("Manifest unreadable.");
+
+    std::vector<std::string> files;
+    for (const auto& f : m["shards"]) files.push_back(f.is_string() ? f.get<std::string>() : "");
+    std::vector<Segment> segs;
+    for (const auto& s : m["transfers"]) {
+        if (!s.is_object()) return fail("Manifest unreadable.");
+        segs.push_back(Segment{ s.value("file", ""), s.value("bytes", (std::uintmax_t)0),
+                                s.value("entries", (std::size_t)0) });
+    }
+
+    // 2) shards: independent files -> parsed in parallel
+    const std::size_t n = files.size();
+    std::vector<json> docs(n);
+    std::vector<char> bad(n, 0);
+    auto readShard = [&](std::size_t i) {
+        std::string b;
+        if (!readFile(path(files[i]), b) || !decodeDocument(b, docs[i]) || !docs[i].is_object())
+            bad[i] = 1;
+        PROF_JSON_PARSE();
+    };
+    std::vector<std::size_t> used;
+    for (std::size_t i = 0; i < n; ++i)
+        if (!files[i].empty()) used.push_back(i);
+    if (used.size() > 1) {
+        ThreadPool pool(poolSize(used.size()));
+        for (std::size_t i : used) pool.submit([&, i]{ readShard(i); });
+        pool.wait();
+    } else {
+        for (std::size_t i : used) readShard(i);
+    }
+    if (std::find(bad.begin(), bad.end(), 1) != bad.end()) return fail("Shard file unreadable.");
+
+    json root = json::object();
+    json& custs = root["customers"] = json::object();
+    std::vector<std::unordered_set<std::string>> mem(n);
+    for (std::size_t i = 0; i < n; ++i) {
+        if (!docs[i].contains("customers") || !docs[i]["customers"].is_object()) continue;
+        for (auto& kv : docs[i]["customers"].items()) {
+            mem[i].insert(kv.key());
+            custs[kv.key()] = std::move(kv.value());
+        }
+    }
+
+    // 3) transfer log: only the committed part of every segment
+    json& transfers = root["transfers"] = json::array();
+    for (const Segment& s : segs) {
+        if (s.bytes == 0) continue;
+        std::ifstream in(path(s.file), std::ios::binary);
+        std::string data(s.bytes, '\0');
+        if (!in || !in.read(&data[0], (std::streamsize)s.bytes)) return fail("Transfer segment unreadable.");
+        PROF_BYTES_READ(data.size());
+
+        for (std::size_t pos = 0; pos < data.size();) {
+            const std::size_t nl = data.find('\n', pos);
+            if (nl == std::string::npos) return fail("Transfer segment unreadable.");
+            PROF_JSON_PARSE();
+            try {
+                transfers.push_back(json::parse(data.begin() + (std::ptrdiff_t)pos, data.begin() + (std::ptrdiff_t)nl));
+            } catch (...) {
+                return fail("Transfer segment unreadable.");
+            }
+            pos = nl + 1;
+        }
+    }
+
+    json metaIn = m.value("meta", json::object());
+    if (!metaIn.is_object()) metaIn = json::object();
+    if (!metaIn.empty()) root["meta"] = metaIn;
+
+    // 4) committed state = what was just read
+    seq = m.value("commitSeq", (std::uint64_t)0);
+    shardFiles = std::move(files);
+    segments = std::move(segs);
+    nextSegment = m.value("nextSegment", (std::uint64_t)segments.size() + 1);
+    meta = std::move(metaIn);
+    members = std::move(mem);
+    dirty.assign(n, 0);
+    transfersOnDisk = transfers.size();
+
+    outRoot = std::move(root);
+    return true;
+}
+
+// ---------------------- commit ----------------------
+bool ShardedStore::commit(const json& root, std::string* error) {
+    PROF_SCOPE("ShardedStore::commit");
+    auto fail = [&](const char* msg) { if (error) *error = msg; return false; };
+
+    static const json emptyObject = json::object();
+    static const json emptyArray = json::array();
+    const json& custs = root.contains("customers") && root["customers"].is_object() ? root["customers"] : emptyObject;
+    const json& transfers = root.contains("transfers") && root["transfers"].is_array() ? root["transfers"] : emptyArray;
+    const json newMeta = root.contains("meta") && root["meta"].is_object() ? root["meta"] : json::object();
+
+    // лог короче, чем на диске -> его заменили целиком
+    const bool rewrite = allDirty || transfers.size() < transfersOnDisk;
+    if (allDirty) {
+        for (auto& m : members) m.clear();
+        for (auto it = custs.begin(); it != custs.end(); ++it) members[shardOf(it.key())].insert(it.key());
+    }
+
+    std::vector<std::size_t> which;
+    for (std::size_t i = 0; i < shardFiles.size(); ++i)
+        if (allDirty || dirty[i]) which.push_back(i);
+
+    if (which.empty() && !rewrite && transfers.size() == transfersOnDisk && newMeta == meta)
+        return true;   // нечего писать
+
+    const std::uint64_t gen = seq + 1;
+    std::vector<std::string> newShards = shardFiles;
+    std::vector<std::string> written;
+    std::vector<Segment> newSegments = segments;
+    std::uint64_t newNext = nextSegment;
+
+    auto undo = [&](const char* msg) {
+        std::error_code ec;
+        for (const auto& f : written) fs::remove(path(f), ec);   // new generation, nobody names it
+        return fail(msg);
+    };
+    if (!writeShards(custs, which, gen, newShards, written)) return undo("Cannot write shard file.");
+    if (!writeTransfers(transfers, rewrite, newSegments, newNext)) return undo("Cannot write transfer segment.");
+    if (!writeManifest(gen, newShards, newSegments, newNext, newMeta)) return undo("Cannot write manifest.");
+
+    // committed: what only the old manifest named is garbage now
+    std::error_code ec;
+    for (std::size_t i = 0; i < shardFiles.size(); ++i)
+        if (!shardFiles[i].empty() && shardFiles[i] != newShards[i]) fs::remove(path(shardFiles[i]), ec);
+    for (const Segment& s : segments) {
+        bool kept = std::any_of(newSegments.begin(), newSegments.end(),
+                                [&](const Segment& x){ return x.file == s.file; });
+        if (!kept) fs::remove(path(s.file), ec);
+    }
+
+    seq = gen;
+    shardFiles = std::move(newShards);
+    segments = std::move(newSegments);
+    nextSegment = newNext;
+    meta = newMeta;
+    transfersOnDisk = transfers.size();
+    allDirty = false;
+    std::fill(dirty.begin(), dirty.end(), 0);
+
+    if (!swept) {
+        sweep(shardFiles, segments);
+        swept = true;
+    }
+    return true;
+}
+
+bool ShardedStore::writeShards(const json& custs, const std::vector<std::size_t>& which, std::uint64_t gen,
+                               std::vector<std::string>& newShards, std::vector<std::string>& written) {
+    std::vector<std::string> names(which.size());
+    std::vector<char> ok(which.size(), 0);
+
+    // each job touches only its own shard (members[s], names[k], ok[k]); custs is read-only
+    auto writeOne = [&](std::size_t k) {
+        const std::size_t s = which[k];
+        json doc = json::object();
+        json& out = doc["customers"] = json::object();
+        auto& ids = members[s];
+        for (auto it = ids.begin(); it != ids.end();) {
+            auto c = custs.find(*it);
+            if (c == custs.end()) { it = ids.erase(it); continue; }   // удалён
+            out[*it] = *c;
+            ++it;
+        }
+        if (out.empty()) { ok[k] = 1; return; }   // пустой шард: без файла
+
+        names[k] = shardName(s, gen, format);
+        const std::string bytes = encodeDocument(doc, format);
+        ok[k] = writeFileSynced(path(names[k]), bytes, false);
+        PROF_BYTES_WRITTEN(bytes.size());
+    };
+
+    if (which.size() > 1) {
+        ThreadPool pool(poolSize(which.size()));
+        for (std::size_t k = 0; k < which.size(); ++k) pool.submit([&, k]{ writeOne(k); });
+        pool.wait();
+    } else if (which.size() == 1) {
+        writeOne(0);
+    }
+
+    bool all = true;
+    for (std::size_t k = 0; k < which.size(); ++k) {
+        if (!names[k].empty()) written.push_back(names[k]);
+        newShards[which[k]] = names[k];
+        all = all && ok[k];
+    }
+    // новые имена в customers/ должны пережить сбой раньше, чем их назовёт манифест
+    return all && (written.empty() || syncDir(path("customers")));
+}
+
+bool ShardedStore::writeTransfers(const json& transfers, bool rewrite,
+                                  std::vector<Segment>& segs, std::uint64_t& next) {
+    std::size_t from = transfersOnDisk;
+    if (rewrite) {
+        segs.clear();   // свежие имена: старые сегменты живы, пока манифест на них ссылается
+        from = 0;
+    }
+    if (from >= transfers.size()) return true;
+
+    auto openNew = [&]{ segs.push_back(Segment{ segmentName(next++), 0, 0 }); };
+    if (segs.empty() || segs.back().bytes >= segmentBytes) openNew();
+
+    std::string chunk;
+    auto flush = [&]() -> bool {
+        if (chunk.empty()) return true;
+        const Segment& s = segs.back();
+        const std::string p = path(s.file);
+        const std::uintmax_t base = s.bytes - chunk.size();
+
+        // хвост прерванного коммита (за пределами base) отрезаем перед дозаписью
+        std::error_code ec;
+        if (fs::exists(p, ec)) {
+            if (fs::file_size(p, ec) != base) fs::resize_file(p, base, ec);
+            if (ec) return false;
+        } else if (base > 0) {
+            return false;
+        }
+
+        if (!writeFileSynced(p, chunk, true)) return false;   // новый сегмент: и каталог
+        PROF_BYTES_WRITTEN(chunk.size());
+        chunk.clear();
+        return true;
+    };
+
+    for (std::size_t i = from; i < transfers.size(); ++i) {
+        std::string line = transfers[i].dump();
+        line += '\n';
+        chunk += line;
+        Segment& s = segs.back();
+        s.bytes += line.size();
+        s.entries += 1;
+        if (s.bytes >= segmentBytes && i + 1 < transfers.size()) {
+            if (!flush()) return false;
+            openNew();
+        }
+    }
+    return flush();
+}
+
+bool ShardedStore::writeManifest(std::uint64_t newSeq, const std::vector<std::string>& newShards,
+                                 const std::vector<Segment>& newSegments, std::uint64_t newNextSegment,
+                                 const json& newMeta) {
+    json m = json::object();
+    m["format"] = "banking-sharded";
+    m["version"] = 1;
+    m["commitSeq"] = newSeq;
+    m["shards"] = newShards;
+    json segs = json::array();
+    for (const Segment& s : newSegments)
+        segs.push_back({ { "file", s.file }, { "bytes", s.bytes }, { "entries", s.entries } });
+    m["transfers"] = std::move(segs);
+    m["nextSegment"] = newNextSegment;
+    m["meta"] = newMeta;
+
+    std::error_code ec;
+    fs::create_directories(dir, ec);
+    const std::string tmp = manifestPath() + ".tmp";
+    {
+        const std::string bytes = m.dump(2) + "\n";
+        if (!writeFileSynced(tmp, bytes, false)) return false;
+        PROF_BYTES_WRITTEN(bytes.size());
+    }
+    // точка коммита; долговечна после fsync каталога
+    fs::rename(tmp, manifestPath(), ec);
+    if (ec) {
+        fs::remove(tmp, ec);
+        return false;
+    }
+    return syncDir(dir);
+}
+
+// Leftovers of commits that crashed before their manifest swap
+void ShardedStore::sweep(const std::vector<std::string>& keepShards, const std::vector<Segment>& keepSegments) {
+    std::set<std::string> keep(keepShards.begin(), keepShards.end());
+    for (const Segment& s : keepSegments) keep.insert(s.file);
+
+    std::error_code ec;
+    for (const char* sub : { "customers", "transfers" }) {
+        for (fs::directory_iterator it(path(sub), ec), end; !ec && it != end; it.increment(ec)) {
+            const std::string rel = std::string(sub) + "/" + it->path().filename().string();
+            std::error_code rmEc;
+            if (!keep.count(rel)) fs::remove(it->path(), rmEc);
+        }
+    }
+}
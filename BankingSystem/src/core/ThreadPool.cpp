@@ -0,0 +1,48 @@
+#include "ThreadPool.h"
+
+#include <algorithm>
+
+ThreadPool::ThreadPool(std::size_t threads) {
+    if (threads == 0) threads = std::max(2u, std::thread::hardware_concurrency());
+    workers.reserve(threads);
+    for (std::size_t i = 0; i < threads; ++i) workers.emplace_back([this]{ run(); });
+}
+
+ThreadPool::~ThreadPool() {
+    {
+        std::lock_guard<std::mutex> lk(m);
+        stopping = true;
+    }
+    cv.notify_all();
+    for (auto& t : workers) t.join();
+}
+
+void ThreadPool::submit(std::function<void()> job) {
+    {
+        std::lock_guard<std::mutex> lk(m);
+        jobs.push_back(std::move(job));
+    }
+    cv.notify_one();
+}
+
+void ThreadPool::wait() {
+    std::unique_lock<std::mutex> lk(m);
+    idle.wait(lk, [&]{ return jobs.empty() && active == 0; });
+}
+
+void ThreadPool::run() {
+    std::unique_lock<std::mutex> lk(m);
+    for (;;) {
+        cv.wait(lk, [&]{ return stopping || !jobs.empty(); });
+        if (jobs.empty()) return;   // stopping и очередь пуста
+
+        std::function<void()> job = std::move(jobs.front());
+        jobs.pop_front();
+        ++active;
+        lk.unlock();
+        job();
+        lk.lock();
+        --active;
+        if (jobs.empty() && active == 0) idle.notify_all();
+    }
+}
@@ -0,0 +1,104 @@
+#include "WriteAheadLog.h"
+#include "FileSync.h"
+#include "Profiler.h"
+
+#include <fstream>
+#include <filesystem>
+
+namespace fs = std::filesystem;
+
+WriteAheadLog::WriteAheadLog(const std::string& path)
+    : path(path) {}
+
+const std::string& WriteAheadLog::getPath() const { return path; }
+std::size_t WriteAheadLog::records() const { return recordCount; }
+std::uintmax_t WriteAheadLog::bytes() const { return byteCount; }
+
+bool WriteAheadLog::append(const json& record) {
+    std::string line = record.dump();
+    line += '\n';
+
+    if (!writeFileSynced(path, line, true)) return false;
+    PROF_BYTES_WRITTEN(line.size());
+
+    ++recordCount;
+    byteCount += line.size();
+    return true;
+}
+
+bool WriteAheadLog::append(const std::vector<json>& batch) {
+    if (batch.empty()) return true;
+
+    std::string lines;
+    for (const auto& r : batch) {
+        lines += r.dump();
+        lines += '\n';
+    }
+
+    if (!writeFileSynced(path, lines, true)) return false;
+    PROF_BYTES_WRITTEN(lines.size());
+
+    recordCount += batch.size();
+    byteCount += lines.size();
+    return true;
+}
+
+bool WriteAheadLog::replay(const std::function<void(const json&)>& apply) {
+    recordCount = 0;
+    byteCount = 0;
+
+    std::error_code ec;
+    if (!fs::exists(path, ec)) return true;   // no journal yet
+
+    std::ifstream in(path, std::ios::binary);
+    if (!in) return false;
+
+    std::uintmax_t good = 0;
+    std::string line;
+    bool torn = false;
+    while (std::getline(in, line)) {
+        // последняя строка без '\n' -> запись оборвалась на середине
+        if (in.eof()) { torn = true; break; }
+        if (line.empty()) { good += 1; continue; }
+
+        json rec;
+        try {
+            PROF_JSON_PARSE();
+            rec = json::parse(line);
+        } catch (...) {
+            torn = true;
+            break;
+        }
+        if (!rec.is_object()) { torn = true; break; }
+
+        apply(rec);
+        ++recordCount;
+        good += line.size() + 1;
+    }
+    in.close();
+    byteCount = good;
+    PROF_BYTES_READ(good);
+
+    if (torn) {
+        // хвост сохраняем рядом (как .corrupt у основной БД) и отрезаем
+        std::ifstream src(path, std::ios::binary);
+        std::ofstream dst(path + ".corrupt", std::ios::binary | std::ios::trunc);
+        if (src && dst) {
+            src.seekg((std::streamoff)good);
+            dst << src.rdbuf();
+        }
+        src.close();
+        dst.close();
+        fs::resize_file(path, good, ec);
+        if (ec) return false;
+    }
+    return true;
+}
+
+bool WriteAheadLog::reset() {
+    std::ofstream out(path, std::ios::binary | std::ios::trunc);
+    if (!out) return false;
+    recordCount = 0;
+    byteCount = 0;
+    return true;
+}
@@ -1,12 +1,15 @@
 // main.cpp — тонкий запуск приложения + цикл ImGui
+#include <algorithm>
 #include <iostream>
 #include <string>
 
 #include "AppSession.h"
+#include "Profiler.h"
 
 // GLFW + ImGui
 #include <GLFW/glfw3.h>
 #include "imgui.h"
+#include "imgui_internal.h"   // InputEventsTrail: was there input this frame
 #include "imgui_impl_glfw.h"
 #include "imgui_impl_opengl3.h"
 
@@ -22,6 +25,29 @@ void DrawLogin(AppSession& S);
 void DrawCreate(AppSession& S);
 void DrawForgot(AppSession& S);
 void DrawDashboard(AppSession& S);
+#if BANKING_PROFILER
+void DrawProfilerOverlay(bool* open);
+#endif
+
+// ===== Idle-aware redraw (AppSession::powerSave) =====
+static const double ACTIVE_GRACE_S = 0.5;   // full rate after input: hover, tooltips, ImGui settling
+static const double TEXT_BLINK_S   = 0.2;   // a focused text field still blinks its cursor
+static const double MAX_IDLE_S     = 1.0;   // clock-driven content ("Today" history window)
+
+// How long the loop may sleep before the next frame if no event arrives; 0 = don't sleep
+static double idleTimeout(const AppSession& S, GLFWwindow* window, double activeUntil) {
+    if (glfwGetWindowAttrib(window, GLFW_ICONIFIED)) return MAX_IDLE_S;   // свёрнуто: vsync не тормозит
+    if (!S.powerSave) return 0.0;
+
+    const double now = ImGui::GetTime();
+    if (now < activeUntil || ImGui::IsAnyMouseDown()) return 0.0;   // взаимодействие / drag
+
+    double t = MAX_IDLE_S;
+    if (ImGui::GetIO().WantTextInput) t = std::min(t, TEXT_BLINK_S);
+    const double toastLeft = S.toast_t + AppSession::TOAST_SECONDS - now;
+    if (!S.toast.empty() && toastLeft > 0.0) t = std::min(t, toastLeft);   // убрать тост вовремя
+    return t;
+}
 
 int main() {
     // --- GLFW ---
@@ -45,12 +71,26 @@ int main() {
     ImGui_ImplOpenGL3_Init("#version 150");
 
     AppSession S; // всё состояние приложения
+    S.wakeUi = []{ glfwPostEmptyEvent(); };   // thread-safe in GLFW
+#if BANKING_PROFILER
+    bool showProfiler = false; // F12
+#endif
 
+    double activeUntil = 0.0;
+    double wait = 0.0;
     while (!glfwWindowShouldClose(window)) {
-        glfwPollEvents();
+        // Idle: sleep until input, the next deadline or wakeUi; busy: vsync rate
+        const bool woke = wait > 0.0;
+        if (woke) glfwWaitEventsTimeout(wait);
+        else glfwPollEvents();
         ImGui_ImplOpenGL3_NewFrame();
         ImGui_ImplGlfw_NewFrame();
         ImGui::NewFrame();
+        if (!ImGui::GetCurrentContext()->InputEventsTrail.empty())
+            activeUntil = ImGui::GetTime() + ACTIVE_GRACE_S;
+#if BANKING_PROFILER
+        if (ImGui::IsKeyPressed(ImGuiKey_F12, false)) showProfiler = !showProfiler;
+#endif
 
         // ===== Верхняя глобальная панель (всегда видна) =====
         if (ImGui::BeginMainMenuBar()) {
@@ -68,9 +108,7 @@ int main() {
                 ImGui::SameLine(std::max(0.0f, right - btn_w - spacing));
                 if (ImGui::Button("Logout")) {
                     // сохраняем изменения и сбрасываем сессию
-                    S.db.addOrUpdateCustomer(S.current);
-                    AppSession fresh;
-                    S = fresh;
+                    S.logout();
                     S.ShowToast("Logged out");
                 }
             } else {
@@ -93,27 +131,42 @@ int main() {
 
         ImGui::Begin("Banking System", nullptr, mainFlags);
 
-        switch (S.page) {
-            case Page::MainMenu:  DrawMainMenu(S);  break;
-            case Page::Login:     DrawLogin(S);     break;
-            case Page::Create:    DrawCreate(S);    break;
-            case Page::Forgot:    DrawForgot(S);    break;
-            case Page::Dashboard: DrawDashboard(S); break;
+        {
+            PROF_SCOPE("UI: page");
+            switch (S.page) {
+                case Page::MainMenu:  DrawMainMenu(S);  break;
+                case Page::Login:     DrawLogin(S);     break;
+                case Page::Create:    DrawCreate(S);    break;
+                case Page::Forgot:    DrawForgot(S);    break;
+                case Page::Dashboard: DrawDashboard(S); break;
+            }
         }
 
         ImGui::End();
 
+#if BANKING_PROFILER
+        DrawProfilerOverlay(&showProfiler);
+#endif
+
         // ===== Рендер =====
-        ImGui::Render();
-        int w, h; glfwGetFramebufferSize(window, &w, &h);
-        glViewport(0, 0, w, h);
-        glClearColor(0.10f, 0.10f, 0.12f, 1.0f);
-        glClear(GL_COLOR_BUFFER_BIT);
-        ImGui_ImplOpenGL3_RenderDrawData(ImGui::GetDrawData());
-        glfwSwapBuffers(window);
+        {
+            PROF_SCOPE("UI: render + swap");
+            ImGui::Render();
+            int w, h; glfwGetFramebufferSize(window, &w, &h);
+            glViewport(0, 0, w, h);
+            glClearColor(0.10f, 0.10f, 0.12f, 1.0f);
+            glClear(GL_COLOR_BUFFER_BIT);
+            ImGui_ImplOpenGL3_RenderDrawData(ImGui::GetDrawData());
+            glfwSwapBuffers(window);
+        }
+
+        // after a wake draw one more frame: ImGui may need it to settle the layout
+        wait = woke ? 0.0 : idleTimeout(S, window, activeUntil);
     }
 
     // --- Shutdown ---
+    if (S.rateService) S.rateService->stop(); // no wakeUi calls after glfwTerminate
+    if (S.db) S.db->flush(); // group commit: дописать последнее окно до выхода
     ImGui_ImplOpenGL3_Shutdown();
     ImGui_ImplGlfw_Shutdown();
     ImGui::DestroyContext();
@@ -0,0 +1,258 @@
+// Banking server: hosts the database in one process so several tellers can
+// work on it at once (two app instances on one database.json overwrite each
+// other). Protocol: one JSON request / response per line over loopback TCP,
+// ops in BankService.h.
+//
+//   banking_server [--db data/database.json] [--port 7878] [--threads N]
+//                  [--commit-ms 5] [--commit-ops 1024]
+//
+// One I/O thread polls the sockets and splits lines; requests run on a thread
+// pool (requests of one connection in order, connections in parallel). Money
+// moves in the database's Ledger under per-account lock stripes; the database
+// lock is taken only to write each posting back. Writes are group-committed:
+// every mutation answered within one commit window shares one journal append,
+// and is answered only once it is on disk.
+//
+// Each connection logs in once (op login); the other ops are limited to that
+// customer's data, see BankService.h.
+//
+// The app is its thin client when started with BANKING_SERVER=host:port.
+//
+// Not part of the app target (excluded in the Xcode project), build e.g.:
+//   CORE=$(ls src/core/*.cpp | grep -v AppSession)
+//   clang++ -std=gnu++20 -O2 -Iinclude src/server/BankServer.cpp $CORE -o banking_server
+
+#include <arpa/inet.h>
+#include <fcntl.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <poll.h>
+#include <sys/file.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <atomic>
+#include <cerrno>
+#include <csignal>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <deque>
+#include <iostream>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "BankService.h"
+#include "DatabaseManager.h"
+#include "ThreadPool.h"
+
+static const std::size_t MAX_LINE = 1 << 20;   // запрос длиннее 1 МБ -> закрываем соединение
+
+static int wakePipe[2] = { -1, -1 };
+
+static void onSignal(int) {
+    const char c = 'x';
+    (void)!::write(wakePipe[1], &c, 1);
+}
+
+struct Connection {
+    int fd = -1;
+    std::string inbuf;                 // I/O thread only
+    BankService::Session session;      // the pool job draining it only (who logged in here)
+
+    std::mutex m;                      // guards the rest
+    std::deque<std::string> pending;   // complete request lines
+    bool busy = false;                 // a pool job is draining pending
+    bool closed = false;               // peer went away; whoever is last closes fd
+};
+
+static bool sendAll(int fd, const std::string& data) {
+    std::size_t sent = 0;
+    while (sent < data.size()) {
+        ssize_t n = ::send(fd, data.data() + sent, data.size() - sent, 0);
+        if (n < 0 && errno == EINTR) continue;
+        if (n <= 0) return false;
+        sent += (std::size_t)n;
+    }
+    return true;
+}
+
+static void usage() {
+    std::cerr << "usage: banking_server [--db <database.json>] [--port N] [--threads N]\n"
+                 "                      [--commit-ms N] [--commit-ops N]\n";
+}
+
+int main(int argc, char** argv) {
+    std::string dbPath = "data/database.json";
+    int port = 7878;
+    std::size_t threads = 0;
+    int commitMs = 5;
+    std::size_t commitOps = 1024;
+
+    for (int i = 1; i < argc; ++i) {
+        std::string a = argv[i];
+        auto next = [&]() -> std::string {
+            if (i + 1 >= argc) { usage(); std::exit(2); }
+            return argv[++i];
+        };
+        if      (a == "--db")         dbPath = next();
+        else if (a == "--port")       port = std::atoi(next().c_str());
+        else if (a == "--threads")    threads = (std::size_t)std::strtoull(next().c_str(), nullptr, 10);
+        else if (a == "--commit-ms")  commitMs = std::atoi(next().c_str());
+        else if (a == "--commit-ops") commitOps = (std::size_t)std::strtoull(next().c_str(), nullptr, 10);
+        else { usage(); return 2; }
+    }
+
+    // Один сервер на файл БД
+    const std::string lockPath = dbPath + ".lock";
+    int lockFd = ::open(lockPath.c_str(), O_CREAT | O_RDWR, 0644);
+    if (lockFd < 0 || ::flock(lockFd, LOCK_EX | LOCK_NB) != 0) {
+        std::cerr << dbPath << " is already served by another process (" << lockPath << ")\n";
+        return 1;
+    }
+
+    // Workers mostly wait for their commit window, not for a core: size the
+    // pool for concurrent tellers, not for the CPU count
+    if (threads == 0) threads = std::max(8u, 4 * std::thread::hardware_concurrency());
+
+    DatabaseOptions opt;
+    opt.mode = ShardedStore::isStore(dbPath) ? StorageMode::Sharded : StorageMode::WriteAheadLog;
+    opt.binarySnapshot = true;
+    opt.commitWindowMs = commitMs;
+    opt.commitWindowOps = commitOps;
+    DatabaseManager db(dbPath, opt);
+    BankService service(db);
+
+    int lfd = ::socket(AF_INET, SOCK_STREAM, 0);
+    int one = 1;
+    ::setsockopt(lfd, SOL_SOCKET, SO_REUSEADDR, &one, sizeof(one));
+    sockaddr_in addr{};
+    addr.sin_family = AF_INET;
+    addr.sin_port = htons((uint16_t)port);
+    addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);   // только локальные клиенты
+    if (lfd < 0 || ::bind(lfd, (sockaddr*)&addr, sizeof(addr)) != 0 || ::listen(lfd, 64) != 0) {
+        std::cerr << "Cannot listen on 127.0.0.1:" << port << ": " << std::strerror(errno) << "\n";
+        return 1;
+    }
+    ::fcntl(lfd, F_SETFL, ::fcntl(lfd, F_GETFL) | O_NONBLOCK);
+
+    if (::pipe(wakePipe) != 0) return 1;
+    std::signal(SIGINT, onSignal);
+    std::signal(SIGTERM, onSignal);
+    std::signal(SIGPIPE, SIG_IGN);
+
+    std::atomic<std::uint64_t> served{ 0 };
+    std::map<int, std::shared_ptr<Connection>> conns;
+    {
+        ThreadPool pool(threads);
+        std::printf("serving %s on 127.0.0.1:%d (%zu threads, commit window %d ms)\n",
+                    dbPath.c_str(), port, pool.size(), commitMs);
+        std::fflush(stdout);
+
+        // Drains one connection's queue; at most one such job per connection
+        auto drain = [&](std::shared_ptr<Connection> c) {
+            for (;;) {
+                std::string line;
+                {
+                    std::lock_guard<std::mutex> lk(c->m);
+                    if (c->pending.empty()) {
+                        c->busy = false;
+                        if (c->closed) ::close(c->fd);
+                        return;
+                    }
+                    line = std::move(c->pending.front());
+                    c->pending.pop_front();
+                }
+                std::string out = service.handleLine(line, c->session);
+                out += '\n';
+                ++served;
+                sendAll(c->fd, out);   // ошибку увидит I/O-поток как закрытие
+            }
+        };
+
+        auto dropConnection = [&](std::map<int, std::shared_ptr<Connection>>::iterator it) {
+            std::shared_ptr<Connection> c = it->second;
+            conns.erase(it);
+            std::lock_guard<std::mutex> lk(c->m);
+            c->closed = true;
+            c->pending.clear();
+            if (!c->busy) ::close(c->fd);
+        };
+
+        std::vector<pollfd> fds;
+        for (;;) {
+            fds.clear();
+            fds.push_back({ wakePipe[0], POLLIN, 0 });
+            fds.push_back({ lfd, POLLIN, 0 });
+            for (const auto& kv : conns) fds.push_back({ kv.first, POLLIN, 0 });
+
+            if (::poll(fds.data(), (nfds_t)fds.size(), -1) < 0) {
+                if (errno == EINTR) continue;
+                break;
+            }
+            if (fds[0].revents) break;   // SIGINT / SIGTERM
+
+            if (fds[1].revents & POLLIN) {
+                for (;;) {
+                    int cfd = ::accept(lfd, nullptr, nullptr);
+                    if (cfd < 0) break;
+                    // BSD/macOS наследуют O_NONBLOCK от слушающего сокета; ответы пишем блокирующе
+                    ::fcntl(cfd, F_SETFL, ::fcntl(cfd, F_GETFL) & ~O_NONBLOCK);
+                    ::setsockopt(cfd, IPPROTO_TCP, TCP_NODELAY, &one, sizeof(one));
+                    auto c = std::make_shared<Connection>();
+                    c->fd = cfd;
+                    conns[cfd] = c;
+                }
+            }
+
+            for (std::size_t i = 2; i < fds.size(); ++i) {
+                if (!fds[i].revents) continue;
+                auto it = conns.find(fds[i].fd);
+                if (it == conns.end()) continue;
+                std::shared_ptr<Connection> c = it->second;
+
+                char buf[16 * 1024];
+                ssize_t n = ::recv(c->fd, buf, sizeof(buf), 0);
+                if (n < 0 && errno == EINTR) continue;
+                if (n <= 0) { dropConnection(it); continue; }
+                c->inbuf.append(buf, (std::size_t)n);
+
+                std::vector<std::string> lines;
+                std::size_t start = 0, nl;
+                while ((nl = c->inbuf.find('\n', start)) != std::string::npos) {
+                    if (nl > start) lines.push_back(c->inbuf.substr(start, nl - start));
+                    start = nl + 1;
+                }
+                c->inbuf.erase(0, start);
+                if (c->inbuf.size() > MAX_LINE) { dropConnection(it); continue; }
+                if (lines.empty()) continue;
+
+                bool schedule = false;
+                {
+                    std::lock_guard<std::mutex> lk(c->m);
+                    for (auto& l : lines) c->pending.push_back(std::move(l));
+                    if (!c->busy) schedule = c->busy = true;
+                }
+                if (schedule) pool.submit([&drain, c]{ drain(c); });
+            }
+        }
+
+        std::printf("shutting down...\n");
+        ::close(lfd);
+        while (!conns.empty()) dropConnection(conns.begin());
+        pool.wait();
+    }
+
+    const bool flushed = db.flush();
+    std::printf("served %llu requests, %llu commit windows%s\n",
+                (unsigned long long)served.load(), (unsigned long long)db.commitCount(),
+                flushed ? "" : " (last flush FAILED)");
+    ::flock(lockFd, LOCK_UN);
+    ::close(lockFd);
+    return flushed ? 0 : 1;
+}
@@ -0,0 +1,123 @@
+// Thin client of banking_server: sends one request, or runs a transfer load
+// test from several connections at once.
+//
+//   banking_client [--host 127.0.0.1] [--port 7878] --login <id> <secret> '{"op":"customer"}'
+//   banking_client [--host ...] [--port ...] --login <id> <secret> --load <threads> <transfers-per-thread> <accA> <accB>
+//
+// The server accepts only ping / login until a connection has logged in, so
+// --login sends a login first (on every connection of the load test). The
+// load test moves 0.01 EUR back and forth between accA and accB, which must
+// both belong to that customer, so the balances end where they started.
+//
+// Not part of the app target (excluded in the Xcode project), build e.g.:
+//   clang++ -std=gnu++20 -O2 -Iinclude src/tools/BankClientCli.cpp src/core/BankClient.cpp -o banking_client
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <iostream>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "BankClient.h"
+
+static void usage() {
+    std::cerr << "usage: banking_client [--host H] [--port N] [--login ID SECRET] '<request json>'\n"
+                 "       banking_client [--host H] [--port N] --login ID SECRET --load <threads> <per-thread> <accA> <accB>\n";
+}
+
+// Connects and, with a login given, logs in on the new connection
+static bool open(BankClient& c, const std::string& host, int port, const json& login) {
+    std::string err;
+    if (!c.connect(host, port, &err)) { std::cerr << "Cannot connect: " << err << "\n"; return false; }
+    if (login.is_null()) return true;
+    json res;
+    if (!c.call(login, res)) { std::cerr << "Connection lost.\n"; return false; }
+    if (!res.value("ok", false)) { std::cerr << "Login failed: " << res.value("error", "") << "\n"; return false; }
+    return true;
+}
+
+static int runLoad(const std::string& host, int port, const json& login, int threads, int perThread,
+                   int accA, int accB) {
+    using Clock = std::chrono::steady_clock;
+    std::atomic<long long> ok{ 0 }, failed{ 0 };
+    std::vector<std::vector<double>> lat(threads);
+
+    const auto t0 = Clock::now();
+    std::vector<std::thread> pool;
+    for (int t = 0; t < threads; ++t) {
+        pool.emplace_back([&, t]{
+            BankClient c;
+            if (!open(c, host, port, login)) {
+                failed += perThread;
+                return;
+            }
+            lat[t].reserve(perThread);
+            for (int i = 0; i < perThread; ++i) {
+                // по очереди A->B / B->A, соседние потоки в противофазе
+                const bool ab = ((t + i) % 2) == 0;
+                json req = { { "op", "transfer" }, { "fromAccId", ab ? accA : accB },
+                             { "toAccId", ab ? accB : accA }, { "amountMinor", 1 } };
+                json res;
+                const auto s = Clock::now();
+                if (!c.call(req, res)) { failed += perThread - i; return; }
+                lat[t].push_back(std::chrono::duration<double, std::micro>(Clock::now() - s).count());
+                if (res.value("ok", false)) ++ok; else ++failed;
+            }
+        });
+    }
+    for (auto& th : pool) th.join();
+    const double sec = std::chrono::duration<double>(Clock::now() - t0).count();
+
+    std::vector<double> all;
+    for (auto& v : lat) all.insert(all.end(), v.begin(), v.end());
+    std::sort(all.begin(), all.end());
+    auto pct = [&](double p) { return all.empty() ? 0.0 : all[std::min(all.size() - 1, (std::size_t)(p * all.size()))]; };
+
+    std::printf("transfers ok=%lld failed=%lld in %.2f s: %.0f ops/s, p50=%.0f us, p99=%.0f us\n",
+                ok.load(), failed.load(), sec, (double)(ok + failed) / sec, pct(0.50), pct(0.99));
+    return failed == 0 ? 0 : 3;
+}
+
+int main(int argc, char** argv) {
+    std::string host = "127.0.0.1";
+    int port = 7878;
+    json login;
+    std::vector<std::string> rest;
+
+    for (int i = 1; i < argc; ++i) {
+        std::string a = argv[i];
+        if      (a == "--host" && i + 1 < argc) host = argv[++i];
+        else if (a == "--port" && i + 1 < argc) port = std::atoi(argv[++i]);
+        else if (a == "--login" && i + 2 < argc) {
+            login = { { "op", "login" }, { "customerId", argv[i + 1] }, { "secret", argv[i + 2] } };
+            i += 2;
+        }
+        else rest.push_back(a);
+    }
+
+    if (!rest.empty() && rest[0] == "--load") {
+        if (rest.size() != 5 || login.is_null()) { usage(); return 2; }
+        return runLoad(host, port, login, std::atoi(rest[1].c_str()), std::atoi(rest[2].c_str()),
+                       std::atoi(rest[3].c_str()), std::atoi(rest[4].c_str()));
+    }
+    if (rest.size() != 1) { usage(); return 2; }
+
+    json req;
+    try {
+        req = json::parse(rest[0]);
+    } catch (...) {
+        std::cerr << "Request is not valid JSON.\n";
+        return 2;
+    }
+
+    BankClient c;
+    if (!open(c, host, port, login)) return 1;
+    json res;
+    if (!c.call(req, res)) { std::cerr << "Connection lost.\n"; return 1; }
+    std::cout << res.dump(2) << "\n";
+    return res.value("ok", false) ? 0 : 3;
+}
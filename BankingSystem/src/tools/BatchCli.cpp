@@ -0,0 +1,110 @@
+// Headless end-of-day processing: applies a file of deposits / withdrawals /
+// transfers to the database without the UI, and / or accrues savings interest
+// on every Savings account.
+//
+//   banking_batch --in ops.csv [--db data/database.json] [--out results.csv]
+//                 [--format csv|jsonl] [--batch-size N]
+//   banking_batch --accrue [--date YYYY-MM-DD] [--threads N] [--db data/database.json]
+//
+// Not part of the app target (excluded in the Xcode project), build e.g.:
+//   CORE=$(ls src/core/*.cpp | grep -v AppSession)
+//   clang++ -std=gnu++20 -O2 -Iinclude src/tools/BatchCli.cpp $CORE -o banking_batch
+
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <iostream>
+#include <string>
+
+#include "BatchProcessor.h"
+#include "DatabaseManager.h"
+
+static void usage() {
+    std::cerr << "usage: banking_batch --in <ops.csv|ops.jsonl> [--db <database.json>]\n"
+                 "                     [--out <results.csv>] [--format csv|jsonl] [--batch-size N]\n"
+                 "  --batch-size 0 (default) = the whole input is one batch, persisted once\n"
+                 "       banking_batch --accrue [--date YYYY-MM-DD] [--threads N] [--db <database.json>]\n"
+                 "  --date defaults to today (local time); --in may be combined, ops run first\n";
+}
+
+static int runAccrual(DatabaseManager& db, const std::string& date, std::size_t threads) {
+    Date day = Date::today();
+    if (!date.empty() && !Date::parse(date, day)) { std::cerr << "Bad --date (expected YYYY-MM-DD).\n"; return 2; }
+
+    AccrualReport r;
+    const bool ok = db.accrueSavingsInterest(day, r, threads);
+    std::printf("accrual %s: savings=%zu credited=%zu newly-dated=%zu interest=%s EUR\n",
+                r.date.iso().c_str(), r.accounts, r.credited, r.dated, r.totalInterest.toString().c_str());
+    std::printf("total=%.1f ms  compute=%.1f ms\n", r.totalMs, r.computeMs);
+    if (!ok) { std::cerr << "Failed to save the accrual.\n"; return 1; }
+    return 0;
+}
+
+static bool endsWith(const std::string& s, const std::string& suffix) {
+    return s.size() >= suffix.size() && s.compare(s.size() - suffix.size(), suffix.size(), suffix) == 0;
+}
+
+int main(int argc, char** argv) {
+    std::string dbPath = "data/database.json";
+    std::string inPath, outPath, format, accrueDate;
+    std::size_t batchSize = 0, threads = 0;
+    bool accrue = false;
+
+    for (int i = 1; i < argc; ++i) {
+        std::string a = argv[i];
+        auto next = [&]() -> std::string {
+            if (i + 1 >= argc) { usage(); std::exit(2); }
+            return argv[++i];
+        };
+        if      (a == "--db")         dbPath = next();
+        else if (a == "--in")         inPath = next();
+        else if (a == "--out")        outPath = next();
+        else if (a == "--format")     format = next();
+        else if (a == "--batch-size") batchSize = (std::size_t)std::strtoull(next().c_str(), nullptr, 10);
+        else if (a == "--accrue")     accrue = true;
+        else if (a == "--date")       accrueDate = next();
+        else if (a == "--threads")    threads = (std::size_t)std::strtoull(next().c_str(), nullptr, 10);
+        else { usage(); return 2; }
+    }
+    if (inPath.empty() && !accrue) { usage(); return 2; }
+
+    // Same storage settings as the app, so its journal is honoured and folded in
+    // (a directory made by banking_shard is opened as a sharded store)
+    DatabaseOptions opt;
+    opt.mode = ShardedStore::isStore(dbPath) ? StorageMode::Sharded : StorageMode::WriteAheadLog;
+    opt.binarySnapshot = true;
+    DatabaseManager db(dbPath, opt);
+
+    if (inPath.empty()) return runAccrual(db, accrueDate, threads);
+    if (outPath.empty()) outPath = inPath + ".results.csv";
+
+    BatchFormat fmt = BatchFormat::Csv;
+    if (format == "jsonl" || (format.empty() && (endsWith(inPath, ".jsonl") || endsWith(inPath, ".json"))))
+        fmt = BatchFormat::JsonLines;
+    else if (!format.empty() && format != "csv") { usage(); return 2; }
+
+    std::ifstream in(inPath);
+    if (!in) { std::cerr << "Cannot open " << inPath << "\n"; return 1; }
+    std::ofstream out(outPath, std::ios::trunc);
+    if (!out) { std::cerr << "Cannot write " << outPath << "\n"; return 1; }
+
+    BatchProcessor proc(db);
+    BatchStats st;
+    const bool ok = proc.run(in, fmt, out, batchSize, st);
+    out.flush();
+
+    std::printf("ops=%zu ok=%zu failed=%zu batches=%zu\n", st.ops, st.ok, st.failed, st.batches);
+    std::printf("total=%.1f ms  apply=%.1f ms  persist=%.1f ms  throughput=%.0f ops/s\n",
+                st.totalMs, st.applyMs, st.persistMs, st.opsPerSec());
+    std::printf("results: %s\n", outPath.c_str());
+
+    if (!ok) {
+        std::cerr << "Failed to persist a batch; its operations are reported as failed.\n";
+        return 1;
+    }
+    if (accrue) {
+        const int rc = runAccrual(db, accrueDate, threads);
+        if (rc != 0) return rc;
+    }
+    return st.failed == 0 ? 0 : 3;
+}
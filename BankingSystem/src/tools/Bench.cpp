@@ -0,0 +1,414 @@
+// Benchmarks for the core and the persistence layer over synthetic databases.
+//
+//   banking_bench [--sizes 1000,100000,1000000] [--accounts 2] [--transfer-ratio 2]
+//                 [--legacy 0.1] [--iters 2000] [--budget-ms 3000] [--dir bench_data]
+//                 [--out bench.jsonl] [--seed 42] [--threads 1,2,4,8]
+//
+// One JSON object per (size, benchmark) on stdout (and --out), e.g.
+//   {"bench":"findCustomerByName","customers":100000,...,"opsPerSec":...,"p50Us":...,
+//    "p99Us":...,"peakRssKb":...}
+//
+// Not part of the app target (excluded in the Xcode project). AppSession pulls in
+// ImGui (toast timer), so the ImGui core sources are linked too, e.g.:
+//   clang++ -std=gnu++20 -O2 -Iinclude -Ithird_party/imgui src/tools/Bench.cpp src/core/*.cpp
+//           third_party/imgui/imgui{,_draw,_tables,_widgets}.cpp -o banking_bench
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <filesystem>
+#include <fstream>
+#include <functional>
+#include <iostream>
+#include <random>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+
+#if !defined(_WIN32) && !defined(_WIN64)
+#  include <sys/resource.h>
+#endif
+
+#include "AppSession.h"
+#include "DatabaseManager.h"
+#include "Customer.h"
+#include "Account.h"
+#include "CustomerStream.h"
+#include "Ledger.h"
+
+namespace fs = std::filesystem;
+
+// ---------------------- options ----------------------
+struct BenchOptions {
+    std::vector<std::size_t> sizes{ 1000, 100000, 1000000 };
+    int accountsPerCustomer = 2;        // Checking, Savings, then FX
+    double transferRatio = 2.0;         // log entries per customer
+    double legacyRatio = 0.1;           // share of records in the old layout
+    std::size_t iters = 2000;           // per benchmark, cut short by budgetMs
+    double budgetMs = 3000.0;
+    std::string dir = "bench_data";
+    std::string out;
+    unsigned long long seed = 42;
+    std::vector<std::size_t> threads{ 1, 2, 4, 8 };   // ledger scaling
+};
+
+struct Sample {
+    std::vector<double> us;   // per-op latency
+    double totalMs = 0.0;
+};
+
+// ---------------------- helpers ----------------------
+static long peakRssKb() {
+#if !defined(_WIN32) && !defined(_WIN64)
+    struct rusage ru{};
+    if (::getrusage(RUSAGE_SELF, &ru) != 0) return 0;
+#  if defined(__APPLE__)
+    return (long)(ru.ru_maxrss / 1024);   // bytes on macOS
+#  else
+    return (long)ru.ru_maxrss;            // KB on Linux
+#  endif
+#else
+    return 0;
+#endif
+}
+
+static std::vector<std::size_t> parseSizes(const std::string& s) {
+    std::vector<std::size_t> out;
+    std::stringstream ss(s);
+    std::string part;
+    while (std::getline(ss, part, ','))
+        if (!part.empty()) out.push_back((std::size_t)std::strtoull(part.c_str(), nullptr, 10));
+    return out;
+}
+
+// Runs op up to `iters` times or until the budget is spent (at least once)
+static Sample measure(std::size_t iters, double budgetMs, const std::function<void(std::size_t)>& op) {
+    using clock = std::chrono::steady_clock;
+    Sample s;
+    s.us.reserve(std::min<std::size_t>(iters, 1u << 20));
+    const auto start = clock::now();
+    for (std::size_t i = 0; i < iters; ++i) {
+        const auto t0 = clock::now();
+        op(i);
+        const auto t1 = clock::now();
+        s.us.push_back(std::chrono::duration<double, std::micro>(t1 - t0).count());
+        if (std::chrono::duration<double, std::milli>(t1 - start).count() > budgetMs) break;
+    }
+    for (double u : s.us) s.totalMs += u / 1000.0;
+    return s;
+}
+
+static double percentile(std::vector<double> v, double p) {
+    if (v.empty()) return 0.0;
+    std::size_t k = (std::size_t)(p * (double)(v.size() - 1) + 0.5);
+    std::nth_element(v.begin(), v.begin() + (std::ptrdiff_t)k, v.end());
+    return v[k];
+}
+
+// ---------------------- synthetic database ----------------------
+static std::string firstNameOf(std::size_t i) { return "First" + std::to_string(i % 997); }
+static std::string lastNameOf(std::size_t i)  { return "Last" + std::to_string(i % 50021); }
+static std::string customerIdOf(std::size_t i) { return std::to_string(10000000 + i); }
+
+// accIds are sequential from 100000, so 1M customers run past the 6-digit space
+static json makeSyntheticDb(std::size_t customers, const BenchOptions& o, std::mt19937_64& rng) {
+    std::uniform_real_distribution<double> u01(0.0, 1.0);
+    std::uniform_int_distribution<long long> cents(0, 5000000);
+    const long long nowMs = std::chrono::duration_cast<std::chrono::milliseconds>(
+        std::chrono::system_clock::now().time_since_epoch()).count();
+
+    json root = json::object();
+    json& custs = root["customers"] = json::object();
+    int nextAccId = 100000;
+
+    for (std::size_t i = 0; i < customers; ++i) {
+        const bool legacy = u01(rng) < o.legacyRatio;
+        json c = json::object();
+        if (legacy) {
+            c["name"] = firstNameOf(i) + " " + lastNameOf(i);
+        } else {
+            c["firstName"] = firstNameOf(i);
+            c["lastName"]  = lastNameOf(i);
+            c["name"]      = firstNameOf(i) + " " + lastNameOf(i);
+            c["phone"]     = "+3706" + std::to_string(1000000 + i % 9000000);
+        }
+        c["age"] = 18 + (int)(i % 60);
+        c["email"] = "user" + std::to_string(i) + "@example.com";
+        c["secretWord"] = "secret";
+
+        json accs = json::array();
+        for (int k = 0; k < o.accountsPerCustomer; ++k) {
+            const long long minor = cents(rng);
+            json a = json::object();
+            a["accId"] = nextAccId++;
+            a["type"] = k == 0 ? "Checking" : (k == 1 ? "Savings" : "FX");
+            a["balance"] = (double)minor / 100.0;
+            if (!legacy) a["balanceMinor"] = minor;
+            if (k == 1) {
+                a["savingsRate"] = 0.15;
+                a["lastSavedDate"] = "2025-01-01";
+            }
+            if (k >= 2) a["currency"] = "USD";
+            accs.push_back(std::move(a));
+        }
+        c["accounts"] = std::move(accs);
+        custs[customerIdOf(i)] = std::move(c);
+    }
+
+    json& log = root["transfers"] = json::array();
+    const std::size_t nTransfers = (std::size_t)((double)customers * o.transferRatio);
+    std::uniform_int_distribution<std::size_t> pick(0, customers ? customers - 1 : 0);
+    for (std::size_t t = 0; t < nTransfers; ++t) {
+        const std::size_t from = pick(rng), to = pick(rng);
+        const long long minor = 1 + cents(rng) / 100;
+        json e = json::object();
+        e["ts"] = nowMs - (long long)(nTransfers - t) * 1000;
+        e["status"] = "ok";
+        e["mode"] = "by_account_id";
+        e["fromCustomerId"] = customerIdOf(from);
+        e["toCustomerId"] = customerIdOf(to);
+        e["fromAccId"] = 100000 + (int)(from * (std::size_t)o.accountsPerCustomer);
+        e["toAccId"] = 100000 + (int)(to * (std::size_t)o.accountsPerCustomer);
+        e["amountMinor"] = minor;
+        e["amount"] = (double)minor / 100.0;
+        e["target"] = std::to_string(100000 + to * (std::size_t)o.accountsPerCustomer);
+        e["error"] = "";
+        log.push_back(std::move(e));
+    }
+    return root;
+}
+
+// ---------------------- report ----------------------
+static void report(std::ostream* file, const std::string& bench, std::size_t customers,
+                   const BenchOptions& o, const Sample& s, const json& extra = json::object()) {
+    json r = json::object();
+    r["bench"] = bench;
+    r["customers"] = customers;
+    r["accountsPerCustomer"] = o.accountsPerCustomer;
+    r["transfers"] = (std::size_t)((double)customers * o.transferRatio);
+    r["legacyRatio"] = o.legacyRatio;
+    r["iterations"] = s.us.size();
+    r["opsPerSec"] = s.totalMs > 0.0 ? (double)s.us.size() * 1000.0 / s.totalMs : 0.0;
+    r["p50Us"] = percentile(s.us, 0.50);
+    r["p99Us"] = percentile(s.us, 0.99);
+    r["peakRssKb"] = peakRssKb();
+    for (auto it = extra.begin(); it != extra.end(); ++it) r[it.key()] = it.value();
+
+    const std::string line = r.dump();
+    std::cout << line << std::endl;
+    if (file) *file << line << "\n";
+}
+
+// ---------------------- suite ----------------------
+static void runSize(std::size_t n, const BenchOptions& o, std::ostream* file) {
+    std::mt19937_64 rng(o.seed + n);
+    fs::create_directories(o.dir);
+    const std::string path = o.dir + "/bench_" + std::to_string(n) + ".json";
+    for (const char* ext : { "", ".bak", ".tmp", ".wal", ".snap" }) fs::remove(path + ext);
+
+    // generate + first save (pretty JSON, as the app writes it)
+    {
+        json db = makeSyntheticDb(n, o, rng);
+        DatabaseManager writer(path, DatabaseOptions());
+        Sample s = measure(1, o.budgetMs, [&](std::size_t){ writer.saveAll(db); });
+        report(file, "generate+saveAll", n, o, s, { { "fileBytes", (std::uintmax_t)fs::file_size(path) } });
+    }
+
+    // cold load: constructor parses the file
+    {
+        Sample s = measure(3, o.budgetMs, [&](std::size_t){ DatabaseManager cold(path, DatabaseOptions()); });
+        report(file, "coldLoad", n, o, s);
+    }
+
+    DatabaseManager db(path, DatabaseOptions());
+    std::uniform_int_distribution<std::size_t> pick(0, n ? n - 1 : 0);
+
+    {
+        json tmp;
+        Sample s = measure(std::min<std::size_t>(o.iters, 50), o.budgetMs,
+                           [&](std::size_t){ db.loadAll(tmp); });
+        report(file, "loadAll", n, o, s);
+
+        Sample w = measure(std::min<std::size_t>(o.iters, 10), o.budgetMs,
+                           [&](std::size_t){ db.saveAll(tmp); });
+        report(file, "saveAll", n, o, w);
+    }
+
+    {
+        std::size_t found = 0;
+        Sample s = measure(o.iters, o.budgetMs, [&](std::size_t){
+            const std::size_t i = pick(rng);
+            std::string id;
+            if (db.findCustomerByName(firstNameOf(i), lastNameOf(i), id)) ++found;
+        });
+        report(file, "findCustomerByName", n, o, s, { { "hits", found } });
+    }
+
+    {
+        Sample s = measure(o.iters, o.budgetMs, [&](std::size_t){ (void)db.generateUniqueAccountId(); });
+        report(file, "generateUniqueAccountId", n, o, s);
+    }
+
+    {
+        std::size_t rows = 0;
+        Sample s = measure(o.iters, o.budgetMs, [&](std::size_t){
+            rows += db.getTransfersForCustomer(customerIdOf(pick(rng)), 0).size();
+        });
+        report(file, "getTransfersForCustomer", n, o, s, { { "rows", rows } });
+    }
+
+    {
+        // one customer without building the document (SAX, stops at the customer)
+        std::size_t found = 0;
+        Customer c;
+        Sample s = measure(std::min<std::size_t>(o.iters, 50), o.budgetMs, [&](std::size_t){
+            if (streamLoadCustomer(path, customerIdOf(pick(rng)), c)) ++found;
+        });
+        report(file, "streamLoadCustomer", n, o, s, { { "hits", found } });
+    }
+
+    {
+        // interest only: the customer is loaded outside the timed section
+        const Date today = AppSession::todayDate();
+        Customer c;
+        Sample s;
+        for (std::size_t i = 0; i < o.iters; ++i) {
+            if (!db.loadCustomer(customerIdOf(pick(rng)), c)) continue;
+            Sample one = measure(1, o.budgetMs, [&](std::size_t){ AppSession::applySavingsInterest(c, today); });
+            s.us.push_back(one.us[0]);
+            s.totalMs += one.totalMs;
+            if (s.totalMs > o.budgetMs) break;
+        }
+        report(file, "applySavingsInterest", n, o, s);
+    }
+
+    {
+        // end-of-day job over the whole database: scan + parallel compute + one snapshot
+        AccrualReport r;
+        const Date today = AppSession::todayDate();
+        Sample s = measure(1, o.budgetMs, [&](std::size_t){ db.accrueSavingsInterest(today, r); });
+        report(file, "accrueSavingsInterest", n, o, s, { { "savings", r.accounts }, { "credited", r.credited },
+                                                        { "computeMs", r.computeMs } });
+    }
+
+    {
+        // write path in the app's mode (WAL): balance-only change per op
+        DatabaseOptions walOpt;
+        walOpt.mode = StorageMode::WriteAheadLog;
+        DatabaseManager wal(path, walOpt);
+        Customer c;
+        Sample s = measure(o.iters, o.budgetMs, [&](std::size_t i){
+            if (!wal.loadCustomer(customerIdOf(pick(rng)), c) || c.getAccounts().empty()) return;
+            Account& a = c.getAccounts()[0];
+            a.setBalance(a.getBalance() + Money((std::int64_t)(i % 7) + 1, a.getBalance().currency()));
+            wal.addOrUpdateCustomer(c);
+        });
+        report(file, "addOrUpdateCustomer(wal)", n, o, s);
+    }
+
+    {
+        // same write path on the sharded layout: one shard file + the manifest per op
+        const std::string dir = path + ".shards";
+        std::error_code ec;
+        std::filesystem::remove_all(dir, ec);
+        DatabaseOptions shOpt;
+        shOpt.mode = StorageMode::Sharded;
+        DatabaseManager sharded(dir, shOpt);
+        json root;
+        Sample migrate = measure(1, o.budgetMs, [&](std::size_t){ db.loadAll(root); sharded.saveAll(root); });
+        report(file, "migrateToSharded", n, o, migrate, { { "shards", shOpt.shardCount } });
+
+        Customer c;
+        Sample s = measure(o.iters, o.budgetMs, [&](std::size_t i){
+            if (!sharded.loadCustomer(customerIdOf(pick(rng)), c) || c.getAccounts().empty()) return;
+            Account& a = c.getAccounts()[0];
+            a.setBalance(a.getBalance() + Money((std::int64_t)(i % 7) + 1, a.getBalance().currency()));
+            sharded.addOrUpdateCustomer(c);
+        });
+        report(file, "addOrUpdateCustomer(sharded)", n, o, s);
+        std::filesystem::remove_all(dir, ec);
+    }
+
+    {
+        // concurrent ledger: random transfers between all accounts, N threads;
+        // "stripes":1 is the same engine behind one lock, for comparison
+        Ledger proto;
+        Sample load = measure(1, o.budgetMs, [&](std::size_t){ proto.reset(db.accountBalances()); });
+        report(file, "ledgerLoad", n, o, load, { { "accounts", proto.size() } });
+
+        std::vector<int> ids = db.existingAccountIds();
+        for (std::size_t stripes : { (std::size_t)64, (std::size_t)1 }) {
+            for (std::size_t t : o.threads) {
+                if (ids.size() < 2 || t == 0) continue;
+                Ledger ledger(stripes);
+                for (int id : ids) ledger.open(id, Money::fromMajor(1000000.0));   // EUR, хватит на все переводы
+
+                const std::size_t perThread = o.iters * 10;
+                std::vector<Sample> per(t);
+                std::vector<std::thread> pool;
+                const auto start = std::chrono::steady_clock::now();
+                for (std::size_t k = 0; k < t; ++k) {
+                    pool.emplace_back([&, k]{
+                        std::mt19937_64 r(o.seed + k);
+                        std::uniform_int_distribution<std::size_t> acc(0, ids.size() - 1);
+                        std::uniform_int_distribution<std::size_t> other(0, ids.size() - 2);
+                        per[k] = measure(perThread, o.budgetMs, [&](std::size_t){
+                            // два разных счёта: перевод самому себе отклоняется без блокировок
+                            const std::size_t from = acc(r);
+                            std::size_t to = other(r);
+                            if (to >= from) ++to;
+                            ledger.transfer(ids[from], ids[to], Money(1, EUR));
+                        });
+                    });
+                }
+                for (auto& th : pool) th.join();
+
+                Sample all;
+                for (auto& p : per) all.us.insert(all.us.end(), p.us.begin(), p.us.end());
+                all.totalMs = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+                report(file, "ledgerTransfer", n, o, all, { { "threads", t }, { "stripes", stripes } });
+            }
+        }
+    }
+
+    for (const char* ext : { "", ".bak", ".tmp", ".wal", ".snap" }) fs::remove(path + ext);
+}
+
+static void usage() {
+    std::cerr << "usage: banking_bench [--sizes 1000,100000,1000000] [--accounts N] [--transfer-ratio R]\n"
+                 "                     [--legacy 0..1] [--iters N] [--budget-ms MS] [--dir DIR]\n"
+                 "                     [--out FILE.jsonl] [--seed N] [--threads 1,2,4,8]\n";
+}
+
+int main(int argc, char** argv) {
+    BenchOptions o;
+    for (int i = 1; i < argc; ++i) {
+        std::string a = argv[i];
+        auto next = [&]() -> std::string {
+            if (i + 1 >= argc) { usage(); std::exit(2); }
+            return argv[++i];
+        };
+        if      (a == "--sizes")          o.sizes = parseSizes(next());
+        else if (a == "--accounts")       o.accountsPerCustomer = std::max(1, std::atoi(next().c_str()));
+        else if (a == "--transfer-ratio") o.transferRatio = std::atof(next().c_str());
+        else if (a == "--legacy")         o.legacyRatio = std::atof(next().c_str());
+        else if (a == "--iters")          o.iters = (std::size_t)std::strtoull(next().c_str(), nullptr, 10);
+        else if (a == "--budget-ms")      o.budgetMs = std::atof(next().c_str());
+        else if (a == "--dir")            o.dir = next();
+        else if (a == "--out")            o.out = next();
+        else if (a == "--seed")           o.seed = std::strtoull(next().c_str(), nullptr, 10);
+        else if (a == "--threads")        o.threads = parseSizes(next());
+        else { usage(); return 2; }
+    }
+
+    std::ofstream file;
+    if (!o.out.empty()) {
+        file.open(o.out, std::ios::trunc);
+        if (!file) { std::cerr << "Cannot write " << o.out << "\n"; return 1; }
+    }
+
+    for (std::size_t n : o.sizes) runSize(n, o, file.is_open() ? &file : nullptr);
+    return 0;
+}
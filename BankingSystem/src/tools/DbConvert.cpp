@@ -0,0 +1,73 @@
+// Converts the database file between JSON, CBOR and MessagePack.
+//
+//   dbconvert <in> <out> [--to json|cbor|msgpack]
+//
+// The input encoding is detected from the content; the output one comes from
+// --to or the extension of <out> (.cbor / .msgpack / .mpk, otherwise JSON).
+// The document is transcoded as is (a legacy layout stays legacy; the app
+// normalizes it on load).
+//
+// Not part of the app target (excluded in the Xcode project), build e.g.:
+//   clang++ -std=gnu++20 -O2 -Iinclude src/tools/DbConvert.cpp src/core/DbFormat.cpp
+//           src/core/FileSync.cpp -o dbconvert
+
+#include <cstdio>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <string>
+
+#include "DbFormat.h"
+#include "FileSync.h"
+
+namespace fs = std::filesystem;
+
+static void usage() {
+    std::cerr << "usage: dbconvert <in> <out> [--to json|cbor|msgpack]\n";
+}
+
+int main(int argc, char** argv) {
+    std::string inPath, outPath;
+    FileFormat to = FileFormat::Auto;
+
+    for (int i = 1; i < argc; ++i) {
+        std::string a = argv[i];
+        if (a == "--to" && i + 1 < argc) {
+            if (!parseFormatName(argv[++i], to)) { usage(); return 2; }
+        } else if (inPath.empty()) {
+            inPath = a;
+        } else if (outPath.empty()) {
+            outPath = a;
+        } else {
+            usage();
+            return 2;
+        }
+    }
+    if (inPath.empty() || outPath.empty()) { usage(); return 2; }
+    if (to == FileFormat::Auto) to = formatFromPath(outPath);
+
+    std::ifstream in(inPath, std::ios::binary);
+    if (!in) { std::cerr << "Cannot open " << inPath << "\n"; return 1; }
+    std::string bytes((std::istreambuf_iterator<char>(in)), std::istreambuf_iterator<char>());
+
+    json doc;
+    FileFormat from = FileFormat::Json;
+    if (!decodeDocument(bytes, doc, &from)) {
+        std::cerr << "Cannot parse " << inPath << " (detected " << formatName(from) << ")\n";
+        return 1;
+    }
+
+    const std::string outBytes = encodeDocument(doc, to);
+    const std::string tmp = outPath + ".tmp";
+    // как DatabaseManager: tmp на диске до rename, сам rename — после syncDir
+    if (!writeFileSynced(tmp, outBytes, false)) { std::cerr << "Write failed: " << tmp << "\n"; return 1; }
+    std::error_code ec;
+    fs::rename(tmp, outPath, ec);
+    if (ec) { std::cerr << "Cannot replace " << outPath << ": " << ec.message() << "\n"; return 1; }
+    if (!syncDir(parentDirOf(outPath))) { std::cerr << "Cannot sync the directory of " << outPath << "\n"; return 1; }
+
+    std::printf("%s (%s, %zu bytes) -> %s (%s, %zu bytes)\n",
+                inPath.c_str(), formatName(from), bytes.size(),
+                outPath.c_str(), formatName(to), outBytes.size());
+    return 0;
+}
@@ -0,0 +1,125 @@
+// Moves a database between the single-file layout (Snapshot / WAL mode) and the
+// sharded directory layout (StorageMode::Sharded, see ShardedStore.h).
+//
+//   banking_shard <from> <to> [--to sharded|file] [--shards N] [--segment-bytes N]
+//                 [--format json|cbor|msgpack] [--force]
+//
+// The source layout is detected: a directory with manifest.json is sharded, a
+// file with a <file>.wal journal is read in WAL mode (the journal is folded in),
+// anything else as a plain snapshot. --to defaults to the other layout.
+// <to> must not exist (or be empty); --force first removes an existing store
+// there (a sharded directory, or a database file with its .wal / .snap / ...
+// files). A non-empty directory that isn't a store is never touched. The
+// source is left as is.
+//
+// Not part of the app target (excluded in the Xcode project), build e.g.:
+//   CORE=$(ls src/core/*.cpp | grep -v AppSession)
+//   clang++ -std=gnu++20 -O2 -Iinclude src/tools/ShardMigrate.cpp $CORE -o banking_shard
+
+#include <cstdio>
+#include <cstdlib>
+#include <filesystem>
+#include <iostream>
+#include <string>
+
+#include "DatabaseManager.h"
+
+namespace fs = std::filesystem;
+
+static void usage() {
+    std::cerr << "usage: banking_shard <from> <to> [--to sharded|file] [--shards N]\n"
+                 "                     [--segment-bytes N] [--format json|cbor|msgpack] [--force]\n"
+                 "  --force: remove the store already at <to> (sharded directory or database file)\n";
+}
+
+// Файлы, которые DatabaseManager держит рядом с файлом базы
+static const char* const FILE_SIDECARS[] = { "", ".wal", ".snap", ".bak", ".tmp", ".corrupt", ".wal.corrupt" };
+
+// --force: убираем старую базу в <to>. Каталог чистим, только если это хранилище
+// (есть manifest.json), иначе это чужие файлы
+static bool clearTarget(const std::string& to) {
+    std::error_code ec;
+    if (fs::is_directory(to, ec)) {
+        if (fs::is_empty(to, ec)) return true;
+        if (!ShardedStore::isStore(to)) {
+            std::cerr << to << " is a directory but not a sharded store (no manifest.json); not clearing it\n";
+            return false;
+        }
+        for (const auto& entry : fs::directory_iterator(to, ec)) {
+            fs::remove_all(entry.path(), ec);
+            if (ec) break;
+        }
+    } else {
+        for (const char* suffix : FILE_SIDECARS) {
+            fs::remove(to + suffix, ec);
+            if (ec) break;
+        }
+    }
+    if (ec) { std::cerr << "Cannot clear " << to << ": " << ec.message() << "\n"; return false; }
+    return true;
+}
+
+int main(int argc, char** argv) {
+    std::string fromPath, toPath, toLayout;
+    DatabaseOptions dst;
+    bool force = false;
+
+    for (int i = 1; i < argc; ++i) {
+        std::string a = argv[i];
+        auto next = [&]() -> std::string { return i + 1 < argc ? argv[++i] : ""; };
+        if (a == "--to")                 toLayout = next();
+        else if (a == "--shards")        dst.shardCount = (std::size_t)std::strtoull(next().c_str(), nullptr, 10);
+        else if (a == "--segment-bytes") dst.transferSegmentBytes = std::strtoull(next().c_str(), nullptr, 10);
+        else if (a == "--format") {
+            if (!parseFormatName(next(), dst.format)) { usage(); return 2; }
+        }
+        else if (a == "--force")         force = true;
+        else if (fromPath.empty())       fromPath = a;
+        else if (toPath.empty())         toPath = a;
+        else { usage(); return 2; }
+    }
+    if (fromPath.empty() || toPath.empty() || dst.shardCount == 0 || dst.transferSegmentBytes == 0) {
+        usage();
+        return 2;
+    }
+
+    // DatabaseManager создаёт пустую базу, если её нет -> проверяем заранее
+    std::error_code ec;
+    if (!fs::exists(fromPath, ec)) { std::cerr << "Not found: " << fromPath << "\n"; return 1; }
+    if (fs::exists(toPath, ec) && fs::equivalent(fromPath, toPath, ec)) {
+        std::cerr << "<from> and <to> are the same\n";
+        return 1;
+    }
+    if (fs::exists(toPath, ec) && !(fs::is_directory(toPath, ec) && fs::is_empty(toPath, ec))) {
+        if (!force) {
+            std::cerr << toPath << " already exists (use --force to replace the store there)\n";
+            return 1;
+        }
+        if (!clearTarget(toPath)) return 1;
+    }
+
+    DatabaseOptions src;
+    if (ShardedStore::isStore(fromPath))           src.mode = StorageMode::Sharded;
+    else if (fs::exists(fromPath + ".wal", ec))    src.mode = StorageMode::WriteAheadLog;
+    else if (fs::is_directory(fromPath, ec)) { std::cerr << fromPath << " has no manifest.json\n"; return 1; }
+
+    if (toLayout.empty()) toLayout = src.mode == StorageMode::Sharded ? "file" : "sharded";
+    if (toLayout == "sharded")   dst.mode = StorageMode::Sharded;
+    else if (toLayout == "file") dst.mode = StorageMode::Snapshot;
+    else { usage(); return 2; }
+
+    json root;
+    {
+        DatabaseManager in(fromPath, src);
+        if (!in.loadAll(root)) { std::cerr << "Cannot read " << fromPath << "\n"; return 1; }
+    }
+    {
+        DatabaseManager out(toPath, dst);
+        if (!out.saveAll(root)) { std::cerr << "Cannot write " << toPath << "\n"; return 1; }
+    }
+
+    std::printf("%s -> %s (%s): %zu customers, %zu transfers\n",
+                fromPath.c_str(), toPath.c_str(), toLayout.c_str(),
+                root["customers"].size(), root["transfers"].size());
+    return 0;
+}
@@ -1,13 +1,21 @@
 #include "AppSession.h"
+#include "Profiler.h"
 #include "imgui.h"
 #include "imgui_stdlib.h"
 #include <algorithm>
 
 void DrawCreate(AppSession& S) {
+    PROF_SCOPE("UI: DrawCreate");
     constexpr double DEFAULT_SAVINGS_RATE = 0.15;
 
     ImGui::SeparatorText("Create profile");
 
+    if (S.remote()) {
+        ImGui::TextWrapped("Sign-up is not available in server mode (BANKING_SERVER).");
+        if (ImGui::Button("Back")) S.page = Page::MainMenu;
+        return;
+    }
+
     ImGui::InputText("First name", &S.cFirstName);
     ImGui::InputText("Last name",  &S.cLastName);
     ImGui::InputInt("Age", &S.cAge);
@@ -33,7 +41,7 @@ void DrawCreate(AppSession& S) {
         if (S.cAge < 0) S.cAge = 0;
         if (S.cAge > 130) { S.ShowToast("Age looks incorrect."); return; }
 
-        if (S.db.customerExists(S.cId)) {
+        if (S.db->customerExists(S.cId)) {
             S.loginId = S.cId;
             S.loginPhone = S.cPhone;
             S.page = Page::Login;
@@ -44,23 +52,25 @@ void DrawCreate(AppSession& S) {
         Customer cust(S.cFirstName, S.cLastName, std::max(0, S.cAge),
                       S.cEmail, S.cId, S.cSecret, S.cPhone);
 
+        // one block of ids for everything opened at sign-up
+        std::vector<int> ids = S.db->reserveAccountIds(S.cOpenCount == 2 ? 2 : 1);
+        if (ids.empty()) { S.ShowToast("No free account numbers."); return; }
+
         // Checking
         {
-            int accNum = S.db.generateUniqueAccountId();
-            Account acc(accNum, "Checking", 0.0);
+            Account acc(ids[0], AccountType::Checking, Money(0, EUR));
             cust.addAccount(acc);
         }
 
         // Savings (optional)
-        if (S.cOpenCount == 2) {
-            int acc2 = S.db.generateUniqueAccountId();
-            Account sav(acc2, "Savings", 0.0);
+        if (ids.size() == 2) {
+            Account sav(ids[1], AccountType::Savings, Money(0, EUR));
             sav.setSavingsRate(DEFAULT_SAVINGS_RATE);
-            sav.setLastSavedDate(AppSession::todayDate());
+            sav.setLastSaved(AppSession::todayDate());
             cust.addAccount(sav);
         }
 
-        S.db.addOrUpdateCustomer(cust);
+        S.db->addOrUpdateCustomer(cust);
         S.current = cust;
         S.tab = AppTab::Home;
         S.hideBalances = true;
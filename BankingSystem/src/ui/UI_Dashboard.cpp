@@ -1,78 +1,42 @@
 #include "AppSession.h"
+#include "Profiler.h"
 #include "imgui.h"
 #include "imgui_stdlib.h"
 
 #include <vector>
 #include <string>
-#include <sstream>
-#include <cstdio>
+#include <cstdint>
 #include <cstdlib>
-#include <iomanip>
-#include <cmath>
+#include <algorithm>
 
 // --------- Rates config (top-10) ---------
 static const char* FX_LIST[] = {"USD","GBP","JPY","CHF","CAD","AUD","NZD","SEK","NOK","CNY"};
 static const int FX_N = (int)(sizeof(FX_LIST)/sizeof(FX_LIST[0]));
 
-static std::string joinSymbolsCSV() {
-    std::string s;
-    for (int i = 0; i < FX_N; ++i) {
-        if (i) s += ",";
-        s += FX_LIST[i];
-    }
-    return s;
-}
+// Rates are polled off the render thread (see RateService); here we only read snapshots
+static void ensureRateService(AppSession& S) {
+    if (S.rateService) return;
 
-// Minimal fetch via curl (Frankfurter)
-static bool fetchRatesEUR(AppSession& S) {
-    std::string symbols = joinSymbolsCSV();
-    std::string url = "https://api.frankfurter.app/latest?from=EUR&to=" + symbols;
-
-    std::string cmd = "curl -s \"" + url + "\"";
-    FILE* pipe = popen(cmd.c_str(), "r");
-    if (!pipe) { S.exLastError = "Failed to run curl."; return false; }
-
-    std::string data;
-    char buffer[4096];
-    while (fgets(buffer, sizeof(buffer), pipe)) data += buffer;
-    int rc = pclose(pipe);
-    (void)rc;
-
-    try {
-        auto j = json::parse(data);
-        if (!j.contains("rates") || !j["rates"].is_object()) {
-            S.exLastError = "Rates payload invalid.";
-            return false;
-        }
-        S.exRates.clear();
-        for (auto it = j["rates"].begin(); it != j["rates"].end(); ++it) {
-            S.exRates[it.key()] = it.value().get<double>();
-        }
-        S.exLastError.clear();
-        return true;
-    } catch (...) {
-        S.exLastError = "Failed to parse rates JSON.";
-        return false;
-    }
+    std::vector<std::string> symbols(FX_LIST, FX_LIST + FX_N);
+    const char* spec = std::getenv("BANKING_FX_SOURCE");
+    RateServiceOptions opt;
+    opt.onPublish = S.wakeUi;   // new rates -> redraw even if the window is idle
+    S.rateService = std::make_shared<RateService>(makeRateSource(spec ? spec : "curl", symbols), opt);
+    S.rateService->start();
 }
 
-static std::string moneyStr(double x, bool hide) {
-    if (hide) return "HIDDEN"; // ASCII-only (no ????)
-    std::ostringstream ss;
-    ss << std::fixed << std::setprecision(2) << x;
-    return ss.str();
+static double rateFor(const RateSnapshot& snap, const std::string& cur) {
+    auto it = snap.rates.find(cur);
+    return it != snap.rates.end() ? it->second : 0.0;
 }
 
-// Pick destination account for name-transfer: prefer Checking else first
-static int pickDestAccountIndex(const Customer& c) {
-    const auto& accs = c.getAccounts();
-    for (int i = 0; i < (int)accs.size(); ++i)
-        if (accs[i].getType() == "Checking") return i;
-    return accs.empty() ? -1 : 0;
+static std::string moneyStr(const Money& x, bool hide) {
+    if (hide) return "HIDDEN"; // ASCII-only (no ????)
+    return x.toString();
 }
 
 static void drawToast(AppSession& S) {
-    if (!S.toast.empty() && ImGui::GetTime() - S.toast_t < 4.0) {
+    if (!S.toast.empty() && ImGui::GetTime() - S.toast_t < AppSession::TOAST_SECONDS) {
         ImGui::Separator();
         ImGui::TextColored(ImVec4(0.2f,0.9f,0.2f,1), "%s", S.toast.c_str());
     }
@@ -80,6 +44,7 @@ static void drawToast(AppSession& S) {
 
 // ---------------- Home ----------------
 static void DrawHome(AppSession& S) {
+    PROF_SCOPE("UI: DrawHome");
     ImGui::SeparatorText("Home");
 
     // Greeting (FIRST+LAST)
@@ -97,17 +62,18 @@ static void DrawHome(AppSession& S) {
     for (int i = 0; i < (int)accs.size(); ++i) {
         auto& a = accs[i];
 
-        std::string title = "#" + std::to_string(a.getId()) + "  " + a.getType();
-        if (a.getType() == "FX" && !a.getCurrency().empty()) title += " (" + a.getCurrency() + ")";
+        const bool fx = a.getType() == AccountType::FX && !a.getCurrency().empty();
+        std::string title = "#" + std::to_string(a.getId()) + "  " + a.getTypeName();
+        if (fx) title += " (" + a.getCurrency().str() + ")";
 
         if (ImGui::Selectable(title.c_str(), S.selectedAccIdx == i)) S.selectedAccIdx = i;
 
         ImGui::SameLine(420);
         std::string balLabel;
-        if (a.getType() == "FX" && !a.getCurrency().empty()) {
+        if (fx) {
             balLabel = S.hideBalances
                 ? "balance hidden"
-                : (moneyStr(a.getBalance(), false) + " " + a.getCurrency());
+                : (moneyStr(a.getBalance(), false) + " " + a.getCurrency().str());
         } else {
             balLabel = S.hideBalances
                 ? "balance hidden"
@@ -130,46 +96,39 @@ static void DrawHome(AppSession& S) {
         ImGui::SeparatorText("Deposit / Withdraw");
         ImGui::InputDouble("Amount", &S.qaAmount, 0, 0, "%.2f");
 
-        if (ImGui::Button("Deposit##qa")) {
-            if (S.qaAmount <= 0) S.ShowToast("Invalid amount.");
+        // amount is typed in the account currency
+        Money amount = Money::fromMajor(S.qaAmount, a.getBalance().currency());
+
+        // through the ledger (or the server), then the balances are re-read
+        auto move = [&](bool deposit) {
+            std::string err;
+            if (!amount.isPositive()) S.ShowToast("Invalid amount.");
+            else if (!S.depositOrWithdraw(deposit, a.getId(), amount, err)) S.ShowToast(err);
             else {
-                a.setBalance(a.getBalance() + S.qaAmount);
-                S.db.addOrUpdateCustomer(S.current);
-                S.ShowToast("Deposit successful.");
+                S.reloadCurrent();
+                S.ShowToast(deposit ? "Deposit successful." : "Withdrawal successful.");
             }
-        }
+        };
+        if (ImGui::Button("Deposit##qa")) move(true);
         ImGui::SameLine();
-        if (ImGui::Button("Withdraw##qa")) {
-            if (S.qaAmount <= 0) S.ShowToast("Invalid amount.");
-            else if (S.qaAmount > a.getBalance()) S.ShowToast("Insufficient funds.");
-            else {
-                a.setBalance(a.getBalance() - S.qaAmount);
-                S.db.addOrUpdateCustomer(S.current);
-                S.ShowToast("Withdrawal successful.");
-            }
-        }
+        if (ImGui::Button("Withdraw##qa")) move(false);
     }
 }
 
 // ---------------- Exchange ----------------
 static void DrawExchange(AppSession& S) {
+    PROF_SCOPE("UI: DrawExchange");
     ImGui::SeparatorText("Exchange");
 
-    // Poll rates: on start + every 5 seconds
-    double nowT = ImGui::GetTime();
-    if (S.exLastFetchT < 0.0) {
-        fetchRatesEUR(S);
-        S.exLastFetchT = nowT;
-        S.exNextPollT = nowT + 5.0;
-    } else if (nowT >= S.exNextPollT) {
-        fetchRatesEUR(S);
-        S.exLastFetchT = nowT;
-        S.exNextPollT = nowT + 5.0;
-    }
+    // Non-blocking: the worker publishes, we just grab the latest snapshot
+    ensureRateService(S);
+    std::shared_ptr<const RateSnapshot> snap = S.rateService->snapshot();
 
     ImGui::Text("Base currency: EUR");
-    if (!S.exLastError.empty()) {
-        ImGui::TextColored(ImVec4(1,0.3f,0.3f,1), "Rates error: %s", S.exLastError.c_str());
+    if (!snap->error.empty()) {
+        ImGui::TextColored(ImVec4(1,0.3f,0.3f,1), "Rates error: %s", snap->error.c_str());
+    } else if (snap->version == 0) {
+        ImGui::TextDisabled("Fetching rates...");
     } else {
         ImGui::Text("Rates updated every 5 seconds (reference rates).");
     }
@@ -177,7 +136,7 @@ static void DrawExchange(AppSession& S) {
     ImGui::SeparatorText("Top-10 rates (EUR -> X)");
     for (int i = 0; i < FX_N; ++i) {
         const char* cur = FX_LIST[i];
-        double r = S.exRates.count(cur) ? S.exRates[cur] : 0.0;
+        double r = rateFor(*snap, cur);
         if (r > 0.0) ImGui::BulletText("EUR/%s = %.6f", cur, r);
         else ImGui::BulletText("EUR/%s = N/A", cur);
     }
@@ -186,17 +145,21 @@ static void DrawExchange(AppSession& S) {
     auto& accs = S.current.getAccounts();
     bool hasAnyFX = false;
     for (auto& a : accs) {
-        if (a.getType() == "FX") {
+        if (a.getType() == AccountType::FX) {
             hasAnyFX = true;
 
             std::string label = "#" + std::to_string(a.getId()) +
-                                " FX (" + a.getCurrency() + ")";
+                                " FX (" + a.getCurrency().str() + ")";
             if (S.hideBalances) label += " — balance hidden";
-            else label += " — " + moneyStr(a.getBalance(), false) + " " + a.getCurrency();
+            else label += " — " + moneyStr(a.getBalance(), false) + " " + a.getCurrency().str();
 
             ImGui::BulletText("%s", label.c_str());
         }
     }
+    if (S.remote()) {
+        ImGui::TextDisabled("Opening FX accounts and exchanging are not available in server mode.");
+        return;
+    }
     if (!hasAnyFX) ImGui::TextDisabled("No currency accounts yet. Open one below.");
 
     ImGui::SeparatorText("Open a currency account (only here)");
@@ -231,19 +194,26 @@ static void DrawExchange(AppSession& S) {
     ImGui::InputDouble("Amount", &S.exAmount, 0, 0, "%.2f");
 
     std::string cur = FX_LIST[S.exTargetIdx];
-    double rate = S.exRates.count(cur) ? S.exRates[cur] : 0.0;
+    double rate = rateFor(*snap, cur);
 
     if (rate <= 0) {
         ImGui::TextDisabled("Rate unavailable for %s (wait next update).", cur.c_str());
         return;
     }
 
+    // Customer receives the converted amount rounded down to the minor unit
+    const CurrencyCode fxCur = CurrencyCode::fromString(cur);
+    Money pay = (S.exDirection == 0) ? Money::fromMajor(S.exAmount, EUR)
+                                     : Money::fromMajor(S.exAmount, fxCur);
+    Money receive = (S.exDirection == 0) ? pay.convert(rate, fxCur, RoundingMode::Down)
+                                         : pay.convert(1.0 / rate, EUR, RoundingMode::Down);
+
     if (S.exDirection == 0) {
-        double fx = S.exAmount * rate;
-        ImGui::Text("You pay: %.2f EUR  ->  You receive: %.2f %s", S.exAmount, fx, cur.c_str());
+        ImGui::Text("You pay: %s EUR  ->  You receive: %s %s",
+                    pay.toString().c_str(), receive.toString().c_str(), cur.c_str());
     } else {
-        double eur = (rate > 0) ? (S.exAmount / rate) : 0.0;
-        ImGui::Text("You pay: %.2f %s  ->  You receive: %.2f EUR", S.exAmount, cur.c_str(), eur);
+        ImGui::Text("You pay: %s %s  ->  You receive: %s EUR",
+                    pay.toString().c_str(), cur.c_str(), receive.toString().c_str());
     }
 
     if (ImGui::Button("Exchange")) {
@@ -253,31 +223,95 @@ static void DrawExchange(AppSession& S) {
         int fxIdx = S.findFXIndexByCurrency(cur);
         if (fxIdx < 0) { S.ShowToast("Open FX account for " + cur + " first."); return; }
 
-        Account& checking = S.current.getAccounts()[chkIdx];
-        Account& fxAcc    = S.current.getAccounts()[fxIdx];
+        const Account& checking = S.current.getAccounts()[chkIdx];
+        const Account& fxAcc    = S.current.getAccounts()[fxIdx];
 
-        if (S.exAmount <= 0) { S.ShowToast("Invalid amount."); return; }
+        if (!pay.isPositive()) { S.ShowToast("Invalid amount."); return; }
 
-        if (S.exDirection == 0) {
-            if (checking.getBalance() < S.exAmount) { S.ShowToast("Insufficient EUR in Checking."); return; }
-            double fx = S.exAmount * rate;
-            checking.setBalance(checking.getBalance() - S.exAmount);
-            fxAcc.setBalance(fxAcc.getBalance() + fx);
-            S.db.addOrUpdateCustomer(S.current);
-            S.ShowToast("Exchange complete (EUR -> " + cur + ").");
-        } else {
-            if (fxAcc.getBalance() < S.exAmount) { S.ShowToast("Insufficient FX balance."); return; }
-            double eur = S.exAmount / rate;
-            fxAcc.setBalance(fxAcc.getBalance() - S.exAmount);
-            checking.setBalance(checking.getBalance() + eur);
-            S.db.addOrUpdateCustomer(S.current);
-            S.ShowToast("Exchange complete (" + cur + " -> EUR).");
+        // both legs in one transaction; balances are then re-read from the DB
+        const bool buy = S.exDirection == 0;
+        const Account& payFrom = buy ? checking : fxAcc;
+        const Account& payTo   = buy ? fxAcc : checking;
+        if (payFrom.getBalance() < pay) {
+            S.ShowToast(buy ? "Insufficient EUR in Checking." : "Insufficient FX balance.");
+            return;
+        }
+
+        std::string err;
+        if (!S.db->beginTransaction().debit(payFrom.getId(), pay).credit(payTo.getId(), receive).commit(&err)) {
+            S.ShowToast("Exchange failed: " + err);
+            return;
         }
+        S.reloadCurrent();
+        S.ShowToast(buy ? "Exchange complete (EUR -> " + cur + ")."
+                        : "Exchange complete (" + cur + " -> EUR).");
     }
 }
 
 // ---------------- Transfers ----------------
+// Rows are decoded once per (customer, filter, log version); per frame only the
+// rows inside the clipper's visible range are formatted.
+static void drawTransferHistory(AppSession& S, int daysBack) {
+    PROF_SCOPE("UI: drawTransferHistory");
+    TransferHistoryCache& H = S.trHistory;
+
+    const long long sinceTs = DatabaseManager::sinceTsForDaysBack(daysBack);
+    const long long sinceMinute = sinceTs / 60000;
+    const std::uint64_t version = S.transfersVersion();
+
+    if (H.customerId != S.current.getId() || H.filter != S.trHistoryFilter ||
+        H.sinceMinute != sinceMinute || H.logVersion != version) {
+        H.customerId = S.current.getId();
+        H.filter = S.trHistoryFilter;
+        H.sinceMinute = sinceMinute;
+        H.logVersion = version;
+        H.rows = S.transferHistory(H.customerId, daysBack, &H.complete);
+    }
+
+    if (!H.complete)
+        ImGui::TextColored(ImVec4(1,0.8f,0.3f,1), "History is incomplete: the server stopped answering. Press Refresh.");
+    if (H.rows.empty()) {
+        if (H.complete) ImGui::TextDisabled("No transfers yet.");
+        return;
+    }
+    ImGui::Text("%d transfer(s)", (int)H.rows.size());
+
+    // leave room for the toast + bottom tabs
+    float h = ImGui::GetContentRegionAvail().y - ImGui::GetFrameHeightWithSpacing() * 3.0f;
+    ImGuiTableFlags flags = ImGuiTableFlags_ScrollY | ImGuiTableFlags_RowBg |
+                            ImGuiTableFlags_BordersInnerV | ImGuiTableFlags_Resizable;
+    if (!ImGui::BeginTable("##history", 6, flags, ImVec2(0.0f, std::max(h, 120.0f)))) return;
+
+    ImGui::TableSetupScrollFreeze(0, 1);
+    ImGui::TableSetupColumn("Status");
+    ImGui::TableSetupColumn("Amount (EUR)");
+    ImGui::TableSetupColumn("From -> To");
+    ImGui::TableSetupColumn("Mode");
+    ImGui::TableSetupColumn("Target");
+    ImGui::TableSetupColumn("Error");
+    ImGui::TableHeadersRow();
+
+    ImGuiListClipper clipper;
+    clipper.Begin((int)H.rows.size());
+    while (clipper.Step()) {
+        for (int i = clipper.DisplayStart; i < clipper.DisplayEnd; ++i) {
+            const TransferRecord& e = H.rows[i];
+            ImVec4 col = (e.status == "ok") ? ImVec4(0.2f,0.9f,0.2f,1) : ImVec4(1,0.3f,0.3f,1);
+
+            ImGui::TableNextRow();
+            ImGui::TableNextColumn(); ImGui::TextColored(col, "%s", e.status.c_str());
+            ImGui::TableNextColumn(); ImGui::TextUnformatted(e.amount.toString().c_str());
+            ImGui::TableNextColumn(); ImGui::Text("#%d -> #%d", e.fromAccId, e.toAccId);
+            ImGui::TableNextColumn(); ImGui::TextUnformatted(e.mode.c_str());
+            ImGui::TableNextColumn(); ImGui::TextUnformatted(e.target.c_str());
+            ImGui::TableNextColumn(); ImGui::TextUnformatted(e.error.c_str());
+        }
+    }
+    ImGui::EndTable();
+}
+
 static void DrawTransfers(AppSession& S) {
+    PROF_SCOPE("UI: DrawTransfers");
     ImGui::SeparatorText("Transfers");
 
     if (ImGui::Button("Make a Transfer")) S.trSubPage = 0;
@@ -302,36 +336,18 @@ static void DrawTransfers(AppSession& S) {
         ImGui::RadioButton("Today", &S.trHistoryFilter, 0); ImGui::SameLine();
         ImGui::RadioButton("Last 7 days", &S.trHistoryFilter, 1); ImGui::SameLine();
         ImGui::RadioButton("All", &S.trHistoryFilter, 2);
+        if (S.remote()) {
+            // чужие переводы к нам сервер не присылает
+            ImGui::SameLine();
+            if (ImGui::Button("Refresh")) ++S.serverLogGen;
+        }
 
         int daysBack = 0;
         if (S.trHistoryFilter == 0) daysBack = 1;
         else if (S.trHistoryFilter == 1) daysBack = 7;
         else daysBack = 0;
 
-        auto items = S.db.getTransfersForCustomer(S.current.getId(), daysBack);
-        if (items.empty()) {
-            ImGui::TextDisabled("No transfers yet.");
-            return;
-        }
-
-        for (const auto& e : items) {
-            std::string status = e.value("status", "");
-            std::string mode = e.value("mode", "");
-            double amount = e.value("amount", 0.0);
-            int fromAcc = e.value("fromAccId", 0);
-            int toAcc = e.value("toAccId", 0);
-            std::string target = e.value("target", "");
-            std::string error = e.value("error", "");
-
-            ImVec4 col = (status == "ok") ? ImVec4(0.2f,0.9f,0.2f,1) : ImVec4(1,0.3f,0.3f,1);
-
-            ImGui::TextColored(col, "%s | %.2f EUR | from #%d -> #%d | %s",
-                status.c_str(), amount, fromAcc, toAcc, mode.c_str());
-
-            if (!target.empty()) ImGui::Text("Target: %s", target.c_str());
-            if (!error.empty()) ImGui::Text("Error: %s", error.c_str());
-            ImGui::Separator();
-        }
+        drawTransferHistory(S, daysBack);
         return;
     }
 
@@ -342,7 +358,7 @@ static void DrawTransfers(AppSession& S) {
     std::vector<int> checkingIdx;
     std::vector<std::string> labels;
     for (int i = 0; i < (int)accs.size(); ++i) {
-        if (accs[i].getType() == "Checking") {
+        if (accs[i].getType() == AccountType::Checking) {
             checkingIdx.push_back(i);
             labels.push_back("#" + std::to_string(accs[i].getId()) + " Checking");
         }
@@ -369,15 +385,38 @@ static void DrawTransfers(AppSession& S) {
         ImGui::InputInt("Destination Account ID", &S.trDestAccId);
     } else {
         ImGui::InputText("First name", &S.trFirstName);
+        bool committed = ImGui::IsItemDeactivatedAfterEdit();
         ImGui::InputText("Last name", &S.trLastName);
+        committed |= ImGui::IsItemDeactivatedAfterEdit();
+
+        // look up once a field is left / Enter is pressed, not per keystroke:
+        // in server mode every lookup is a round-trip on this thread. Send resolves again.
+        const std::string key = S.trFirstName + '\x1f' + S.trLastName;
+        if (committed && key != S.trNameKey) {
+            S.trNameKey = key;
+            S.trNameMatches = S.findCustomersByName(S.trFirstName, S.trLastName);
+            S.trNamePick = 0;
+        }
+        if (key == S.trNameKey && S.trNameMatches.size() > 1) {
+            std::vector<std::string> who;
+            for (const auto& id : S.trNameMatches)
+                who.push_back("Customer ..." + id.substr(id.size() > 4 ? id.size() - 4 : 0));
+            std::vector<const char*> whoC;
+            for (auto& w : who) whoC.push_back(w.c_str());
+            ImGui::TextColored(ImVec4(1,0.8f,0.3f,1), "%d customers with this name.", (int)who.size());
+            ImGui::Combo("Recipient", &S.trNamePick, whoC.data(), (int)whoC.size());
+        }
     }
     ImGui::InputDouble("Amount (EUR)", &S.trAmount, 0, 0, "%.2f");
 
     if (ImGui::Button("Send")) {
+        const Money amount = Money::fromMajor(S.trAmount, EUR);
+
         auto logBase = json::object();
         logBase["fromCustomerId"] = S.current.getId();
         logBase["fromAccId"] = S.current.getAccounts()[fromIdx].getId();
-        logBase["amount"] = S.trAmount;
+        logBase["amountMinor"] = amount.minorUnits();
+        logBase["amount"] = amount.toMajor();
         logBase["mode"] = (S.trMode == 0) ? "by_account_id" : "by_name";
 
         auto fail = [&](const std::string& err, const std::string& target){
@@ -387,14 +426,14 @@ static void DrawTransfers(AppSession& S) {
             e["target"] = target;
             e["toCustomerId"] = "";
             e["toAccId"] = 0;
-            S.db.appendTransferLog(e);
+            S.logFailedTransfer(e);
             S.ShowToast(err);
         };
 
-        if (S.trAmount <= 0) { fail("Invalid amount.", ""); return; }
+        if (!amount.isPositive()) { fail("Invalid amount.", ""); return; }
 
-        Account& fromAcc = S.current.getAccounts()[fromIdx];
-        if (fromAcc.getBalance() < S.trAmount) { fail("Insufficient funds.", ""); return; }
+        const Account& fromAcc = S.current.getAccounts()[fromIdx];
+        if (fromAcc.getBalance() < amount) { fail("Insufficient funds.", ""); return; }
 
         std::string destCustId;
         int destAccId = 0;
@@ -404,58 +443,54 @@ static void DrawTransfers(AppSession& S) {
             if (S.trDestAccId <= 0) { fail("Enter destination Account ID.", ""); return; }
             targetLabel = std::to_string(S.trDestAccId);
 
-            // search in DB
-            json all; S.db.loadAll(all);
-            const json& custs = all.contains("customers") ? all["customers"] : all;
-
-            bool found = false;
-            for (auto it = custs.begin(); it != custs.end() && !found; ++it) {
-                auto& cj = it.value();
-                if (!cj.contains("accounts")) continue;
-                for (auto& a : cj["accounts"]) {
-                    if (a.value("accId", 0) == S.trDestAccId) {
-                        found = true; destCustId = it.key(); destAccId = S.trDestAccId; break;
-                    }
-                }
+            destAccId = S.trDestAccId;
+            if (!S.remote()) {   // сервер проверит счёт при переводе
+                AccountLocation loc;
+                if (!S.db->findAccountOwner(S.trDestAccId, loc)) { fail("Destination account not found.", targetLabel); return; }
+                destCustId = loc.customerId;
             }
-            if (!found) { fail("Destination account not found.", targetLabel); return; }
 
         } else {
             targetLabel = S.trFirstName + " " + S.trLastName;
             if (S.trFirstName.empty() || S.trLastName.empty()) { fail("Enter first and last name.", targetLabel); return; }
 
-            if (!S.db.findCustomerByName(S.trFirstName, S.trLastName, destCustId)) {
-                fail("Recipient not found.", targetLabel);
-                return;
+            // resolve again: the list on screen may be stale
+            std::vector<std::string> matches = S.findCustomersByName(S.trFirstName, S.trLastName);
+            if (matches.empty()) { fail("Recipient not found.", targetLabel); return; }
+            S.trNameKey = S.trFirstName + '\x1f' + S.trLastName;
+            if (matches != S.trNameMatches) {
+                S.trNameMatches = matches;
+                S.trNamePick = 0;
+                if (matches.size() > 1) { S.ShowToast("Several customers with this name, pick the recipient."); return; }
             }
+            if (S.trNamePick < 0 || S.trNamePick >= (int)matches.size()) S.trNamePick = 0;
+            destCustId = matches[S.trNamePick];
 
-            Customer destCust;
-            if (!S.db.loadCustomer(destCustId, destCust)) { fail("Failed to load recipient.", targetLabel); return; }
-            int idxPick = pickDestAccountIndex(destCust);
-            if (idxPick < 0) { fail("Recipient has no accounts.", targetLabel); return; }
-            destAccId = destCust.getAccounts()[idxPick].getId();
+            CurrencyCode destCurrency;
+            std::string err;
+            if (!S.recipientAccount(destCustId, destAccId, destCurrency, err)) { fail(err, targetLabel); return; }
+            if (destCurrency != EUR) { fail("Destination account is not in EUR.", targetLabel); return; }
         }
 
-        // perform transfer
-        Customer destCust;
-        if (!S.db.loadCustomer(destCustId, destCust)) { fail("Failed to load recipient.", targetLabel); return; }
-
-        int destIdx = AppSession::findAccountIndexById(destCust.getAccounts(), destAccId);
-        if (destIdx < 0) { fail("Destination account vanished.", targetLabel); return; }
+        // perform transfer (by id, local: the recipient is checked here; the server checks it itself)
+        if (S.trMode == 0 && !destCustId.empty()) {
+            Customer destCust;
+            if (!S.loadCustomer(destCustId, destCust)) { fail("Failed to load recipient.", targetLabel); return; }
 
-        fromAcc.setBalance(fromAcc.getBalance() - S.trAmount);
-        destCust.getAccounts()[destIdx].setBalance(destCust.getAccounts()[destIdx].getBalance() + S.trAmount);
+            int destIdx = AppSession::findAccountIndexById(destCust.getAccounts(), destAccId);
+            if (destIdx < 0) { fail("Destination account vanished.", targetLabel); return; }
 
-        S.db.addOrUpdateCustomer(S.current);
-        S.db.addOrUpdateCustomer(destCust);
+            const Account& destAcc = destCust.getAccounts()[destIdx];
+            if (destAcc.getBalance().currency() != EUR) { fail("Destination account is not in EUR.", targetLabel); return; }
+        }
 
+        // debit + credit + log entry: one ledger posting, one write
         json ok = logBase;
-        ok["status"] = "ok";
-        ok["error"] = "";
         ok["target"] = targetLabel;
-        ok["toCustomerId"] = destCustId;
-        ok["toAccId"] = destAccId;
-        S.db.appendTransferLog(ok);
+        std::string err;
+        // отказ S.transfer уже записал в историю (локально или на сервере)
+        if (!S.transfer(fromAcc.getId(), destAccId, amount, ok, err)) { S.ShowToast(err); return; }
+        S.reloadCurrent();
 
         S.ShowToast("Transfer successful.");
     }
@@ -463,6 +498,7 @@ static void DrawTransfers(AppSession& S) {
 
 // ---------------- Deals ----------------
 static void DrawDeals(AppSession& S) {
+    PROF_SCOPE("UI: DrawDeals");
     (void)S;
     ImGui::SeparatorText("Deals");
     ImGui::TextWrapped("Demo offers (no real integration):");
@@ -478,6 +514,7 @@ static void DrawDeals(AppSession& S) {
 
 // ---------------- Settings ----------------
 static void DrawSettings(AppSession& S) {
+    PROF_SCOPE("UI: DrawSettings");
     ImGui::SeparatorText("Settings");
 
     ImGui::Text("Profile");
@@ -489,16 +526,20 @@ static void DrawSettings(AppSession& S) {
     ImGui::SeparatorText("Privacy");
     ImGui::Checkbox("Hide balances (global)", &S.hideBalances);
 
+    ImGui::SeparatorText("Display");
+    ImGui::Checkbox("Power saving (redraw only on input or updates)", &S.powerSave);
+
     ImGui::SeparatorText("Security");
     static std::string oldS, newS;
     ImGui::InputText("Old secret", &oldS, ImGuiInputTextFlags_Password);
     ImGui::InputText("New secret", &newS, ImGuiInputTextFlags_Password);
 
     if (ImGui::Button("Change secret")) {
-        if (oldS.empty() || newS.empty()) S.ShowToast("Fill both fields.");
-        else if (S.db.changeSecret(S.current.getId(), oldS, newS)) {
+        if (S.remote()) S.ShowToast("Not available in server mode.");
+        else if (oldS.empty() || newS.empty()) S.ShowToast("Fill both fields.");
+        else if (S.db->changeSecret(S.current.getId(), oldS, newS)) {
             S.current.setSecretWord(newS);
-            S.db.addOrUpdateCustomer(S.current);
+            S.db->addOrUpdateCustomer(S.current);
             oldS.clear(); newS.clear();
             S.ShowToast("Secret updated.");
         } else {
@@ -508,9 +549,7 @@ static void DrawSettings(AppSession& S) {
 
     ImGui::SeparatorText("Session");
     if (ImGui::Button("Logout")) {
-        S.db.addOrUpdateCustomer(S.current);
-        AppSession fresh;
-        S = fresh;
+        S.logout();
         S.ShowToast("Logged out.");
     }
 }
@@ -530,6 +569,7 @@ static void DrawBottomTabs(AppSession& S) {
 }
 
 void DrawDashboard(AppSession& S) {
+    PROF_SCOPE("UI: DrawDashboard");
     ImGui::Text("ABC Banking  |  Logged in: %s", S.current.getFullName().c_str());
     ImGui::Separator();
 
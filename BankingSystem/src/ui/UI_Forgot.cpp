@@ -1,10 +1,18 @@
 #include "AppSession.h"
+#include "Profiler.h"
 #include "imgui.h"
 #include "imgui_stdlib.h"
 
 void DrawForgot(AppSession& S) {
+    PROF_SCOPE("UI: DrawForgot");
     ImGui::SeparatorText("Reset secret word");
 
+    if (S.remote()) {
+        ImGui::TextWrapped("Secret reset is not available in server mode (BANKING_SERVER).");
+        if (ImGui::Button("Back")) S.page = Page::MainMenu;
+        return;
+    }
+
     ImGui::InputText("Customer ID", &S.fId);
     ImGui::InputText("Email", &S.fEmail);
     ImGui::InputText("New secret word", &S.fNewSecret, ImGuiInputTextFlags_Password);
@@ -12,7 +20,7 @@ void DrawForgot(AppSession& S) {
     if (ImGui::Button("Reset")) {
         if (!AppSession::validateID(S.fId) || !AppSession::validateEmail(S.fEmail) || S.fNewSecret.empty()) {
             S.fMsg = "Please fill fields correctly.";
-        } else if (S.db.resetSecretWithEmail(S.fId, S.fEmail, S.fNewSecret)) {
+        } else if (S.db->resetSecretWithEmail(S.fId, S.fEmail, S.fNewSecret)) {
             S.fMsg = "Secret word reset successful.";
         } else {
             S.fMsg = "Reset failed. Check ID / email.";
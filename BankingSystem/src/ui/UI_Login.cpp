@@ -1,8 +1,10 @@
 #include "AppSession.h"
+#include "Profiler.h"
 #include "imgui.h"
 #include "imgui_stdlib.h"
 
 void DrawLogin(AppSession& S) {
+    PROF_SCOPE("UI: DrawLogin");
     ImGui::SeparatorText("Login");
 
     ImGui::InputTextWithHint("Customer ID", "digits only", &S.loginId);
@@ -12,32 +14,43 @@ void DrawLogin(AppSession& S) {
     if (ImGui::Button("Login")) {
         S.loginError.clear();
 
+        auto enter = [&](const Customer& loaded) {
+            S.current = loaded;
+
+            S.tab = AppTab::Home;
+            S.hideBalances = true;
+
+            S.page = Page::Dashboard;
+            S.ShowToast("Welcome back, " + S.current.getFullName() + "!");
+        };
+
         if (!AppSession::validateID(S.loginId)) {
             S.loginError = "Invalid ID format.";
-        } else if (!S.db.customerExists(S.loginId)) {
+        } else if (!S.remote() && !S.db->customerExists(S.loginId)) {
             S.loginError = "Customer not found.";
         } else if (S.loginSecret.empty()) {
             S.loginError = "Enter secret word.";
         } else if (!AppSession::validatePhone(S.loginPhone)) {
             S.loginError = "Invalid phone format.";
-        } else if (!S.db.verifySecret(S.loginId, S.loginSecret)) {
+        } else if (S.remote()) {
+            // секрет и телефон проверяет сервер
+            json r = S.serverCall({ { "op", "login" }, { "customerId", S.loginId },
+                                    { "secret", S.loginSecret }, { "phone", S.loginPhone } });
+            if (!r.value("ok", false)) S.loginError = r.value("error", "Login failed.");
+            else enter(AppSession::customerFromJson(r["customer"]));
+        } else if (!S.db->verifySecret(S.loginId, S.loginSecret)) {
             S.loginError = "Secret word mismatch.";
-        } else if (!S.db.verifyPhone(S.loginId, S.loginPhone)) {
+        } else if (!S.db->verifyPhone(S.loginId, S.loginPhone)) {
             S.loginError = "Phone mismatch.";
         } else {
+            // проценты начисляет база, как и BankService::login на сервере
             Customer loaded;
-            if (!S.db.loadCustomer(S.loginId, loaded)) {
+            if (!S.db->accrueCustomerInterest(S.loginId, AppSession::todayDate())) {
+                S.loginError = "Failed to save.";
+            } else if (!S.db->loadCustomer(S.loginId, loaded)) {
                 S.loginError = "Failed to load profile.";
             } else {
-                S.applySavingsInterestIfNeeded(loaded);
-                S.db.addOrUpdateCustomer(loaded);
-                S.current = loaded;
-
-                S.tab = AppTab::Home;
-                S.hideBalances = true;
-
-                S.page = Page::Dashboard;
-                S.ShowToast("Welcome back, " + S.current.getFullName() + "!");
+                enter(loaded);
             }
         }
     }
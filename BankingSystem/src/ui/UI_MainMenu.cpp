@@ -1,7 +1,9 @@
 #include "AppSession.h"
+#include "Profiler.h"
 #include "imgui.h"
 
 void DrawMainMenu(AppSession& S) {
+    PROF_SCOPE("UI: DrawMainMenu");
     ImGui::SeparatorText("ABC Banking");
     ImGui::TextWrapped("Welcome to the ABC Banking demo application.");
 
@@ -12,5 +14,10 @@ void DrawMainMenu(AppSession& S) {
     if (ImGui::Button("Forgot password")) S.page = Page::Forgot;
 
     ImGui::SeparatorText("Storage");
-    ImGui::Text("DB file: data/database.json");
+    if (S.remote())
+        ImGui::Text("Server (thin client): %s", S.serverAddress.c_str());
+    else if (ShardedStore::isStore(AppSession::DB_PATH))
+        ImGui::Text("DB directory (sharded): %s", AppSession::DB_PATH);
+    else
+        ImGui::Text("DB file: %s", AppSession::DB_PATH);
 }
@@ -0,0 +1,156 @@
+#include "Profiler.h"
+
+#if BANKING_PROFILER
+
+#include "imgui.h"
+
+#include <algorithm>
+#include <cstdint>
+#include <cstdio>
+#include <map>
+#include <string>
+#include <vector>
+
+// Profiler overlay (F12). Samples are drained every frame, even while the window
+// is closed, so the ring never laps and the numbers are current when it opens.
+// Scope table and averages cover the last full second.
+
+static const int FRAME_HISTORY = 240;
+static const std::uint64_t WINDOW_NS = 1000000000ull;
+
+struct ScopeStats {
+    std::uint64_t calls = 0;
+    std::uint64_t totalNs = 0;
+    std::uint64_t maxNs = 0;
+};
+
+struct ProfWindow {
+    std::map<std::string, ScopeStats> scopes;
+    int frames = 0;
+    double frameMsTotal = 0.0;
+    double frameMsMax = 0.0;
+    std::uint64_t bytesRead = 0, bytesWritten = 0, jsonParses = 0;
+};
+
+struct ProfState {
+    std::vector<prof::Sample> buf = std::vector<prof::Sample>(4096);
+    float frameMs[FRAME_HISTORY] = {};
+    int frameHead = 0;
+    std::uint64_t lastFrameNs = 0;
+    std::uint64_t windowStartNs = 0;
+    prof::Counters last{};
+    prof::Counters frame{};      // deltas of the last frame
+    ProfWindow cur, shown;
+};
+
+static ProfState P;
+
+static void collect() {
+    const std::uint64_t now = prof::nowNs();
+    if (P.lastFrameNs == 0) { P.lastFrameNs = P.windowStartNs = now; P.last = prof::counters(); }
+
+    const double ms = double(now - P.lastFrameNs) / 1e6;
+    P.lastFrameNs = now;
+    P.frameMs[P.frameHead] = (float)ms;
+    P.frameHead = (P.frameHead + 1) % FRAME_HISTORY;
+
+    for (std::size_t n; (n = prof::drain(P.buf.data(), P.buf.size())) > 0;) {
+        for (std::size_t i = 0; i < n; ++i) {
+            ScopeStats& st = P.cur.scopes[P.buf[i].name];
+            st.calls += 1;
+            st.totalNs += P.buf[i].durNs;
+            st.maxNs = std::max(st.maxNs, P.buf[i].durNs);
+        }
+        if (n < P.buf.size()) break;
+    }
+
+    const prof::Counters c = prof::counters();
+    P.frame = prof::Counters{ c.bytesRead - P.last.bytesRead, c.bytesWritten - P.last.bytesWritten,
+                              c.jsonParses - P.last.jsonParses, c.dropped - P.last.dropped };
+    P.last = c;
+
+    P.cur.frames += 1;
+    P.cur.frameMsTotal += ms;
+    P.cur.frameMsMax = std::max(P.cur.frameMsMax, ms);
+    P.cur.bytesRead += P.frame.bytesRead;
+    P.cur.bytesWritten += P.frame.bytesWritten;
+    P.cur.jsonParses += P.frame.jsonParses;
+
+    if (now - P.windowStartNs >= WINDOW_NS) {
+        P.shown = std::move(P.cur);
+        P.cur = ProfWindow();
+        P.windowStartNs = now;
+    }
+}
+
+static std::string bytesStr(double b) {
+    char out[32];
+    if (b < 1024.0)                 std::snprintf(out, sizeof(out), "%.0f B", b);
+    else if (b < 1024.0 * 1024.0)   std::snprintf(out, sizeof(out), "%.1f KiB", b / 1024.0);
+    else                            std::snprintf(out, sizeof(out), "%.2f MiB", b / (1024.0 * 1024.0));
+    return out;
+}
+
+void DrawProfilerOverlay(bool* open) {
+    collect();
+    if (!*open) return;
+
+    ImGui::SetNextWindowBgAlpha(0.85f);
+    if (!ImGui::Begin("Profiler", open, ImGuiWindowFlags_AlwaysAutoResize)) {
+        ImGui::End();
+        return;
+    }
+
+    const ProfWindow& W = P.shown;
+    const int frames = std::max(W.frames, 1);
+    const float lastMs = P.frameMs[(P.frameHead + FRAME_HISTORY - 1) % FRAME_HISTORY];
+
+    ImGui::Text("Frame: %.2f ms   avg %.2f / max %.2f ms (%d frames in 1 s)",
+                lastMs, W.frameMsTotal / frames, W.frameMsMax, W.frames);
+    float top = 0.0f;
+    for (float v : P.frameMs) top = std::max(top, v);
+    ImGui::PlotLines("##frames", P.frameMs, FRAME_HISTORY, P.frameHead, nullptr,
+                     0.0f, std::max(top, 20.0f), ImVec2(480, 70));
+
+    ImGui::SeparatorText("I/O per frame");
+    ImGui::Text("Last frame: read %s, written %s, JSON parses %llu",
+                bytesStr((double)P.frame.bytesRead).c_str(), bytesStr((double)P.frame.bytesWritten).c_str(),
+                (unsigned long long)P.frame.jsonParses);
+    ImGui::Text("1 s avg:    read %s, written %s, JSON parses %.2f",
+                bytesStr((double)W.bytesRead / frames).c_str(), bytesStr((double)W.bytesWritten / frames).c_str(),
+                (double)W.jsonParses / frames);
+
+    ImGui::SeparatorText("Scopes (last 1 s)");
+    std::vector<std::pair<const std::string*, const ScopeStats*>> rows;
+    for (const auto& kv : W.scopes) rows.emplace_back(&kv.first, &kv.second);
+    std::sort(rows.begin(), rows.end(), [](const auto& a, const auto& b) {
+        return a.second->totalNs > b.second->totalNs;
+    });
+
+    ImGuiTableFlags flags = ImGuiTableFlags_RowBg | ImGuiTableFlags_BordersInnerV | ImGuiTableFlags_SizingFixedFit;
+    if (ImGui::BeginTable("##scopes", 5, flags)) {
+        ImGui::TableSetupColumn("Scope");
+        ImGui::TableSetupColumn("Calls/frame");
+        ImGui::TableSetupColumn("Avg ms");
+        ImGui::TableSetupColumn("Max ms");
+        ImGui::TableSetupColumn("ms/frame");
+        ImGui::TableHeadersRow();
+        for (const auto& r : rows) {
+            const ScopeStats& st = *r.second;
+            ImGui::TableNextRow();
+            ImGui::TableNextColumn(); ImGui::TextUnformatted(r.first->c_str());
+            ImGui::TableNextColumn(); ImGui::Text("%.2f", (double)st.calls / frames);
+            ImGui::TableNextColumn(); ImGui::Text("%.3f", st.totalNs / 1e6 / (double)st.calls);
+            ImGui::TableNextColumn(); ImGui::Text("%.3f", st.maxNs / 1e6);
+            ImGui::TableNextColumn(); ImGui::Text("%.3f", st.totalNs / 1e6 / frames);
+        }
+        ImGui::EndTable();
+    }
+    if (rows.empty()) ImGui::TextDisabled("No instrumented calls in the last second.");
+
+    const prof::Counters c = prof::counters();
+    if (c.dropped) ImGui::TextDisabled("Dropped samples: %llu", (unsigned long long)c.dropped);
+    ImGui::End();
+}
+
+#endif
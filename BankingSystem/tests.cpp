@@ -1,4 +1,5 @@
 #include <iostream>
+#include <cstdio>
 #include <fstream>
 #include <sstream>
 #include <vector>
@@ -8,10 +9,26 @@
 #include <chrono>
 #include <iomanip>
 #include <ctime>
+#include <stdexcept>
+#include <thread>
+#include <atomic>
+#include <algorithm>
+#include <type_traits>
+#include <cstring>
 
 #include "include/Account.h"
 #include "include/Customer.h"
 #include "include/DatabaseManager.h"
+#include "include/RateProvider.h"
+#include "include/BatchProcessor.h"
+#include "include/AccountIdAllocator.h"
+#include "include/BankService.h"
+#include "include/ThreadPool.h"
+#include "include/Ledger.h"
+#include "include/CustomerStream.h"
+#include "include/Date.h"
+#include "include/Profiler.h"
+#include "include/FileSync.h"
 
 using namespace std;
 namespace fs = std::filesystem;
@@ -25,8 +42,14 @@ static void wipeDbArtifacts(const string& base) {
     fs::remove(base);
     fs::remove(base + ".bak");
     fs::remove(base + ".tmp");
+    fs::remove(base + ".wal");
+    fs::remove(base + ".wal.corrupt");
+    fs::remove(base + ".snap");
+    fs::remove(base + ".corrupt");
 }
 
+static Money eur(double x) { return Money::fromMajor(x, EUR); }
+
 static string todayISO() {
     auto now = chrono::system_clock::now();
     time_t t = chrono::system_clock::to_time_t(now);
@@ -52,7 +75,7 @@ static void test_CreateAndLoadCustomer() {
     wipeDbArtifacts(TEST_DB);
     DatabaseManager db(TEST_DB);
 
-    Customer c("Alice",30,"alice@ex.com","10000001","rose");
+    Customer c("Alice","Test",30,"alice@ex.com","10000001","rose");
     Account ch(db.generateUniqueAccountId(),"Checking",100.0);
     Account sv(db.generateUniqueAccountId(),"Savings",200.0);
     sv.setSavingsRate(0.15); sv.setLastSavedDate(todayISO());
@@ -63,7 +86,7 @@ static void test_CreateAndLoadCustomer() {
 
     Customer loaded;
     TASSERT(db.loadCustomer("10000001",loaded));
-    TASSERT(loaded.getName()=="Alice");
+    TASSERT(loaded.getFirstName()=="Alice" && loaded.getLastName()=="Test");
     TASSERT((int)loaded.getAccounts().size()==2);
     TPASS();
 }
@@ -73,22 +96,22 @@ static void test_UpdateOnlyOwnBlock() {
     wipeDbArtifacts(TEST_DB);
     DatabaseManager db(TEST_DB);
 
-    Customer a("A",20,"a@e","11111111","x");
+    Customer a("A","Test",20,"a@e","11111111","x");
     a.addAccount(Account(db.generateUniqueAccountId(),"Checking",10));
-    Customer b("B",21,"b@e","22222222","y");
+    Customer b("B","Test",21,"b@e","22222222","y");
     b.addAccount(Account(db.generateUniqueAccountId(),"Checking",20));
     TASSERT(db.addOrUpdateCustomer(a));
     TASSERT(db.addOrUpdateCustomer(b));
 
-    Customer a2("A2",22,"a2@e","11111111","x2");
+    Customer a2("A2","Test",22,"a2@e","11111111","x2");
     a2.addAccount(Account(db.generateUniqueAccountId(),"Checking",30));
     TASSERT(db.addOrUpdateCustomer(a2));
 
     Customer outA,outB;
     TASSERT(db.loadCustomer("11111111",outA));
     TASSERT(db.loadCustomer("22222222",outB));
-    TASSERT(outA.getName()=="A2");
-    TASSERT(outB.getName()=="B");
+    TASSERT(outA.getFirstName()=="A2" && outA.getLastName()=="Test");
+    TASSERT(outB.getFirstName()=="B");
     TPASS();
 }
 
@@ -96,7 +119,7 @@ static void test_UpdateOnlyOwnBlock() {
 static void test_RemoveCustomer() {
     wipeDbArtifacts(TEST_DB);
     DatabaseManager db(TEST_DB);
-    Customer c("C",33,"c@e","33333333","s");
+    Customer c("C","Test",33,"c@e","33333333","s");
     c.addAccount(Account(db.generateUniqueAccountId(),"Checking",50));
     TASSERT(db.addOrUpdateCustomer(c));
     TASSERT(db.customerExists("33333333"));
@@ -109,11 +132,11 @@ static void test_RemoveCustomer() {
 static void test_AccountCreationRule() {
     wipeDbArtifacts(TEST_DB);
     DatabaseManager db(TEST_DB);
-    Customer one("One",25,"1@e","44444444","p");
+    Customer one("One","Test",25,"1@e","44444444","p");
     one.addAccount(Account(db.generateUniqueAccountId(),"Checking",0));
     TASSERT(db.addOrUpdateCustomer(one));
 
-    Customer two("Two",26,"2@e","55555555","p");
+    Customer two("Two","Test",26,"2@e","55555555","p");
     two.addAccount(Account(db.generateUniqueAccountId(),"Checking",0));
     Account s(db.generateUniqueAccountId(),"Savings",0);
     s.setSavingsRate(0.15); s.setLastSavedDate(todayISO());
@@ -132,14 +155,14 @@ static void test_AccountCreationRule() {
 static void test_DepositWithdrawEdges() {
     wipeDbArtifacts(TEST_DB);
     Account a(10,"Checking",100.0);
-    a.deposit(-5);                 // игнор
-    TASSERT(a.getBalance()==100.0);
-    TASSERT(a.withdraw(1000.0)==false);
-    TASSERT(a.getBalance()==100.0);
-    TASSERT(a.withdraw(40.0)==true);
-    TASSERT(a.getBalance()==60.0);
-    a.deposit(0.0);
-    TASSERT(a.getBalance()==60.0);
+    a.deposit(eur(-5));            // игнор
+    TASSERT(a.getBalance()==eur(100.0));
+    TASSERT(a.withdraw(eur(1000.0))==false);
+    TASSERT(a.getBalance()==eur(100.0));
+    TASSERT(a.withdraw(eur(40.0))==true);
+    TASSERT(a.getBalance()==eur(60.0));
+    a.deposit(eur(0.0));
+    TASSERT(a.getBalance()==eur(60.0));
     TPASS();
 }
 
@@ -148,29 +171,29 @@ static void test_TransferLikeFlow() {
     wipeDbArtifacts(TEST_DB);
     DatabaseManager db(TEST_DB);
 
-    Customer from("From",29,"f@e","66666666","s");
+    Customer from("From","Test",29,"f@e","66666666","s");
     Account fromCh(db.generateUniqueAccountId(),"Checking",150.0);
     from.addAccount(fromCh);
     TASSERT(db.addOrUpdateCustomer(from));
 
-    Customer to("To",30,"t@e","77777777","s");
+    Customer to("To","Test",30,"t@e","77777777","s");
     int destId = db.generateUniqueAccountId();
     Account toAcc(destId,"Savings",5.0);
     to.addAccount(toAcc);
     TASSERT(db.addOrUpdateCustomer(to));
 
     Customer reFrom; db.loadCustomer("66666666",reFrom);
-    reFrom.getAccounts()[0].withdraw(40.0);
+    reFrom.getAccounts()[0].withdraw(eur(40.0));
     Customer reTo; db.loadCustomer("77777777",reTo);
-    reTo.getAccounts()[0].deposit(40.0);
+    reTo.getAccounts()[0].deposit(eur(40.0));
     TASSERT(db.addOrUpdateCustomer(reFrom));
     TASSERT(db.addOrUpdateCustomer(reTo));
 
     Customer cf, ct;
     db.loadCustomer("66666666",cf);
     db.loadCustomer("77777777",ct);
-    TASSERT(cf.getAccounts()[0].getBalance()==110.0);
-    TASSERT(ct.getAccounts()[0].getBalance()==45.0);
+    TASSERT(cf.getAccounts()[0].getBalance()==eur(110.0));
+    TASSERT(ct.getAccounts()[0].getBalance()==eur(45.0));
     TPASS();
 }
 
@@ -187,12 +210,12 @@ static void test_SavingsInterest() {
 
     string today = todayISO();
     int days = daysBetween(s.getLastSavedDate(), today);
-    double before = s.getBalance();
+    double before = s.getBalance().toMajor();
     if (days>0) {
         double interest = before * s.getSavingsRate() * (double(days)/365.0);
-        s.setBalance(before + interest);
+        s.setBalance(eur(before + interest));
         s.setLastSavedDate(today);
-        TASSERT(s.getBalance() > before);
+        TASSERT(s.getBalance() > eur(before));
     } else {
         TASSERT(false && "days <= 0");
     }
@@ -203,7 +226,7 @@ static void test_SavingsInterest() {
 static void test_GenerateUniqueAccountId() {
     wipeDbArtifacts(TEST_DB);
     DatabaseManager db(TEST_DB);
-    Customer x("X",40,"x@e","88888888","s");
+    Customer x("X","Test",40,"x@e","88888888","s");
     for(int id: {111111,222222,333333}) x.addAccount(Account(id,"Checking",0));
     TASSERT(db.addOrUpdateCustomer(x));
     int gen = db.generateUniqueAccountId();
@@ -216,7 +239,7 @@ static void test_ResetPassword() {
     wipeDbArtifacts(TEST_DB);
     DatabaseManager db(TEST_DB);
 
-    Customer u("U",20,"u@e","99999999","old");
+    Customer u("U","Test",20,"u@e","99999999","old");
     TASSERT(db.addOrUpdateCustomer(u));
     TASSERT(db.resetSecretWithEmail("99999999","u@e","newpass"));
     Customer out; db.loadCustomer("99999999",out);
@@ -229,7 +252,7 @@ static void test_BackupAndNoEmptyOverwrite() {
     wipeDbArtifacts(TEST_DB);
     DatabaseManager db(TEST_DB);
 
-    Customer c("B",28,"b@e","12121212","s");
+    Customer c("B","Test",28,"b@e","12121212","s");
     c.addAccount(Account(db.generateUniqueAccountId(),"Checking",1));
     TASSERT(db.addOrUpdateCustomer(c));
     c.setEmail("b2@e");
@@ -254,6 +277,1323 @@ static void test_CorruptedJsonGraceful() {
     TPASS();
 }
 
+// 12. Резидентный образ: внешние изменения файла подхватываются
+static void test_ResidentImageDetectsOutsideChanges() {
+    wipeDbArtifacts(TEST_DB);
+    DatabaseManager a(TEST_DB);
+    DatabaseManager b(TEST_DB);
+
+    Customer c("Res","Ident",40,"r@e","13131313","s");
+    c.addAccount(Account(a.generateUniqueAccountId(),"Checking",5));
+    TASSERT(a.addOrUpdateCustomer(c));
+    TASSERT(b.customerExists("13131313"));      // b перечитал файл после записи a
+
+    // правка файла "руками", мимо DatabaseManager
+    json root; TASSERT(b.loadAll(root));
+    root["customers"]["13131313"]["email"] = "outside@e";
+    {
+        ofstream out(TEST_DB, ios::trunc);
+        out << root.dump() << "\n";
+    }
+    Customer out;
+    TASSERT(a.loadCustomer("13131313",out));
+    TASSERT(out.getEmail()=="outside@e");
+    TPASS();
+}
+
+// 13. WAL: запись в журнал, восстановление, снапшот и оборванный хвост
+static void test_WalRecoveryAndCheckpoint() {
+    wipeDbArtifacts(TEST_DB);
+    DatabaseOptions opt;
+    opt.mode = StorageMode::WriteAheadLog;
+    opt.walCheckpointRecords = 4;
+
+    {
+        DatabaseManager db(TEST_DB, opt);
+        Customer c("Wal","Log",30,"w@e","14141414","s");
+        c.addAccount(Account(111222,"Checking",100.0));
+        TASSERT(db.addOrUpdateCustomer(c));
+        c.getAccounts()[0].setBalance(eur(75.0));
+        TASSERT(db.addOrUpdateCustomer(c));      // только баланс -> "balance" запись
+        json e = json::object(); e["fromCustomerId"]="14141414"; e["status"]="ok";
+        TASSERT(db.appendTransferLog(e));
+    }
+    TASSERT(fs::file_size(TEST_DB + ".wal") > 0);
+
+    // снапшот ещё пустой -> всё должно прийти из журнала
+    json snap; { ifstream in(TEST_DB); in >> snap; }
+    TASSERT(!snap["customers"].contains("14141414"));
+
+    {
+        DatabaseManager db(TEST_DB, opt);
+        Customer out;
+        TASSERT(db.loadCustomer("14141414",out));
+        TASSERT(out.getAccounts()[0].getBalance()==eur(75.0));
+        TASSERT(db.getTransfersForCustomer("14141414",0).size()==1);
+
+        out.setEmail("w2@e");
+        TASSERT(db.addOrUpdateCustomer(out));    // 4-я запись -> снапшот
+    }
+    TASSERT(fs::file_size(TEST_DB + ".wal") == 0);
+    { ifstream in(TEST_DB); in >> snap; }
+    TASSERT(snap["customers"]["14141414"]["email"]=="w2@e");
+
+    // оборванная запись в конце журнала
+    {
+        DatabaseManager db(TEST_DB, opt);
+        Customer out; TASSERT(db.loadCustomer("14141414",out));
+        out.setPhone("+35799000000");
+        TASSERT(db.addOrUpdateCustomer(out));
+    }
+    { ofstream w(TEST_DB + ".wal", ios::app); w << "{\"seq\":99,\"op\":\"rem"; }
+    {
+        DatabaseManager db(TEST_DB, opt);
+        Customer out;
+        TASSERT(db.loadCustomer("14141414",out));
+        TASSERT(out.getPhone()=="+35799000000");
+        TASSERT(fs::exists(TEST_DB + ".wal.corrupt"));
+    }
+    TPASS();
+}
+
+// 14. Индекс accId -> владелец
+static void test_FindAccountOwner() {
+    wipeDbArtifacts(TEST_DB);
+    DatabaseManager db(TEST_DB);
+
+    Customer a("Own","Er",30,"o@e","15151515","s");
+    a.addAccount(Account(400001,"Checking",1));
+    a.addAccount(Account(400002,"Savings",2));
+    TASSERT(db.addOrUpdateCustomer(a));
+
+    AccountLocation loc;
+    TASSERT(db.findAccountOwner(400002,loc));
+    TASSERT(loc.customerId=="15151515" && loc.slot==1);
+
+    // счёт 400001 закрыт, 400003 открыт
+    Customer a2("Own","Er",30,"o@e","15151515","s");
+    a2.addAccount(Account(400002,"Savings",2));
+    a2.addAccount(Account(400003,"Checking",0));
+    TASSERT(db.addOrUpdateCustomer(a2));
+    TASSERT(!db.findAccountOwner(400001,loc));
+    TASSERT(db.findAccountOwner(400002,loc) && loc.slot==0);
+    TASSERT(db.findAccountOwner(400003,loc) && loc.slot==1);
+
+    TASSERT(db.removeCustomer("15151515"));
+    TASSERT(!db.findAccountOwner(400002,loc));
+    TASSERT(db.existingAccountIds().empty());
+    TPASS();
+}
+
+// 15. История переводов: порядок по времени и постраничная выдача
+static void test_QueryTransfersPaged() {
+    wipeDbArtifacts(TEST_DB);
+    DatabaseManager db(TEST_DB);
+
+    // ts намеренно не по порядку
+    for (long long ts : {5000LL, 1000LL, 4000LL, 2000LL, 3000LL}) {
+        json e = json::object();
+        e["fromCustomerId"] = "16161616"; e["toCustomerId"] = "17171717";
+        e["amount"] = double(ts) / 1000; e["status"] = "ok"; e["ts"] = ts;
+        TASSERT(db.appendTransferLog(e));
+    }
+    uint64_t v0 = db.transfersVersion();
+    json other = json::object(); other["fromCustomerId"]="99"; other["toCustomerId"]="98"; other["ts"]=6000LL;
+    TASSERT(db.appendTransferLog(other));
+    TASSERT(db.transfersVersion() != v0);
+    uint64_t v1 = db.transfersVersion();
+    TASSERT(db.transfersVersion() == v1);        // без изменений -> кэш UI валиден
+
+    TransferPage p1 = db.queryTransfers("17171717", 0, 2);
+    TASSERT(p1.items.size()==2 && p1.hasMore);
+    TASSERT(p1.items[0].ts==5000 && p1.items[1].ts==4000);
+
+    TransferPage p2 = db.queryTransfers("17171717", 0, 2, p1.nextCursor);
+    TASSERT(p2.items.size()==2 && p2.items[0].ts==3000 && p2.items[1].ts==2000);
+
+    TransferPage p3 = db.queryTransfers("16161616", 2000, 10, p2.nextCursor);
+    TASSERT(p3.items.empty() && !p3.hasMore);
+
+    TransferPage since = db.queryTransfers("16161616", 2500, 10);
+    TASSERT(since.items.size()==3 && !since.hasMore);
+    TASSERT(since.items[2].amount==eur(3.0));
+    TPASS();
+}
+
+// 16. Money: точная арифметика, округление, совместимость со старым JSON
+static void test_MoneyArithmeticAndCompat() {
+    Money a = eur(0.1), b = eur(0.2);
+    TASSERT((a + b) == eur(0.3));                 // с double было бы 0.30000000000000004
+    TASSERT((a - b).minorUnits() == -10);
+    TASSERT(eur(1234.5).toString() == "1234.50");
+    TASSERT(Money(-5, EUR).toString() == "-0.05");
+
+    // курс: 10.00 EUR * 1.23456 = 12.3456 USD
+    CurrencyCode USD = CurrencyCode::fromString("usd");
+    TASSERT(eur(10).convert(1.23456, USD, RoundingMode::Down).minorUnits() == 1234);
+    TASSERT(eur(10).convert(1.23456, USD, RoundingMode::HalfUp).minorUnits() == 1235);
+    // JPY без копеек
+    Money jpy = eur(10).convert(161.237, CurrencyCode::fromString("JPY"), RoundingMode::Down);
+    TASSERT(jpy.minorUnits() == 1612 && jpy.toString() == "1612");
+    // банковское округление 0.5 -> к чётному
+    TASSERT(Money(5, EUR).scaled(0.5, RoundingMode::HalfEven).minorUnits() == 2);
+    TASSERT(Money(7, EUR).scaled(0.5, RoundingMode::HalfEven).minorUnits() == 4);
+
+    bool threw = false;
+    try { (void)(eur(1) + Money(1, USD)); } catch (const std::invalid_argument&) { threw = true; }
+    TASSERT(threw);
+
+    // старый файл: только double "balance"
+    wipeDbArtifacts(TEST_DB);
+    fs::create_directories("data");
+    {
+        ofstream out(TEST_DB, ios::trunc);
+        out << R"({"customers":{"18181818":{"firstName":"Old","lastName":"Fmt","accounts":[)"
+            << R"({"accId":500001,"type":"Checking","balance":19.99},)"
+            << R"({"accId":500002,"type":"FX","currency":"JPY","balance":1500.0}]}},"transfers":[]})";
+    }
+    DatabaseManager db(TEST_DB);
+    Customer c; TASSERT(db.loadCustomer("18181818",c));
+    TASSERT(c.getAccounts()[0].getBalance().minorUnits() == 1999);
+    TASSERT(c.getAccounts()[1].getBalance() == Money(1500, CurrencyCode::fromString("JPY")));
+    TASSERT(c.getAccounts()[1].getCurrency() == CurrencyCode::fromString("JPY"));
+    TPASS();
+}
+
+// 17. Курсы: фоновый сервис, файловый источник, ошибки не затирают курсы
+static void test_RateServiceFileSource() {
+    const string path = "data/test_rates.json";
+    fs::create_directories("data");
+    { ofstream out(path, ios::trunc); out << R"({"rates":{"USD":1.1,"JPY":160.5}})"; }
+
+    RateServiceOptions opt; opt.pollMs = 20; opt.maxBackoffMs = 40;
+    std::atomic<int> wakes{0};
+    opt.onPublish = [&]{ ++wakes; };   // так UI будит свой цикл ожидания
+    RateService svc(makeRateSource("file:" + path, {"USD","JPY"}), opt);
+    TASSERT(svc.snapshot()->version == 0);
+    svc.start();
+
+    auto waitFor = [&](auto pred) {
+        for (int i = 0; i < 200; ++i) {
+            if (pred(*svc.snapshot())) return true;
+            this_thread::sleep_for(chrono::milliseconds(5));
+        }
+        return false;
+    };
+    TASSERT(waitFor([](const RateSnapshot& s){ return s.rates.count("USD") && s.error.empty(); }));
+    TASSERT(svc.snapshot()->rates.at("JPY") == 160.5);
+
+    fs::remove(path);
+    TASSERT(waitFor([](const RateSnapshot& s){ return !s.error.empty(); }));
+    TASSERT(svc.snapshot()->rates.at("USD") == 1.1);   // последние удачные курсы остаются
+    svc.stop();
+    TASSERT(wakes.load() == (int)svc.snapshot()->version);   // один вызов на каждую публикацию
+    TPASS();
+}
+
+// 18. Бинарный снапшот: без потерь, устаревший .snap игнорируется
+static void test_BinarySnapshotRoundTrip() {
+    wipeDbArtifacts(TEST_DB);
+    DatabaseOptions opt; opt.binarySnapshot = true;
+    {
+        DatabaseManager db(TEST_DB, opt);
+        Customer c("Bin","Snap",33,"b@s","18181818","s");
+        c.addAccount(Account(db.generateUniqueAccountId(),"Checking",eur(12.34)));
+        TASSERT(db.addOrUpdateCustomer(c));
+        TASSERT(db.appendTransferLog({{"ts",1000},{"status","ok"},{"fromCustomerId","18181818"},
+                                      {"amountMinor",500},{"amount",5.0},{"note","extra"}}));
+    }
+    TASSERT(fs::exists(TEST_DB + ".snap"));
+
+    // .snap == JSON, включая незнакомые ключи и нестандартные типы
+    json fromJson, fromSnap;
+    { ifstream in(TEST_DB); in >> fromJson; }
+    TASSERT(BinarySnapshot::read(TEST_DB + ".snap", fromSnap));
+    TASSERT(fromSnap == fromJson);
+
+    json odd = {{"customers", {{"1", {{"name","Legacy Name"},{"age","n/a"},{"accounts", json::array()},
+                                      {"flags", {1,2}}}}}},
+                {"transfers", json::array({ {{"ts",-5},{"toAccId",5000000000LL},{"error",nullptr}} })},
+                {"walSeq", 7}};
+    TASSERT(BinarySnapshot::write(odd, SnapshotSource{}, "data/test_odd.snap"));
+    json back;
+    TASSERT(BinarySnapshot::read("data/test_odd.snap", back));
+    TASSERT(back == odd);
+    fs::remove("data/test_odd.snap");
+
+    // JSON поменяли мимо нас -> .snap не совпадает по размеру/mtime/inode и не используется
+    json root = fromJson;
+    root["customers"]["18181818"]["email"] = "changed@s";
+    {
+        ofstream out(TEST_DB, ios::trunc);
+        out << root.dump() << "\n";
+    }
+    DatabaseManager db2(TEST_DB, opt);
+    Customer out;
+    TASSERT(db2.loadCustomer("18181818",out));
+    TASSERT(out.getEmail()=="changed@s");
+    TASSERT(out.getAccounts().at(0).getBalance()==eur(12.34));
+    TPASS();
+}
+
+// 19. Пакетная обработка: CSV/JSONL, ошибки по строкам, одна запись на батч
+static void test_BatchProcessor() {
+    Money m;
+    TASSERT(Money::parse("12.5", EUR, m) && m.minorUnits()==1250);
+    TASSERT(Money::parse("-0.07", EUR, m) && m.minorUnits()==-7);
+    TASSERT(!Money::parse("1.234", EUR, m) && !Money::parse("1e3", EUR, m) && !Money::parse("", EUR, m));
+
+    wipeDbArtifacts(TEST_DB);
+    DatabaseOptions opt; opt.mode = StorageMode::WriteAheadLog;
+    DatabaseManager db(TEST_DB, opt);
+
+    Customer a("Bat","Ch",30,"a@b","19191919","s");
+    a.addAccount(Account(501001,"Checking",eur(100)));
+    a.addAccount(Account(501002,"Savings",eur(0)));
+    Customer b("Pay","Roll",40,"p@r","19191920","s");
+    b.addAccount(Account(502001,"Checking",eur(0)));
+    TASSERT(db.addOrUpdateCustomer(a) && db.addOrUpdateCustomer(b));
+    TASSERT(db.checkpoint());
+
+    istringstream csv(
+        "op,account,amount,to_account,currency,ref\n"
+        "deposit,502001,250.00,,EUR,salary-1\n"
+        "withdraw,501001,500,,,too-much\n"
+        "transfer,501001,40.5,502001,,\"rent, march\"\n"
+        "transfer,501001,10,501002,,own\n"
+        "deposit,999999,1,,,ghost\n"
+        "bogus,1,1,,,\n");
+    ostringstream res;
+    BatchProcessor proc(db);
+    BatchStats st;
+    TASSERT(proc.run(csv, BatchFormat::Csv, res, 0, st));
+    TASSERT(st.ops==6 && st.ok==3 && st.failed==3 && st.batches==1);
+    TASSERT(res.str().find("3,withdraw,too-much,failed,,Insufficient funds.") != string::npos);
+    TASSERT(res.str().find("\"rent, march\",ok,59.50") != string::npos);
+    TASSERT(fs::file_size(TEST_DB + ".wal")==0);   // весь батч ушёл одним снапшотом
+
+    DatabaseManager fresh(TEST_DB, opt);
+    Customer ra, rb;
+    TASSERT(fresh.loadCustomer("19191919",ra) && fresh.loadCustomer("19191920",rb));
+    TASSERT(ra.getAccounts()[0].getBalance()==eur(49.5));
+    TASSERT(ra.getAccounts()[1].getBalance()==eur(10));
+    TASSERT(rb.getAccounts()[0].getBalance()==eur(290.5));
+    TASSERT(fresh.getTransfersForCustomer("19191919",0).size()==2);
+
+    istringstream jsonl(R"({"op":"withdraw","account":502001,"amount":"0.50","ref":"j1"})" "\n");
+    ostringstream res2;
+    BatchStats st2;
+    TASSERT(proc.run(jsonl, BatchFormat::JsonLines, res2, 0, st2) && st2.ok==1);
+
+    // откат батча возвращает состояние с диска
+    TASSERT(db.beginBatch());
+    BatchOp op; string err;
+    TASSERT(BatchProcessor::parseLine("deposit,501001,1000", BatchFormat::Csv, op, err));
+    TASSERT(proc.apply(op).ok);
+    db.rollbackBatch();
+    Customer back;
+    TASSERT(db.loadCustomer("19191919",back));
+    TASSERT(back.getAccounts()[0].getBalance()==eur(49.5));
+    TPASS();
+}
+
+// 20. Индекс имён: однофамильцы, legacy "name", обновление при правке/удалении
+static void test_NameIndex() {
+    wipeDbArtifacts(TEST_DB);
+    {
+        json root = {{"customers", {{"20202020", {{"name","  Anna   Karenina "},{"accounts", json::array()}}}}},
+                     {"transfers", json::array()}};
+        ofstream out(TEST_DB, ios::trunc);
+        out << root.dump() << "\n";
+    }
+    DatabaseManager db(TEST_DB);
+    Customer a("anna","KARENINA",30,"a@k","20202021","s");
+    TASSERT(db.addOrUpdateCustomer(a));
+
+    auto ids = db.findCustomersByName(" Anna","karenina ");
+    TASSERT(ids.size()==2 && ids[0]=="20202020" && ids[1]=="20202021");
+    string one;
+    TASSERT(db.findCustomerByName("ANNA","Karenina",one) && one=="20202020");
+
+    a.setLastName("Vronskaya");
+    TASSERT(db.addOrUpdateCustomer(a));
+    TASSERT(db.findCustomersByName("anna","karenina").size()==1);
+    TASSERT(db.findCustomerByName("anna","vronskaya",one) && one=="20202021");
+
+    TASSERT(db.removeCustomer("20202020"));
+    TASSERT(db.findCustomersByName("anna","karenina").empty());
+    TASSERT(!db.findCustomerByName("","vronskaya",one));
+    TPASS();
+}
+
+// 21. Аллокатор id: без повторов до насыщения, расширение, резервы
+static void test_AccountIdAllocator() {
+    AccountIdAllocator ids;
+    set<int> seen;
+    for (size_t i = 0; i < ids.capacity(); ++i) {
+        int id = ids.allocate();
+        TASSERT(id >= 100000 && id <= 999999);
+        TASSERT(seen.insert(id).second);
+    }
+    TASSERT(ids.freeIds()==0 && ids.allocate()==0);
+    ids.release(123456);
+    TASSERT(ids.allocate()==123456);
+    ids.widen(7);
+    int wide = ids.allocate();
+    TASSERT(wide >= 1000000 && wide <= 9999999);
+
+    wipeDbArtifacts(TEST_DB);
+    {
+        DatabaseManager db(TEST_DB);
+        TASSERT(db.accountIdDigits()==6);
+        TASSERT(db.appendTransferLog({{"status","ok"},{"fromAccId",555555},{"toAccId",666666}}));
+        auto block = db.reserveAccountIds(3);
+        TASSERT(block.size()==3 && block[0]!=block[1] && block[1]!=block[2] && block[0]!=block[2]);
+        for (int id : block) TASSERT(id!=555555 && id!=666666);
+        TASSERT(db.setAccountIdDigits(8));
+    }
+    DatabaseManager reopened(TEST_DB);
+    TASSERT(reopened.accountIdDigits()==8);
+    DatabaseOptions narrow; narrow.accountIdDigits = 7;   // сузить нельзя
+    DatabaseManager again(TEST_DB, narrow);
+    TASSERT(again.accountIdDigits()==8);
+    TPASS();
+}
+
+// 22. CBOR / MessagePack: запись по расширению, чтение по содержимому
+static void test_BinaryEncodings() {
+    const string cborDb = "data/test_db.cbor";
+    wipeDbArtifacts(cborDb);
+    {
+        DatabaseManager db(cborDb);
+        Customer c("Cb","Or",22,"c@b","22222222","s");
+        c.addAccount(Account(db.generateUniqueAccountId(),"Checking",eur(7.25)));
+        TASSERT(db.addOrUpdateCustomer(c));
+    }
+    string bytes;
+    { ifstream in(cborDb, ios::binary); bytes.assign(istreambuf_iterator<char>(in), istreambuf_iterator<char>()); }
+    TASSERT(detectFormat(bytes)==FileFormat::Cbor);
+
+    json doc;
+    TASSERT(decodeDocument(bytes, doc));
+    TASSERT(encodeDocument(doc, FileFormat::Cbor).size() < encodeDocument(doc, FileFormat::Json).size());
+
+    // тот же документ в MessagePack под "json"-именем: формат определяется по байтам
+    wipeDbArtifacts(TEST_DB);
+    {
+        ofstream out(TEST_DB, ios::binary|ios::trunc);
+        string mp = encodeDocument(doc, FileFormat::MsgPack);
+        out.write(mp.data(), (streamsize)mp.size());
+    }
+    DatabaseOptions opt; opt.format = FileFormat::MsgPack;
+    DatabaseManager mp(TEST_DB, opt);
+    Customer back;
+    TASSERT(mp.loadCustomer("22222222",back));
+    TASSERT(back.getAccounts().at(0).getBalance()==eur(7.25));
+    TASSERT(!fs::exists(TEST_DB + ".corrupt"));
+    wipeDbArtifacts(cborDb);
+    TPASS();
+}
+
+// 23. Group commit: мутации окна одной записью, flush / durable, сброс в деструкторе
+static void test_GroupCommit() {
+    auto walLines = [](const string& path) {
+        ifstream in(path, ios::binary);
+        string all((istreambuf_iterator<char>(in)), istreambuf_iterator<char>());
+        return (size_t)count(all.begin(), all.end(), '\n');
+    };
+
+    wipeDbArtifacts(TEST_DB);
+    DatabaseOptions opt;
+    opt.mode = StorageMode::WriteAheadLog;
+    opt.commitWindowMs = 60000;   // окно закрывает только flush() / лимит операций
+    opt.commitWindowOps = 1000;
+    {
+        DatabaseManager db(TEST_DB, opt);
+        Customer a("Gc","One",30,"a@x","31313131","s");
+        Customer b("Gc","Two",30,"b@x","32323232","s");
+        a.addAccount(Account(db.generateUniqueAccountId(),"Checking",eur(100)));
+        b.addAccount(Account(db.generateUniqueAccountId(),"Checking",eur(0)));
+        TASSERT(db.addOrUpdateCustomer(a));
+        TASSERT(db.addOrUpdateCustomer(b));
+        TASSERT(db.appendTransferLog(json{{"status","ok"},{"fromCustomerId","31313131"},{"toCustomerId","32323232"}}));
+
+        // ещё в памяти: читается, но на диске журнала нет
+        TASSERT(db.customerExists("32323232"));
+        TASSERT(walLines(TEST_DB + ".wal")==0);
+        auto f = db.durable();
+        TASSERT(f.wait_for(std::chrono::milliseconds(0))!=std::future_status::ready);
+
+        TASSERT(db.flush());
+        TASSERT(f.get());
+        TASSERT(db.commitCount()==1);
+        TASSERT(walLines(TEST_DB + ".wal")==3);
+        TASSERT(db.durable().wait_for(std::chrono::milliseconds(0))==std::future_status::ready);
+
+        DatabaseOptions plain;
+        plain.mode = StorageMode::WriteAheadLog;
+        DatabaseManager other(TEST_DB, plain);
+        TASSERT(other.customerExists("32323232"));
+        TASSERT(other.getTransfersForCustomer("31313131",0).size()==1);
+    }
+
+    // лимит операций закрывает окно сам
+    opt.commitWindowOps = 2;
+    {
+        DatabaseManager db(TEST_DB, opt);
+        TASSERT(db.removeCustomer("31313131"));
+        TASSERT(db.removeCustomer("32323232"));
+        TASSERT(db.durable().get());
+        TASSERT(walLines(TEST_DB + ".wal")==5);
+    }
+
+    // окно по времени закрывается само, без flush()
+    opt.commitWindowMs = 20;
+    opt.commitWindowOps = 1000;
+    {
+        DatabaseManager db(TEST_DB, opt);
+        Customer c("Gc","Timer",30,"t@x","33333333","s");
+        TASSERT(db.addOrUpdateCustomer(c));
+        auto f = db.durable();
+        TASSERT(f.wait_for(std::chrono::seconds(5))==std::future_status::ready && f.get());
+        TASSERT(walLines(TEST_DB + ".wal")==6);
+    }
+
+    // Snapshot-режим: незаписанное окно пишется при разрушении
+    opt.commitWindowMs = 60000;
+    wipeDbArtifacts(TEST_DB);
+    opt.mode = StorageMode::Snapshot;
+    opt.commitWindowOps = 1000;
+    {
+        DatabaseManager db(TEST_DB, opt);
+        for (int i = 0; i < 10; ++i) {
+            Customer c("Gc","Snap",30,"s@x",to_string(40000000 + i),"s");
+            TASSERT(db.addOrUpdateCustomer(c));
+        }
+    }
+    DatabaseManager reopened(TEST_DB);
+    TASSERT(reopened.customerExists("40000009"));
+    TPASS();
+}
+
+// 24. Транзакции: всё или ничего, одна запись журнала, оборванная запись не применяется
+static void test_Transactions() {
+    wipeDbArtifacts(TEST_DB);
+    DatabaseOptions opt;
+    opt.mode = StorageMode::WriteAheadLog;
+    {
+        DatabaseManager db(TEST_DB, opt);
+        Customer a("Tx","A",30,"a@x","51515151","s");
+        Customer b("Tx","B",30,"b@x","52525252","s");
+        a.addAccount(Account(600001,"Checking",eur(100)));
+        a.addAccount(Account(600002,"Savings",eur(0)));
+        b.addAccount(Account(600003,"Checking",eur(10)));
+        TASSERT(db.addOrUpdateCustomer(a));
+        TASSERT(db.addOrUpdateCustomer(b));
+        TASSERT(db.checkpoint());
+
+        // третий шаг не проходит -> первые два не применяются
+        string err;
+        TASSERT(!db.beginTransaction().debit(600001, eur(30)).credit(600003, eur(30))
+                   .debit(600003, eur(500)).commit(&err));
+        TASSERT(err=="Insufficient funds.");
+        Customer back;
+        TASSERT(db.loadCustomer("51515151",back) && back.getAccounts()[0].getBalance()==eur(100));
+        TASSERT(db.loadCustomer("52525252",back) && back.getAccounts()[0].getBalance()==eur(10));
+        TASSERT(!db.beginTransaction().credit(600001, Money(100, CurrencyCode('U','S','D'))).commit(&err));
+        TASSERT(!db.beginTransaction().credit(999999, eur(1)).commit(&err));
+
+        // перевод между клиентами + на свой счёт: по одной строке журнала
+        TASSERT(db.transfer(600001, 600003, eur(25), json{{"mode","by_account_id"}}));
+        TASSERT(db.transfer(600001, 600002, eur(5)));
+        TASSERT(db.loadCustomer("51515151",back));
+        TASSERT(back.getAccounts()[0].getBalance()==eur(70));
+        TASSERT(back.getAccounts()[1].getBalance()==eur(5));
+        TASSERT(db.getTransfersForCustomer("52525252",0).at(0)["mode"]=="by_account_id");
+        TASSERT(!db.transfer(600003, 600001, eur(1000), json::object(), &err));
+    }
+
+    // журнал: 2 записи "tx"; повтор после перезапуска даёт то же состояние
+    {
+        ifstream in(TEST_DB + ".wal");
+        string line; int tx = 0;
+        while (getline(in, line)) tx += json::parse(line).value("op","")=="tx";
+        TASSERT(tx==2);
+    }
+    {
+        DatabaseManager db(TEST_DB, opt);
+        Customer back;
+        TASSERT(db.loadCustomer("52525252",back) && back.getAccounts()[0].getBalance()==eur(35));
+        TASSERT(db.getTransfersForCustomer("51515151",0).size()==2);
+    }
+
+    // оборванная последняя транзакция пропадает целиком
+    {
+        ifstream in(TEST_DB + ".wal", ios::binary);
+        string all((istreambuf_iterator<char>(in)), istreambuf_iterator<char>());
+        in.close();
+        ofstream out(TEST_DB + ".wal", ios::binary|ios::trunc);
+        out << all.substr(0, all.size() - 20);
+    }
+    {
+        DatabaseManager db(TEST_DB, opt);
+        Customer back;
+        TASSERT(db.loadCustomer("51515151",back));
+        TASSERT(back.getAccounts()[0].getBalance()==eur(75));
+        TASSERT(back.getAccounts()[1].getBalance()==eur(0));
+        TASSERT(db.getTransfersForCustomer("51515151",0).size()==1);
+    }
+    TPASS();
+}
+
+// 25. Сервер (без сокетов): запросы из пула потоков, деньги не теряются
+static void test_BankService() {
+    wipeDbArtifacts(TEST_DB);
+    DatabaseOptions opt;
+    opt.mode = StorageMode::WriteAheadLog;
+    opt.commitWindowMs = 2;
+    {
+        DatabaseManager db(TEST_DB, opt);
+        Customer a("Srv","A",30,"a@x","61616161","s","+100");
+        Customer b("Srv","B",30,"b@x","62626262","s","+200");
+        a.addAccount(Account(700001,"Checking",eur(50)));
+        b.addAccount(Account(700002,"Checking",eur(50)));
+        TASSERT(db.addOrUpdateCustomer(a));
+        TASSERT(db.addOrUpdateCustomer(b));
+
+        BankService svc(db);
+        BankService::Session sa, sb;
+        TASSERT(svc.handleLine("{\"op\":\"ping\",\"id\":3}", sa)=="{\"id\":3,\"ok\":true}");
+        TASSERT(svc.handleLine("not json", sa).find("Malformed")!=string::npos);
+        TASSERT(svc.handle({{"op","login"},{"customerId","61616161"},{"secret","s"}}, sa)["customer"]["accounts"][0]["balance"]=="50.00");
+        TASSERT(!svc.handle({{"op","login"},{"customerId","62626262"},{"secret","x"}}, sa).value("ok",true));
+        TASSERT(sa.customerId=="61616161");   // неудачный вход сессию не меняет
+        TASSERT(!svc.handle(json::parse("{\"op\":\"nope\"}"), sa).value("ok",true));
+        TASSERT(!svc.handle(json::parse("{\"op\":\"deposit\",\"accId\":\"x\"}"), sa).value("ok",true));
+        TASSERT(svc.handle({{"op","deposit"},{"accId",700001},{"amount","0.10"}}, sa)["balance"]=="50.10");
+        TASSERT(svc.handle({{"op","withdraw"},{"accId",700001},{"amountMinor",10}}, sa)["balance"]=="50.00");
+
+        // второе соединение: без входа ничего, кроме ping / login; после входа - только своё
+        json r = svc.handle({{"op","withdraw"},{"accId",700001},{"amount","50"}}, sb);
+        TASSERT(!r.value("ok",true) && r["error"]=="Not logged in.");
+        TASSERT(svc.handle({{"op","transfer"},{"fromAccId",700001},{"toAccId",700002},{"amount","50"}}, sb)["error"]=="Not logged in.");
+        TASSERT(svc.handle({{"op","findByName"},{"firstName","srv"},{"lastName","a"}}, sb)["error"]=="Not logged in.");
+        TASSERT(svc.handle({{"op","login"},{"customerId","62626262"},{"secret","s"}}, sb).value("ok",false));
+        TASSERT(svc.handle({{"op","withdraw"},{"accId",700001},{"amount","50"}}, sb)["error"]=="Access denied.");
+        TASSERT(svc.handle({{"op","transfer"},{"fromAccId",700001},{"toAccId",700002},{"amount","50"}}, sb)["error"]=="Access denied.");
+        TASSERT(svc.handle({{"op","history"},{"customerId","61616161"}}, sb)["error"]=="Access denied.");
+        TASSERT(svc.handle({{"op","customer"},{"customerId","61616161"}}, sb)["error"]=="Access denied.");
+        TASSERT(svc.handle({{"op","customer"}}, sb)["customer"]["customerId"]=="62626262");
+        TASSERT(db.getTransfersForCustomer("61616161",0).empty());
+        Money bal;
+        TASSERT(db.readBalance(700001, bal) && bal==eur(50));
+
+        // 400 переводов по 0.01 в обе стороны из 8 потоков (каждый от своей сессии)
+        std::atomic<int> ok{0}, failed{0};
+        {
+            ThreadPool pool(8);
+            for (int i = 0; i < 400; ++i) {
+                pool.submit([&, i]{
+                    json req = {{"op","transfer"},{"fromAccId", i % 2 ? 700001 : 700002},
+                                {"toAccId", i % 2 ? 700002 : 700001},{"amount","0.01"}};
+                    if (svc.handle(req, i % 2 ? sa : sb).value("ok",false)) ++ok; else ++failed;
+                });
+            }
+            pool.wait();
+        }
+        TASSERT(ok==400 && failed==0);
+
+        // недостаточно средств -> ошибка и "failed" в истории отправителя
+        r = svc.handle({{"op","transfer"},{"fromAccId",700001},{"toAccId",700002},{"amount","1000"}}, sa);
+        TASSERT(!r.value("ok",true) && r["error"]=="Insufficient funds.");
+        json h = svc.handle({{"op","history"},{"limit",1}}, sa);
+        TASSERT(h["items"][0]["status"]=="failed" && h.value("hasMore",false));
+        // отказ, который клиент выдал сам, тоже в истории - но только со своего счёта
+        TASSERT(svc.handle({{"op","logFailure"},{"fromAccId",700001},{"error","x"}}, sb)["error"]=="Access denied.");
+        TASSERT(svc.handle({{"op","logFailure"},{"fromAccId",700001},{"amountMinor",0},{"mode","by_name"},
+                            {"target","No Body"},{"error","Recipient not found."}}, sa).value("ok",false));
+        h = svc.handle({{"op","history"},{"limit",1}}, sa);
+        TASSERT(h["items"][0]["error"]=="Recipient not found." && h["items"][0]["target"]=="No Body");
+        // страницы по cursor: вместе - вся история отправителя, без повторов и пропусков
+        std::size_t seen = 0, cursor = 0, pages = 0;
+        for (;; ++pages) {
+            json p = svc.handle({{"op","history"},{"limit",150},{"cursor",cursor}}, sa);
+            seen += p["items"].size();
+            if (!p.value("hasMore",false)) break;
+            cursor = p["nextCursor"].get<std::size_t>();
+        }
+        TASSERT(pages==2 && seen==db.getTransfersForCustomer("61616161",0).size());
+        TASSERT(svc.handle({{"op","findByName"},{"firstName","srv"},{"lastName","b"}}, sa)["customerIds"][0]=="62626262");
+        TASSERT(db.commitCount() < 400);   // окна объединяют переводы
+    }
+    DatabaseManager reopened(TEST_DB, opt);
+    Customer back;
+    TASSERT(reopened.loadCustomer("61616161",back) && back.getAccounts()[0].getBalance()==eur(50));
+    TASSERT(reopened.loadCustomer("62626262",back) && back.getAccounts()[0].getBalance()==eur(50));
+    TASSERT(reopened.getTransfersForCustomer("62626262",0).size()==400);
+    TPASS();
+}
+
+// 26. Ledger: ошибки без изменений, версии и CAS, загрузка из БД, встречные переводы из потоков
+static void test_Ledger() {
+    Ledger L(8);
+    TASSERT(L.open(1, eur(100)) && L.open(2, eur(0)) && !L.open(1, eur(5)));
+    TASSERT(L.open(3, Money(1000, CurrencyCode('U','S','D'))));
+    std::string err;
+    TASSERT(!L.debit(1, eur(101), &err) && err=="Insufficient funds.");
+    TASSERT(!L.credit(9, eur(1), &err) && err=="Account not found.");
+    TASSERT(!L.transfer(1, 3, eur(1), &err) && err=="Currency mismatch.");
+    TASSERT(!L.transfer(1, 1, eur(1), &err));
+    Ledger::Balance b;
+    TASSERT(L.read(1, b) && b.amount==eur(100) && b.version==1);   // неудачи версию не трогают
+
+    TASSERT(L.transfer(1, 2, eur(30)));
+    TASSERT(L.read(1, b) && b.amount==eur(70) && b.version==2);
+    TASSERT(L.compareAndSet(1, 2, eur(75)));
+    TASSERT(!L.compareAndSet(1, 2, eur(80)));                       // версия уже 3
+    TASSERT(L.read(1, b) && b.amount==eur(75) && b.version==3);
+    TASSERT(L.close(3) && !L.contains(3) && L.size()==2);
+
+    // из БД: все счета; Customer обновляется из ledger
+    wipeDbArtifacts(TEST_DB);
+    {
+        DatabaseManager db(TEST_DB);
+        Customer c("Led","Ger",30,"l@x","71717171","s","+1");
+        c.addAccount(Account(710001,"Checking",eur(40)));
+        c.addAccount(Account(710002,"Savings",eur(60)));
+        TASSERT(db.addOrUpdateCustomer(c));
+
+        Ledger fromDb;
+        fromDb.reset(db.accountBalances());
+        TASSERT(fromDb.size()==2);
+        TASSERT(fromDb.transfer(710002, 710001, eur(10)));
+        Customer view;
+        TASSERT(db.loadCustomer("71717171", view));
+        fromDb.refresh(view);
+        TASSERT(view.getAccounts()[0].getBalance()==eur(50) && view.getAccounts()[1].getBalance()==eur(50));
+
+        // повторная загрузка: закрытый в БД счёт уходит, смена валюты не теряется
+        Customer fx("Led","Fx",30,"f@x","71717172","s","+2");
+        fx.addAccount(Account(710003, AccountType::FX, Money(500, CurrencyCode('U','S','D'))));
+        TASSERT(db.addOrUpdateCustomer(fx));
+        fromDb.reset(db.accountBalances());
+        TASSERT(fromDb.size()==3);
+        fx.getAccounts()[0] = Account(710003, AccountType::FX, Money(700, CurrencyCode('G','B','P')));
+        TASSERT(db.addOrUpdateCustomer(fx) && db.removeCustomer("71717171"));
+        fromDb.reset(db.accountBalances());
+        TASSERT(fromDb.size()==1 && !fromDb.contains(710001));
+        TASSERT(fromDb.read(710003, b) && b.amount==Money(700, CurrencyCode('G','B','P')));
+    }
+
+    // несколько ног: проверка по текущему остатку, всё или ничего
+    TASSERT(L.post({ {1, eur(50), true}, {2, eur(50), false}, {1, eur(20), true} }));
+    TASSERT(!L.post({ {2, eur(80), true}, {1, eur(10), false}, {2, eur(1), true} }, &err) && err=="Insufficient funds.");
+    TASSERT(L.read(1, b) && b.amount==eur(5) && L.read(2, b) && b.amount==eur(80));
+    std::vector<Money> after;
+    bool seen = false;
+    TASSERT(L.post({ {2, eur(30), true}, {1, eur(30), false} }, nullptr, [&]{ seen = true; }, &after));
+    TASSERT(seen && after.size()==2 && after[0]==eur(50) && after[1]==eur(35));
+
+    // 8 потоков, случайные переводы в обе стороны: сумма сохраняется, дедлоков нет
+    Ledger S(4);
+    const int N = 32;
+    for (int i = 0; i < N; ++i) TASSERT(S.open(1000 + i, eur(100)));
+    {
+        std::vector<std::thread> ts;
+        for (int t = 0; t < 8; ++t) {
+            ts.emplace_back([&S, t]{
+                unsigned x = 12345u + (unsigned)t;
+                for (int k = 0; k < 5000; ++k) {
+                    x = x * 1103515245u + 12345u;
+                    int from = 1000 + (int)((x >> 8) % N), to = 1000 + (int)((x >> 16) % N);
+                    if (from != to) S.transfer(from, to, Money(1 + (x >> 24) % 500, EUR));
+                }
+            });
+        }
+        for (auto& th : ts) th.join();
+    }
+    Money total = eur(0);
+    S.forEach([&](int, const Ledger::Balance& bal){ total = total + bal.amount; });
+    TASSERT(total==eur(100 * N));
+    TPASS();
+}
+
+// 27. Потоковая загрузка клиента: оба формата, CBOR, ранний выход, битый файл
+static void test_StreamLoadCustomer() {
+    wipeDbArtifacts(TEST_DB);
+    {
+        DatabaseManager db(TEST_DB);
+        Customer a("Str","Eam",41,"s@x","81818181","w","+7");
+        a.addAccount(Account(810001,"Checking",eur(12.34)));
+        Account sv(810002,"Savings",eur(100));
+        sv.setSavingsRate(0.2);
+        sv.setLastSavedDate("2026-01-02");
+        a.addAccount(sv);
+        Account fx(810003,"FX",0.0);
+        fx.setCurrency(CurrencyCode::fromString("JPY"));
+        fx.setBalance(Money(1500, CurrencyCode::fromString("JPY")));
+        a.addAccount(fx);
+        TASSERT(db.addOrUpdateCustomer(a));
+        TASSERT(db.addOrUpdateCustomer(Customer("Oth","Er",20,"o@x","82828282","w","+8")));
+        TASSERT(db.appendTransferLog({{"ts",1},{"status","ok"},{"fromCustomerId","81818181"}}));
+    }
+
+    Customer c;
+    std::string err;
+    TASSERT(streamLoadCustomer(TEST_DB, "81818181", c, &err));
+    TASSERT(c.getFirstName()=="Str" && c.getAge()==41 && c.getPhone()=="+7" && c.getAccounts().size()==3);
+    TASSERT(c.getAccounts()[0].getBalance()==eur(12.34));
+    TASSERT(c.getAccounts()[1].getSavingsRate()==0.2 && c.getAccounts()[1].getLastSavedDate()=="2026-01-02");
+    TASSERT(c.getAccounts()[2].getCurrency().view()=="JPY" && c.getAccounts()[2].getBalance().minorUnits()==1500);
+    TASSERT(!streamLoadCustomer(TEST_DB, "89898989", c, &err) && err=="Customer not found.");
+
+    // без резидентного образа loadCustomer идёт потоком и даёт то же самое
+    DatabaseOptions cold;
+    cold.resident = false;
+    {
+        DatabaseManager db(TEST_DB, cold);
+        Customer viaDb;
+        TASSERT(db.loadCustomer("81818181", viaDb) && viaDb.getAccounts().size()==3);
+        TASSERT(viaDb.getAccounts()[1].getBalance()==eur(100) && !db.loadCustomer("89898989", viaDb));
+    }
+
+    // CBOR: тот же документ, SAX по бинарному формату
+    {
+        json doc;
+        DatabaseManager(TEST_DB).loadAll(doc);
+        ofstream out(TEST_DB + ".cbor", ios::binary|ios::trunc);
+        const string bytes = encodeDocument(doc, FileFormat::Cbor);
+        out.write(bytes.data(), (streamsize)bytes.size());
+    }
+    TASSERT(streamLoadCustomer(TEST_DB + ".cbor", "82828282", c) && c.getEmail()=="o@x");
+    fs::remove(TEST_DB + ".cbor");
+
+    // старый формат: корень = map клиентов, только "name" и "balance"
+    {
+        ofstream out(TEST_DB, ios::trunc);
+        out << R"({"70000001":{"name":"  Old  Style Name ","age":60,"accounts":[{"accId":700011,"type":"Checking","balance":5.5,"extra":{"x":[1,2]}}]},
+                   "transfers":[{"ts":1}]})";
+    }
+    TASSERT(streamLoadCustomer(TEST_DB, "70000001", c));
+    TASSERT(c.getFirstName()=="Old" && c.getLastName()=="Name" && c.getAccounts()[0].getBalance()==eur(5.5));
+
+    // есть "customers" -> клиенты в корне не считаются (как normalizeDb)
+    { ofstream out(TEST_DB, ios::trunc); out << R"({"70000001":{"name":"Root"},"customers":{"70000001":{"firstName":"Inner","lastName":"X"}}})"; }
+    TASSERT(streamLoadCustomer(TEST_DB, "70000001", c) && c.getFirstName()=="Inner");
+
+    // ранний выход: мусор после нужного клиента не читается; до него -> ошибка
+    { ofstream out(TEST_DB, ios::trunc); out << R"({"customers":{"1":{"firstName":"A","lastName":"B"},"2":{"firstName":)" << "\x01garbage"; }
+    TASSERT(streamLoadCustomer(TEST_DB, "1", c) && c.getFirstName()=="A");
+    TASSERT(!streamLoadCustomer(TEST_DB, "2", c, &err) && err=="Cannot read database file.");
+    TASSERT(!streamLoadCustomer("data/no_such_file.json", "1", c));
+    TPASS();
+}
+
+// 28. Начисление процентов по всей БД: один проход, параллельно, одна запись
+static void test_SavingsAccrual() {
+    wipeDbArtifacts(TEST_DB);
+    DatabaseOptions opt;
+    opt.mode = StorageMode::WriteAheadLog;
+    {
+        DatabaseManager db(TEST_DB, opt);
+        Customer a("Acc","Rual",30,"a@x","91919191","s","+1");
+        Account s1(910001,"Savings",eur(1000));
+        s1.setSavingsRate(0.365);
+        s1.setLastSavedDate("2026-01-01");
+        a.addAccount(s1);
+        Account s2(910002,"Savings",eur(50));       // без даты -> только дата
+        a.addAccount(s2);
+        a.addAccount(Account(910003,"Savings",eur(50)));
+        a.addAccount(Account(910004,"Checking",eur(1000)));
+        TASSERT(db.addOrUpdateCustomer(a));
+
+        // нечитаемая дата в файле (не через Account) -> счёт не трогаем
+        json doc;
+        TASSERT(db.loadAll(doc));
+        doc["customers"]["91919191"]["accounts"][2]["lastSavedDate"] = "not a date";
+        TASSERT(db.saveAll(doc));
+
+        AccrualReport r;
+        TASSERT(!db.accrueSavingsInterest(Date(), r));
+        TASSERT(db.accrueSavingsInterest(Date::fromIso("2026-01-11"), r));
+        TASSERT(r.accounts==3 && r.credited==1 && r.dated==1 && r.totalInterest==eur(10));
+
+        // тот же день ещё раз: ничего не начисляется
+        TASSERT(db.accrueSavingsInterest(Date::fromIso("2026-01-11"), r) && r.credited==0 && r.totalInterest.isZero());
+    }
+    {
+        DatabaseManager db(TEST_DB, opt);
+        Customer back;
+        TASSERT(db.loadCustomer("91919191", back));
+        TASSERT(back.getAccounts()[0].getBalance()==eur(1010) && back.getAccounts()[0].getLastSavedDate()=="2026-01-11");
+        TASSERT(back.getAccounts()[1].getBalance()==eur(50) && back.getAccounts()[1].getLastSavedDate()=="2026-01-11");
+        TASSERT(back.getAccounts()[2].getLastSaved().empty() && back.getAccounts()[2].getBalance()==eur(50));
+        json doc;
+        TASSERT(db.loadAll(doc) && doc["customers"]["91919191"]["accounts"][2]["lastSavedDate"]=="not a date");
+        TASSERT(back.getAccounts()[3].getBalance()==eur(1000));
+
+        // load + save (как при входе) не стирает нечитаемую дату
+        back.getAccounts()[2].deposit(eur(1));
+        TASSERT(db.addOrUpdateCustomer(back));
+        back.setPhone("+2");
+        TASSERT(db.beginTransaction().putCustomer(back).commit());
+        TASSERT(db.loadAll(doc) && doc["customers"]["91919191"]["accounts"][2]["lastSavedDate"]=="not a date");
+        TASSERT(doc["customers"]["91919191"]["accounts"][2]["balanceMinor"]==5100);
+        AccrualReport r;
+        TASSERT(db.accrueSavingsInterest(Date::fromIso("2026-02-11"), r));
+        TASSERT(db.loadAll(doc) && doc["customers"]["91919191"]["accounts"][2]["lastSavedDate"]=="not a date");
+    }
+
+    // много счетов -> считается кусками в пуле; сумма = сумме по отдельным счетам
+    wipeDbArtifacts(TEST_DB);
+    {
+        DatabaseManager db(TEST_DB);
+        TASSERT(db.beginBatch());
+        std::int64_t expected = 0;
+        for (int i = 0; i < 20000; ++i) {
+            Customer c("Many","Savers",30,"m@x",to_string(20000000 + i),"s","+1");
+            for (int k = 0; k < 2; ++k) {
+                Account sv(300000 + i * 2 + k,"Savings",Money(1000 + i + k * 7, EUR));
+                sv.setSavingsRate(0.05 + (i % 10) * 0.01);
+                sv.setLastSavedDate("2026-06-01");
+                c.addAccount(sv);
+                expected += Money(1000 + i + k * 7, EUR).scaled(sv.getSavingsRate() * (30.0 / 365.0), RoundingMode::HalfEven).minorUnits();
+            }
+            TASSERT(db.addOrUpdateCustomer(c));
+        }
+        TASSERT(db.commitBatch());
+
+        AccrualReport r;
+        TASSERT(db.accrueSavingsInterest(Date::fromIso("2026-07-01"), r, 4));
+        TASSERT(r.accounts==40000 && r.totalInterest==Money(expected, EUR));
+    }
+
+    // меньше полцента в день: дата стоит, пока не наберётся цент; нулевой баланс датируется
+    wipeDbArtifacts(TEST_DB);
+    {
+        DatabaseManager db(TEST_DB);
+        Customer c("Small","Saver",30,"s@x","92929292","s","+1");
+        Account small(920001,"Savings",eur(10));
+        small.setSavingsRate(0.15);           // 0.41 цента в день
+        small.setLastSavedDate("2026-03-01");
+        c.addAccount(small);
+        Account empty(920002,"Savings",eur(0));
+        empty.setLastSavedDate("2026-03-01");
+        c.addAccount(empty);
+        TASSERT(db.addOrUpdateCustomer(c));
+
+        AccrualReport r;
+        TASSERT(db.accrueSavingsInterest(Date::fromIso("2026-03-02"), r) && r.credited==0);
+        Customer back;
+        TASSERT(db.loadCustomer("92929292", back));
+        TASSERT(back.getAccounts()[0].getLastSavedDate()=="2026-03-01" && back.getAccounts()[0].getBalance()==eur(10));
+        TASSERT(back.getAccounts()[1].getLastSavedDate()=="2026-03-02");
+
+        TASSERT(db.accrueSavingsInterest(Date::fromIso("2026-03-03"), r) && r.credited==1);   // 2 дня: 0.82 -> 1
+        TASSERT(db.loadCustomer("92929292", back));
+        TASSERT(back.getAccounts()[0].getLastSavedDate()=="2026-03-03" && back.getAccounts()[0].getBalance()==eur(10.01));
+    }
+
+    // один клиент при входе (приложение и сервер): то же правило, та же сумма
+    wipeDbArtifacts(TEST_DB);
+    {
+        DatabaseManager db(TEST_DB);
+        Customer c("Log","In",30,"l@x","93939393","s","+1");
+        Account sv(930001,"Savings",eur(1000));
+        sv.setSavingsRate(0.365);
+        sv.setLastSaved(Date::today() - 10);
+        c.addAccount(sv);
+        c.addAccount(Account(930002,"Savings",eur(50)));
+        TASSERT(db.addOrUpdateCustomer(c));
+        json doc;
+        TASSERT(db.loadAll(doc));
+        doc["customers"]["93939393"]["accounts"][1]["lastSavedDate"] = "not a date";
+        TASSERT(db.saveAll(doc));
+
+        TASSERT(!db.accrueCustomerInterest("00000000", Date::today()));
+        BankService svc(db);
+        BankService::Session s;
+        json r = svc.handle({{"op","login"},{"customerId","93939393"},{"secret","s"}}, s);
+        TASSERT(r["customer"]["accounts"][0]["balance"]=="1010.00");
+        Money credited;
+        TASSERT(db.accrueCustomerInterest("93939393", Date::today(), &credited) && credited.isZero());   // второй вход за день
+        Money bal;
+        TASSERT(db.readBalance(930001, bal) && bal==eur(1010));
+        TASSERT(db.loadAll(doc));
+        TASSERT(doc["customers"]["93939393"]["accounts"][0]["lastSavedDate"]==Date::today().iso());
+        TASSERT(doc["customers"]["93939393"]["accounts"][1]["lastSavedDate"]=="not a date");
+    }
+    TPASS();
+}
+
+// 29. Date: номер дня, ISO туда-обратно, границы месяцев/веков, DST не влияет
+static void test_Date() {
+    Date d;
+    TASSERT(Date().empty() && Date().iso().empty() && Date::fromIso("").empty());
+    TASSERT(Date::parse("1970-01-01", d) && d.dayNumber()==0 && d==Date::fromDays(0));
+    TASSERT(Date::fromIso("2026-03-30") - Date::fromIso("2026-03-28")==2);   // через переход на летнее время
+    TASSERT(Date::fromIso("2026-10-26") - Date::fromIso("2026-10-24")==2);
+    TASSERT(Date::parse("2024-02-29", d) && (d + 1).iso()=="2024-03-01");
+    TASSERT(Date::parse("2000-02-29", d) && !Date::parse("1900-02-29", d) && !Date::parse("2026-02-29", d));
+    TASSERT(!Date::parse("2026-1-01", d) && !Date::parse("2026-13-01", d) && !Date::parse("2026-04-31", d));
+    TASSERT(!Date::parse("2026/01/01", d) && !Date::parse("2026-01-01T00", d) && Date::fromIso("junk").empty());
+    TASSERT(Date::fromIso("1969-12-31").dayNumber()==-1 && (Date::fromIso("2026-12-31") + 1).iso()=="2027-01-01");
+
+    // все дни 1600..2400: civil -> номер -> civil и ISO без потерь, номера подряд
+    Date prev = Date::fromCivil(1599, 12, 31);
+    for (int y = 1600; y <= 2400; y += 1) {
+        for (unsigned m = 1; m <= 12; ++m) {
+            for (unsigned day = 1; day <= 31; ++day) {
+                char iso[11];
+                std::snprintf(iso, sizeof(iso), "%04d-%02u-%02u", y, m, day);
+                if (!Date::parse(iso, d)) { TASSERT(day >= 29); continue; }
+                TASSERT(d - prev==1 && d.iso()==iso);
+                int yy; unsigned mm, dd;
+                d.toCivil(yy, mm, dd);
+                TASSERT(yy==y && mm==m && dd==day);
+                prev = d;
+            }
+        }
+    }
+
+    // Account хранит Date; строка только на границе
+    Account s(1,"Savings",eur(100));
+    s.setLastSavedDate("2026-05-01");
+    TASSERT(s.getLastSaved()==Date::fromCivil(2026,5,1) && s.getLastSavedDate()=="2026-05-01");
+    s.setLastSavedDate("bogus");
+    TASSERT(s.getLastSaved().empty() && s.getLastSavedDate().empty());
+    TASSERT(!Date::today().empty() && Date::today().iso().size()==10);
+    TPASS();
+}
+
+// 30. Account как плоская запись: тип-enum, код валюты, строки только в JSON
+static void test_AccountRecord() {
+    static_assert(std::is_trivially_copyable_v<Account>);
+    TASSERT(sizeof(Account) <= 40);
+    for (AccountType t : { AccountType::Checking, AccountType::Savings, AccountType::FX })
+        TASSERT(accountTypeFromName(accountTypeName(t))==t);
+    TASSERT(accountTypeFromName("Premium")==AccountType::Unknown && Account().getType()==AccountType::Unknown);
+    TASSERT(Account(1,"Savings",eur(1)).getType()==AccountType::Savings);   // старый конструктор
+
+    wipeDbArtifacts(TEST_DB);
+    DatabaseManager db(TEST_DB);
+    Customer c("Rec","Ord",30,"r@x","31313131","s","+3");
+    c.addAccount(Account(310001, AccountType::Checking, eur(5)));
+    c.addAccount(Account(310002, AccountType::FX, Money(700, CurrencyCode('U','S','D'))));
+    TASSERT(db.addOrUpdateCustomer(c));
+
+    json doc;
+    TASSERT(db.loadAll(doc));
+    const json& accs = doc["customers"]["31313131"]["accounts"];
+    TASSERT(accs[0]["type"]=="Checking" && accs[1]["type"]=="FX" && accs[1]["currency"]=="USD");
+
+    Customer back;
+    TASSERT(db.loadCustomer("31313131", back));
+    TASSERT(back.getAccounts()[1].getType()==AccountType::FX && back.getAccounts()[1].getCurrency()==CurrencyCode('U','S','D'));
+    TASSERT(back.getAccounts()[1].getBalance().minorUnits()==700);
+
+    // незнакомый тип: в памяти Unknown, в файле остаётся как был
+    doc["customers"]["31313131"]["accounts"][0]["type"] = "Premium";
+    TASSERT(db.saveAll(doc));
+    TASSERT(db.loadCustomer("31313131", back) && back.getAccounts()[0].getType()==AccountType::Unknown);
+    back.setEmail("r2@x");
+    back.getAccounts()[0].deposit(eur(1));
+    TASSERT(db.addOrUpdateCustomer(back));
+    back.setPhone("+4");
+    TASSERT(db.beginTransaction().putCustomer(back).commit());
+    TASSERT(db.loadAll(doc));
+    TASSERT(doc["customers"]["31313131"]["accounts"][0]["type"]=="Premium");
+    TASSERT(doc["customers"]["31313131"]["accounts"][0]["balanceMinor"]==600);
+
+    // нечитаемая валюта FX: в памяти пустой код, в файле остаётся как была
+    doc["customers"]["31313131"]["accounts"][1]["currency"] = "US$";
+    TASSERT(db.saveAll(doc));
+    TASSERT(db.loadCustomer("31313131", back) && back.getAccounts()[1].getCurrency().empty());
+    back.setEmail("r3@x");
+    TASSERT(db.addOrUpdateCustomer(back));
+    back.setPhone("+5");
+    TASSERT(db.beginTransaction().putCustomer(back).commit());
+    TASSERT(db.loadAll(doc) && doc["customers"]["31313131"]["accounts"][1]["currency"]=="US$");
+    TASSERT(doc["customers"]["31313131"]["accounts"][1]["balanceMinor"]==700);
+    TPASS();
+}
+
+// 31. Customer: геттеры без копий, полное имя кэшируется и обновляется сеттерами
+static void test_CustomerAccessors() {
+    Customer c("Ann","Lee",30,"a@x","41414141","s","+4");
+    TASSERT(c.getFullName()=="Ann Lee");
+    TASSERT(&c.getFullName()==&c.getFullName() && &c.getId()==&c.getId());   // ссылки, не копии
+
+    c.setLastName("");
+    TASSERT(c.getFullName()=="Ann");
+    c.setFirstName("");
+    c.setLastName("Solo");
+    TASSERT(c.getFullName()=="Solo");
+    c.setFirstName(std::string(64, 'x'));   // временная строка переезжает без копии
+    TASSERT(c.getFullName()==std::string(64, 'x') + " Solo" && Customer().getFullName().empty());
+
+    std::string phone = "+1234567";
+    c.setPhone(std::move(phone));
+    TASSERT(c.getPhone()=="+1234567");
+
+    Customer copy = c;   // кэш копируется вместе с именем
+    copy.setFirstName("Z");
+    TASSERT(copy.getFullName()=="Z Solo" && c.getFullName()!=copy.getFullName());
+    TPASS();
+}
+
+// 32. Profiler: с -DBANKING_PROFILER=1 — кольцо сэмплов и счётчики I/O; без него макросы пустые
+static void test_Profiler() {
+#if BANKING_PROFILER
+    std::vector<prof::Sample> buf(1024);
+    while (prof::drain(buf.data(), buf.size()) > 0) {}   // сэмплы предыдущих тестов
+    const prof::Counters before = prof::counters();
+
+    { PROF_SCOPE("test.scope"); }
+    PROF_BYTES_READ(100);
+    PROF_BYTES_WRITTEN(7);
+    PROF_JSON_PARSE();
+    TASSERT(prof::drain(buf.data(), buf.size())==1 && std::strcmp(buf[0].name, "test.scope")==0);
+    const prof::Counters after = prof::counters();
+    TASSERT(after.bytesRead-before.bytesRead==100 && after.bytesWritten-before.bytesWritten==7);
+    TASSERT(after.jsonParses-before.jsonParses==1);
+
+    // 4 писателя против одного читателя: каждый сэмпл либо прочитан целым, либо учтён как потерянный
+    const int PER_THREAD = 20000;
+    std::atomic<bool> done{false};
+    std::vector<std::thread> producers;
+    for (int t = 0; t < 4; ++t)
+        producers.emplace_back([&]{ for (int i = 0; i < PER_THREAD; ++i) prof::record("test.mt", 1, 2); });
+    std::size_t got = 0;
+    auto take = [&](std::size_t n) {
+        for (std::size_t i = 0; i < n; ++i)
+            TASSERT(std::strcmp(buf[i].name, "test.mt")==0 && buf[i].startNs==1 && buf[i].durNs==2);
+        got += n;
+    };
+    std::thread consumer([&]{ while (!done) take(prof::drain(buf.data(), buf.size())); });
+    for (auto& p : producers) p.join();
+    done = true;
+    consumer.join();
+    while (std::size_t n = prof::drain(buf.data(), buf.size())) take(n);
+    TASSERT(got + (prof::counters().dropped - after.dropped) == 4u * PER_THREAD);
+#else
+    // выключен: макросы разворачиваются в ((void)0), аргументы не вычисляются
+    int evaluated = 0;
+    PROF_SCOPE("test.scope");
+    PROF_BYTES_READ(++evaluated);
+    PROF_BYTES_WRITTEN(++evaluated);
+    PROF_JSON_PARSE();
+    TASSERT(evaluated==0);
+#endif
+    TPASS();
+}
+
+// 33. Sharded: каталог вместо файла, правка клиента переписывает один шард, лог сегментами
+static void test_ShardedStorage() {
+    const string dir = "data/test_sharded";
+    const string copy = "data/test_sharded_copy";
+    fs::remove_all(dir);
+    fs::remove_all(copy);
+    auto manifest = [&]{ ifstream in(dir + "/manifest.json"); return json::parse(in); };
+
+    DatabaseOptions opt;
+    opt.mode = StorageMode::Sharded;
+    opt.shardCount = 8;
+    opt.transferSegmentBytes = 256;   // пара записей на сегмент
+    {
+        DatabaseManager db(dir, opt);
+        TASSERT(ShardedStore::isStore(dir));
+        for (int i = 0; i < 20; ++i) {
+            Customer c("Sh","N" + to_string(i),30,"s@x",to_string(50000000 + i),"s");
+            c.addAccount(Account(db.generateUniqueAccountId(),"Checking",eur(100)));
+            TASSERT(db.addOrUpdateCustomer(c));
+        }
+        for (int i = 0; i < 10; ++i)
+            TASSERT(db.appendTransferLog(json{{"status","ok"},{"fromCustomerId","50000000"},{"toCustomerId","50000001"},{"n",i}}));
+    }
+    json m = manifest();
+    TASSERT(m["shards"].size()==8);
+    TASSERT(m["transfers"].size() > 1);   // сегменты покатились
+
+    opt.shardCount = 3;   // у существующего каталога своё число шардов
+    {
+        DatabaseManager db(dir, opt);
+        json all;
+        TASSERT(db.loadAll(all));
+        TASSERT(all["customers"].size()==20);
+        TASSERT(all["transfers"].size()==10);
+        TASSERT(all["transfers"][9]["n"]==9);
+        TASSERT(manifest()["shards"].size()==8);
+
+        // один клиент -> один новый файл шарда, старый удалён
+        const json before = manifest()["shards"];
+        const uint64_t seq = manifest()["commitSeq"];
+        Customer c;
+        TASSERT(db.loadCustomer("50000007", c));
+        c.setEmail("new@x");
+        TASSERT(db.addOrUpdateCustomer(c));
+        const json after = manifest()["shards"];
+        const size_t s = ShardedStore(dir, 8).shardOf("50000007");
+        for (size_t k = 0; k < 8; ++k) TASSERT((before[k]!=after[k]) == (k==s));
+        TASSERT(!fs::exists(dir + "/" + before[s].get<string>()));
+        TASSERT(manifest()["commitSeq"]==seq + 1);
+
+        // батч: несколько клиентов, одна фиксация
+        TASSERT(db.beginBatch());
+        TASSERT(db.removeCustomer("50000001"));
+        TASSERT(db.removeCustomer("50000002"));
+        TASSERT(db.commitBatch());
+        TASSERT(manifest()["commitSeq"]==seq + 2);
+    }
+
+    // оборванный коммит: хвост сегмента и шард без манифеста не видны, следующий коммит их убирает
+    const string lastSeg = dir + "/" + manifest()["transfers"].back()["file"].get<string>();
+    { ofstream(lastSeg, ios::binary | ios::app) << "{\"status\":\"torn\"\n"; }
+    { ofstream(dir + "/customers/0000-999.json") << "{\"customers\":{\"59999999\":{}}}"; }
+    {
+        DatabaseManager db(dir, opt);
+        TASSERT(!db.customerExists("59999999"));
+        TASSERT(!db.customerExists("50000001"));
+        TASSERT(db.getTransfersForCustomer("50000000",0).size()==10);
+        TASSERT(db.appendTransferLog(json{{"status","ok"},{"fromCustomerId","50000000"},{"toCustomerId","50000003"}}));
+        TASSERT(!fs::exists(dir + "/customers/0000-999.json"));
+    }
+    {
+        DatabaseManager db(dir, opt);
+        TASSERT(db.getTransfersForCustomer("50000000",0).size()==11);
+        TASSERT(db.customerExists("50000007"));
+    }
+
+    // миграция: файл -> каталог -> файл, содержимое то же
+    wipeDbArtifacts(TEST_DB);
+    json orig;
+    {
+        DatabaseManager src(dir, opt);
+        TASSERT(src.loadAll(orig));
+        DatabaseManager file(TEST_DB);
+        TASSERT(file.saveAll(orig));
+    }
+    {
+        json fromFile, back;
+        DatabaseManager file(TEST_DB);
+        TASSERT(file.loadAll(fromFile));
+        opt.shardCount = 4;
+        DatabaseManager sharded(copy, opt);
+        TASSERT(sharded.saveAll(fromFile));
+        DatabaseManager reopened(copy, opt);
+        TASSERT(reopened.loadAll(back));
+        TASSERT(back==orig);
+        TASSERT(fromFile==orig);
+    }
+
+    // файлы шардов без манифеста: не затираем
+    fs::remove(copy + "/manifest.json");
+    {
+        ShardedStore store(copy);
+        json root;
+        string err;
+        TASSERT(!store.load(root, &err));
+        TASSERT(err=="Shard files without a manifest.");
+    }
+
+    fs::remove_all(dir);
+    fs::remove_all(copy);
+    TPASS();
+}
+
+// 34. FileSync: запись с fsync (перезапись / дозапись), fsync каталога
+static void test_FileSync() {
+    const string path = "data/test_sync.txt";
+    fs::remove(path);
+    auto readAll = [&]{ ifstream in(path, ios::binary); return string((istreambuf_iterator<char>(in)), istreambuf_iterator<char>()); };
+
+    TASSERT(writeFileSynced(path, "a\n", true));    // дозапись создаёт файл
+    TASSERT(writeFileSynced(path, "b\n", true));
+    TASSERT(readAll()=="a\nb\n");
+    TASSERT(writeFileSynced(path, "c\n", false));
+    TASSERT(readAll()=="c\n");
+    TASSERT(parentDirOf(path)=="data" && parentDirOf("x.json").empty());
+    TASSERT(syncDir("data") && syncDir(""));
+    TASSERT(!syncDir("data/no_such_dir"));
+    TASSERT(!writeFileSynced("data/no_such_dir/x", "x", false));
+    fs::remove(path);
+    TPASS();
+}
+
+// 35. Ledger в DatabaseManager: деньги идут через полосы ledger, образ и журнал догоняют
+static void test_LedgerBackedDatabase() {
+    wipeDbArtifacts(TEST_DB);
+    DatabaseOptions opt;
+    opt.mode = StorageMode::WriteAheadLog;
+    opt.commitWindowMs = 2;
+    const int N = 16;
+    {
+        DatabaseManager db(TEST_DB, opt);
+        for (int i = 0; i < N; ++i) {
+            Customer c("Led","Db" + std::to_string(i),30,"l@x",std::to_string(72720000 + i),"s","+1");
+            c.addAccount(Account(720000 + i,"Checking",eur(100)));
+            TASSERT(db.addOrUpdateCustomer(c));
+        }
+        Money bal;
+        std::string err;
+        TASSERT(db.deposit(720000, eur(5), &err, &bal) && bal==eur(105));
+        TASSERT(db.withdraw(720000, eur(5), &err, &bal) && bal==eur(100));
+        TASSERT(!db.withdraw(720001, eur(101), &err) && err=="Insufficient funds.");
+        TASSERT(!db.deposit(729999, eur(1), &err) && err=="Account not found.");
+        TASSERT(!db.deposit(720001, Money(1, CurrencyCode('U','S','D')), &err) && err=="Currency mismatch.");
+        TASSERT(db.readBalance(720001, bal) && bal==eur(100));
+
+        // 8 потоков: переводы, пополнения и списания вперемешку
+        std::atomic<long long> net{0};
+        {
+            std::vector<std::thread> ts;
+            for (int t = 0; t < 8; ++t) {
+                ts.emplace_back([&, t]{
+                    unsigned x = 777u + (unsigned)t;
+                    for (int k = 0; k < 150; ++k) {
+                        x = x * 1103515245u + 12345u;
+                        const int from = 720000 + (int)((x >> 8) % N);
+                        const int to = 720000 + (int)((x >> 16) % N);
+                        const Money m(1 + (x >> 24) % 300, EUR);
+                        if (k % 3 == 0 && db.deposit(from, m)) net += m.minorUnits();
+                        else if (k % 3 == 1 && db.withdraw(from, m)) net -= m.minorUnits();
+                        else if (from != to) db.transfer(from, to, m);
+                    }
+                });
+            }
+            for (auto& th : ts) th.join();
+        }
+        TASSERT(db.durable().get());
+
+        // ledger и образ совпадают; Customer - вид на ledger
+        long long sum = 0;
+        for (const auto& [accId, m] : db.accountBalances()) {
+            TASSERT(db.readBalance(accId, bal) && bal==m);
+            sum += m.minorUnits();
+        }
+        TASSERT(sum == 100LL * 100 * N + net);
+        Customer view;
+        TASSERT(db.loadCustomer("72720003", view) && db.readBalance(720003, bal) && view.getAccounts()[0].getBalance()==bal);
+
+        // транзакция из одних денег - тоже через ledger; запись клиента целиком - по разнице
+        TASSERT(db.beginTransaction().debit(720003, bal).credit(720004, bal).log({{"mode","test"},{"fromAccId",720003},{"toAccId",720004}}).commit(&err));
+        TASSERT(db.readBalance(720003, bal) && bal.isZero());
+        view.getAccounts()[0].setBalance(eur(7));
+        TASSERT(db.addOrUpdateCustomer(view) && db.readBalance(720003, bal) && bal==eur(7));
+        TASSERT(db.removeCustomer("72720005") && !db.readBalance(720005, bal));
+        TASSERT(!db.transfer(720005, 720006, eur(1), json::object(), &err) && err=="Account not found.");
+    }
+    // после перезапуска (журнал) - те же балансы; в логе есть id клиентов
+    DatabaseManager reopened(TEST_DB, opt);
+    Money bal;
+    TASSERT(reopened.readBalance(720003, bal) && bal==eur(7));
+    TASSERT(!reopened.readBalance(720005, bal));
+    auto hist = reopened.getTransfersForCustomer("72720004", 0);
+    auto tx = std::find_if(hist.begin(), hist.end(), [](const json& e){ return e.value("mode","")=="test"; });
+    TASSERT(tx != hist.end() && tx->value("fromCustomerId","")=="72720003" && tx->value("toCustomerId","")=="72720004");
+    TPASS();
+}
+
 int main() {
     cout<<"=== BankingSystem TESTS START ===\n";
     test_CreateAndLoadCustomer();
@@ -267,6 +1607,30 @@ int main() {
     test_ResetPassword();
     test_BackupAndNoEmptyOverwrite();
     test_CorruptedJsonGraceful();
+    test_ResidentImageDetectsOutsideChanges();
+    test_WalRecoveryAndCheckpoint();
+    test_FindAccountOwner();
+    test_QueryTransfersPaged();
+    test_MoneyArithmeticAndCompat();
+    test_RateServiceFileSource();
+    test_BinarySnapshotRoundTrip();
+    test_BatchProcessor();
+    test_NameIndex();
+    test_AccountIdAllocator();
+    test_BinaryEncodings();
+    test_GroupCommit();
+    test_Transactions();
+    test_BankService();
+    test_Ledger();
+    test_StreamLoadCustomer();
+    test_SavingsAccrual();
+    test_Date();
+    test_AccountRecord();
+    test_CustomerAccessors();
+    test_Profiler();
+    test_ShardedStorage();
+    test_FileSync();
+    test_LedgerBackedDatabase();
     cout<<"=== ALL TESTS PASSED ===\n";
     wipeDbArtifacts(TEST_DB);
     return 0;